@@ -25,10 +25,25 @@
 
 
 #include "LuaVectorLib.h"
+#include "PTVectorArrays.h"
+#include "PTVectorKDTree.h"
+#include "PTVectorPolygon.h"
+#include "PTVectorRotation.h"
+#include "PTVectorSpline.h"
+#include <algorithm>
+#include <cassert>
 #include <cstdio>
+#include <limits>
+#include <new>
+#include <stdexcept>
 
 const char vector2Meta[] = "planevector";
 const char vector3Meta[] = "navvector";
+const char vector3ArrayMeta[] = "navvectorarray";
+const char vectorViewMeta[] = "vectorview";
+const char vector3KDTreeMeta[] = "navvectorkdtree";
+const char vector3SplineMeta[] = "navvectorspline";
+const char vector2PolygonMeta[] = "planevectorpolygon";
 
 enum VectorType
 {
@@ -89,6 +104,74 @@ PVector luaCheckPVector(lua_State *L, int arg)
  return *pv;
 }
 
+// Mutable access to the vector stored in the userdata, for the in-place operations
+TVector& luaCheckTVectorRef(lua_State *L, int arg)
+{
+ return *(TVector*)luaL_checkudata(L, arg, vector3Meta);
+}
+
+PVector& luaCheckPVectorRef(lua_State *L, int arg)
+{
+ return *(PVector*)luaL_checkudata(L, arg, vector2Meta);
+}
+
+static LuaVectorView* luaPushVectorView(lua_State *L, void *data, std::size_t n, bool isTVector, bool readOnly)
+{
+ LuaVectorView *view = (LuaVectorView*)lua_newuserdata(L, sizeof(LuaVectorView));
+ luaL_getmetatable(L, vectorViewMeta);
+ lua_setmetatable(L, -2);
+ view->data = data;
+ view->size = n;
+ view->isTVector = isTVector;
+ view->readOnly = readOnly;
+ // anchored in the registry until released, so the handle stays valid
+ lua_pushvalue(L, -1);
+ view->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+ return view;
+}
+
+LuaVectorView* luaPushTVectorView(lua_State *L, TVector *data, std::size_t n)
+{
+ return luaPushVectorView(L, data, n, true, false);
+}
+
+LuaVectorView* luaPushPVectorView(lua_State *L, PVector *data, std::size_t n)
+{
+ return luaPushVectorView(L, data, n, false, false);
+}
+
+LuaVectorView* luaPushTVectorView(lua_State *L, const TVector *data, std::size_t n)
+{
+ return luaPushVectorView(L, const_cast<TVector*>(data), n, true, true);
+}
+
+LuaVectorView* luaPushPVectorView(lua_State *L, const PVector *data, std::size_t n)
+{
+ return luaPushVectorView(L, const_cast<PVector*>(data), n, false, true);
+}
+
+void luaUpdateVectorView(LuaVectorView *view, TVector *data, std::size_t n)
+{
+ assert(view->isTVector && view->ref != LUA_NOREF);
+ view->data = data;
+ view->size = n;
+}
+
+void luaUpdateVectorView(LuaVectorView *view, PVector *data, std::size_t n)
+{
+ assert(!view->isTVector && view->ref != LUA_NOREF);
+ view->data = data;
+ view->size = n;
+}
+
+void luaReleaseVectorView(lua_State *L, LuaVectorView *view)
+{
+ view->data = nullptr;
+ view->size = 0;
+ luaL_unref(L, LUA_REGISTRYINDEX, view->ref);
+ view->ref = LUA_NOREF;
+}
+
 int luaGetArgumentType(lua_State *L, int arg)
 {
  int nType;
@@ -132,6 +215,113 @@ int luaGetArgument(lua_State *L, int arg, lua_Number &number, TVector &nv, PVect
  return 0;
 }
 
+// The library functions below are all registered with the metatables as
+// upvalues, so they can push and check vectors by comparing against those
+// rather than looking the metatables up in the registry by name each time.
+// The public luaPushNew/luaCheck functions above stay for use from outside.
+#define navVectorMetaIndex lua_upvalueindex(1)
+#define planeVectorMetaIndex lua_upvalueindex(2)
+#define navVectorArrayMetaIndex lua_upvalueindex(3)
+#define vectorViewMetaIndex lua_upvalueindex(4)
+#define navVectorKDTreeMetaIndex lua_upvalueindex(5)
+#define navVectorSplineMetaIndex lua_upvalueindex(6)
+#define planeVectorPolygonMetaIndex lua_upvalueindex(7)
+
+// The type of argument arg from a single metatable fetch, or -1 if it isn't a vector or number
+static int vectorTypeOf(lua_State *L, int arg)
+{
+ if (lua_type(L, arg) != LUA_TUSERDATA)
+ {
+  int isNum;
+  lua_tonumberx(L, arg, &isNum);
+  return isNum ? NumberType : -1;
+ }
+ if (!lua_getmetatable(L, arg)) return -1;
+ int type = -1;
+ if (lua_rawequal(L, -1, navVectorMetaIndex)) type = TVectorType;
+ else if (lua_rawequal(L, -1, planeVectorMetaIndex)) type = PVectorType;
+ lua_pop(L, 1);
+ return type;
+}
+
+// Whether arg is a userdata with the metatable at metaIndex
+static bool hasMetatable(lua_State *L, int arg, int metaIndex)
+{
+ if (lua_type(L, arg) != LUA_TUSERDATA || !lua_getmetatable(L, arg)) return false;
+ bool result = lua_rawequal(L, -1, metaIndex);
+ lua_pop(L, 1);
+ return result;
+}
+
+static TVector& checkTVector(lua_State *L, int arg)
+{
+ if (vectorTypeOf(L, arg) != TVectorType) luaL_checkudata(L, arg, vector3Meta); // raises the usual error
+ return *(TVector*)lua_touserdata(L, arg);
+}
+
+static PVector& checkPVector(lua_State *L, int arg)
+{
+ if (vectorTypeOf(L, arg) != PVectorType) luaL_checkudata(L, arg, vector2Meta);
+ return *(PVector*)lua_touserdata(L, arg);
+}
+
+static void pushTVector(lua_State *L, const TVector &nv)
+{
+ TVector *v = (TVector*)lua_newuserdata(L, sizeof(TVector));
+ lua_pushvalue(L, navVectorMetaIndex);
+ lua_setmetatable(L, -2);
+ *v = nv;
+}
+
+static void pushPVector(lua_State *L, const PVector &pv)
+{
+ PVector *v = (PVector*)lua_newuserdata(L, sizeof(PVector));
+ lua_pushvalue(L, planeVectorMetaIndex);
+ lua_setmetatable(L, -2);
+ *v = pv;
+}
+
+static int argumentType(lua_State *L, int arg)
+{
+ int type = vectorTypeOf(L, arg);
+ if (type < 0) luaL_argerror(L, arg, "Expected 'vector' type");
+ return type;
+}
+
+static int getArgument(lua_State *L, int arg, lua_Number &number, TVector &nv, PVector &pv)
+{
+ int type = vectorTypeOf(L, arg);
+ if (type == NumberType) number = lua_tonumber(L, arg);
+ else if (type == TVectorType) nv = *(TVector*)lua_touserdata(L, arg);
+ else if (type == PVectorType) pv = *(PVector*)lua_touserdata(L, arg);
+ else luaL_argerror(L, arg, "'Vector' expected");
+ return type;
+}
+
+// Results go into the destination vector at dstArg if the caller gave one,
+// otherwise into a new vector. Either way the result is left on the stack.
+static void luaReturnTVector(lua_State *L, int dstArg, const TVector &nv)
+{
+ if (lua_isnoneornil(L, dstArg))
+ {
+  pushTVector(L, nv);
+  return;
+ }
+ checkTVector(L, dstArg) = nv;
+ lua_pushvalue(L, dstArg);
+}
+
+static void luaReturnPVector(lua_State *L, int dstArg, const PVector &pv)
+{
+ if (lua_isnoneornil(L, dstArg))
+ {
+  pushPVector(L, pv);
+  return;
+ }
+ checkPVector(L, dstArg) = pv;
+ lua_pushvalue(L, dstArg);
+}
+
 static int newVector(lua_State *L)
 {
  // check number of parameters and determine what kind of vector we're building
@@ -152,27 +342,27 @@ static int newVector(lua_State *L)
    // For one argument, we check the argument type
    // If number, create unit plane vector to angle in radians from x-axis
    // otherwise, if tvector or pvector, make a copy of the vector
-   type = luaGetArgument(L, 1, num, nv, pv);
+   type = getArgument(L, 1, num, nv, pv);
    if (type == NumberType)
    {
     pv = unitVectorAtAngle(num);
-    luaPushNewPVector(L, pv);
+    pushPVector(L, pv);
    }
-   else if (type == TVectorType) luaPushNewTVector(L, nv);
-   else luaPushNewPVector(L, pv);
+   else if (type == TVectorType) pushTVector(L, nv);
+   else pushPVector(L, pv);
   break;
 
   case 2:
    pv.u = luaL_checknumber(L, 1);
    pv.v = luaL_checknumber(L, 2);
-   luaPushNewPVector(L, pv);
+   pushPVector(L, pv);
   break;
 
   case 3:
    nv.xEast = luaL_checknumber(L, 1);
    nv.yNorth = luaL_checknumber(L, 2);
    nv.zUp = luaL_checknumber(L, 3);
-   luaPushNewTVector(L, nv);
+   pushTVector(L, nv);
   break;
  }
 
@@ -181,74 +371,74 @@ static int newVector(lua_State *L)
 
 static int negateTVector(lua_State *L)
 {
- luaPushNewTVector(L, -luaCheckTVector(L, 1));
+ pushTVector(L, -checkTVector(L, 1));
  return 1;
 }
 
 static int negatePVector(lua_State *L)
 {
- luaPushNewPVector(L, -luaCheckPVector(L, 1));
+ pushPVector(L, -checkPVector(L, 1));
  return 1;
 }
 
 static int addTVectors(lua_State *L)
 {
- luaPushNewTVector(L, luaCheckTVector(L, 1) + luaCheckTVector(L, 2));
+ luaReturnTVector(L, 3, checkTVector(L, 1) + checkTVector(L, 2));
  return 1;
 }
 
 static int addPVectors(lua_State *L)
 {
- luaPushNewPVector(L, luaCheckPVector(L, 1) + luaCheckPVector(L, 2));
+ luaReturnPVector(L, 3, checkPVector(L, 1) + checkPVector(L, 2));
  return 1;
 }
 
 static int subTVectors(lua_State *L)
 {
- luaPushNewTVector(L, luaCheckTVector(L, 1) - luaCheckTVector(L, 2));
+ luaReturnTVector(L, 3, checkTVector(L, 1) - checkTVector(L, 2));
  return 1;
 }
 
 static int subPVectors(lua_State *L)
 {
- luaPushNewPVector(L, luaCheckPVector(L, 1) - luaCheckPVector(L, 2));
+ luaReturnPVector(L, 3, checkPVector(L, 1) - checkPVector(L, 2));
  return 1;
 }
 
 static int scaleTVector(lua_State *L)
 {
- luaPushNewTVector(L, luaCheckTVector(L, 1) * luaL_checknumber(L, 2));
+ pushTVector(L, checkTVector(L, 1) * luaL_checknumber(L, 2));
  return 1;
 }
 
 static int scalePVector(lua_State *L)
 {
- luaPushNewPVector(L, luaCheckPVector(L, 1) * luaL_checknumber(L, 2));
+ pushPVector(L, checkPVector(L, 1) * luaL_checknumber(L, 2));
  return 1;
 }
 
 static int navVectorCrossProduct(lua_State *L)
 {
- luaPushNewTVector(L, luaCheckTVector(L, 1) / luaCheckTVector(L, 2));
+ luaReturnTVector(L, 3, checkTVector(L, 1) / checkTVector(L, 2));
  return 1;
 }
 
 static int navVectorDotProduct(lua_State *L)
 {
- lua_pushnumber(L, luaCheckTVector(L, 1) * luaCheckTVector(L, 2));
+ lua_pushnumber(L, checkTVector(L, 1) * checkTVector(L, 2));
  return 1;
 }
 
 static int planeVectorDotProduct(lua_State *L)
 {
- lua_pushnumber(L, luaCheckPVector(L, 1) * luaCheckPVector(L, 2));
+ lua_pushnumber(L, checkPVector(L, 1) * checkPVector(L, 2));
  return 1;
 }
 
 static int vectorMultiplyOperation(lua_State *L)
 {
- int arg1Type = luaGetArgumentType(L, 1);
- int arg2Type = luaGetArgumentType(L, 2);
+ int arg1Type = argumentType(L, 1);
+ int arg2Type = argumentType(L, 2);
 
  if (arg1Type == TVectorType && arg2Type == TVectorType) return navVectorDotProduct(L);
  if (arg1Type == PVectorType && arg2Type == PVectorType) return planeVectorDotProduct(L);
@@ -270,7 +460,7 @@ static int vectorLength(lua_State *L)
  lua_Number arg1number;
  TVector arg1NV;
  PVector arg1PV;
- int arg1Type = luaGetArgument(L, 1, arg1number, arg1NV, arg1PV);
+ int arg1Type = getArgument(L, 1, arg1number, arg1NV, arg1PV);
  luaL_argcheck(L, arg1Type != NumberType, 1, "'Vector' expected");
 
  if (arg1Type == TVectorType) lua_pushnumber(L, abs(arg1NV));
@@ -284,10 +474,10 @@ static int calcUnitVector(lua_State *L)
  lua_Number num;
  TVector nv;
  PVector pv;
- int argType = luaGetArgument(L, 1, num, nv, pv);
+ int argType = getArgument(L, 1, num, nv, pv);
  luaL_argcheck(L, argType != NumberType, 1, "'Vector' expected");
- if (argType == TVectorType) luaPushNewTVector(L, unitVector(nv));
- else luaPushNewPVector(L, unitVector(pv));
+ if (argType == TVectorType) pushTVector(L, unitVector(nv));
+ else pushPVector(L, unitVector(pv));
 
  return 1;
 }
@@ -297,12 +487,12 @@ static int vectorRotate(lua_State *L)
  lua_Number num;
  TVector nv;
  PVector pv;
- int argType = luaGetArgument(L, 1, num, nv, pv);
+ int argType = getArgument(L, 1, num, nv, pv);
  luaL_argcheck(L, argType != NumberType, 1, "'Vector' expected");
 
  if (argType == TVectorType)
-  luaPushNewTVector(L, rotateTVectorAboutAxis(nv, luaCheckTVector(L, 2), luaL_checknumber(L, 3)));
- else luaPushNewPVector(L, rotatePVectorAboutOrigin(pv, luaL_checknumber(L, 2)));
+  luaReturnTVector(L, 4, rotateTVectorAboutAxis(nv, checkTVector(L, 2), luaL_checknumber(L, 3)));
+ else luaReturnPVector(L, 3, rotatePVectorAboutOrigin(pv, luaL_checknumber(L, 2)));
 
  return 1;
 }
@@ -312,180 +502,1308 @@ static int vectorLERP(lua_State *L)
  lua_Number num1, num2;
  TVector nv1, nv2;
  PVector pv1, pv2;
- int arg1Type = luaGetArgument(L, 1, num1, nv1, pv1);
- int arg2Type = luaGetArgument(L, 2, num2, nv2, pv2);
+ int arg1Type = getArgument(L, 1, num1, nv1, pv1);
+ int arg2Type = getArgument(L, 2, num2, nv2, pv2);
  luaL_argcheck(L, arg1Type != NumberType, 1, "'Vector' expected");
  luaL_argcheck(L, arg2Type != NumberType, 2, "'Vector' expected");
  luaL_argcheck(L, arg1Type == arg2Type, 2, "Vector type mismatch");
 
  lua_Number lerp = luaL_checknumber(L, 3);
- if (arg1Type == TVectorType) luaPushNewTVector(L, LERP(nv1, nv2, lerp));
- else luaPushNewPVector(L, LERP(pv1, pv2, lerp));
+ if (arg1Type == TVectorType) luaReturnTVector(L, 4, LERP(nv1, nv2, lerp));
+ else luaReturnPVector(L, 4, LERP(pv1, pv2, lerp));
 
  return 1;
 }
 
 static int navVectorSLERP(lua_State *L)
 {
- TVector nv1 = luaCheckTVector(L, 1);
- TVector nv2 = luaCheckTVector(L, 2);
+ TVector nv1 = checkTVector(L, 1);
+ TVector nv2 = checkTVector(L, 2);
  lua_Number slerp = luaL_checknumber(L, 3);
- luaPushNewTVector(L, TVectorSLERP(nv1, nv2, slerp));
+ luaReturnTVector(L, 4, TVectorSLERP(nv1, nv2, slerp));
  return 1;
 }
 
 static int navVectorFindUpAndRight(lua_State *L)
 {
  TVector up, right;
- luaCheckTVector(L, 1).calculateUpAndRight(up, right);
- luaPushNewTVector(L, up);
- luaPushNewTVector(L, right);
+ checkTVector(L, 1).calculateUpAndRight(up, right);
+ pushTVector(L, up);
+ pushTVector(L, right);
  return 2;
 }
 
 static int planeVectorFindConjugate(lua_State *L)
 {
- luaPushNewPVector(L, ~luaCheckPVector(L, 1));
+ pushPVector(L, ~checkPVector(L, 1));
  return 1;
 }
 
 static int navVectorXComponent(lua_State *L)
 {
- lua_pushnumber(L, luaCheckTVector(L, 1).xEast);
+ lua_pushnumber(L, checkTVector(L, 1).xEast);
  return 1;
 }
 
 static int navVectorYComponent(lua_State *L)
 {
- lua_pushnumber(L, luaCheckTVector(L, 1).yNorth);
+ lua_pushnumber(L, checkTVector(L, 1).yNorth);
  return 1;
 }
 
 static int navVectorZComponent(lua_State *L)
 {
- lua_pushnumber(L, luaCheckTVector(L, 1).zUp);
+ lua_pushnumber(L, checkTVector(L, 1).zUp);
  return 1;
 }
 
 static int planeVectorUComponent(lua_State *L)
 {
- lua_pushnumber(L, luaCheckPVector(L, 1).u);
+ lua_pushnumber(L, checkPVector(L, 1).u);
  return 1;
 }
 
 static int planeVectorVComponent(lua_State *L)
 {
- lua_pushnumber(L, luaCheckPVector(L, 1).v);
+ lua_pushnumber(L, checkPVector(L, 1).v);
  return 1;
 }
 
 static int angleBetweenTVectors(lua_State *L)
 {
- lua_pushnumber(L, angleBetweenVectors(luaCheckTVector(L, 1), luaCheckTVector(L, 2)));
+ lua_pushnumber(L, angleBetweenVectors(checkTVector(L, 1), checkTVector(L, 2)));
  return 1;
 }
 
 static int angleBetweenPVectors(lua_State *L)
 {
- lua_pushnumber(L, angleBetweenVectors(luaCheckPVector(L, 1), luaCheckPVector(L, 2)));
+ lua_pushnumber(L, angleBetweenVectors(checkPVector(L, 1), checkPVector(L, 2)));
  return 1;
 }
 
-static int navVectorToString(lua_State *L)
+// In-place operations
+// These modify the vector they are called on and return it, so hot loops can
+// run without allocating. They can be chained: dst:copyFrom(v):unitInPlace()
+
+static int navVectorSet(lua_State *L)
 {
- char str[30];
- TVector nv = luaCheckTVector(L, 1);
- snprintf(str, 30, "(%.3f, %.3f, %.3f)", nv.xEast, nv.yNorth, nv.zUp);
- lua_pushstring(L, str);
+ TVector &nv = checkTVector(L, 1);
+ nv.xEast = luaL_checknumber(L, 2);
+ nv.yNorth = luaL_checknumber(L, 3);
+ nv.zUp = luaL_checknumber(L, 4);
+ lua_settop(L, 1);
  return 1;
 }
 
-static int planeVectorToString(lua_State *L)
+static int planeVectorSet(lua_State *L)
 {
- char str[20];
- PVector pv = luaCheckPVector(L, 1);
- snprintf(str, 20, "(%.3f, %.3f)", pv.u, pv.v);
- lua_pushstring(L, str);
+ PVector &pv = checkPVector(L, 1);
+ pv.u = luaL_checknumber(L, 2);
+ pv.v = luaL_checknumber(L, 3);
+ lua_settop(L, 1);
  return 1;
 }
 
-static const struct luaL_Reg vectorLibMethods[] =
+static int navVectorCopyFrom(lua_State *L)
 {
- {"new", newVector},
- {"length", vectorLength},
- {"unit", calcUnitVector},
- {"rotate", vectorRotate},
- {"lerp", vectorLERP},
- {NULL, NULL}
-};
+ checkTVector(L, 1) = checkTVector(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
 
-static const struct luaL_Reg navVectorMetaTable[] =
+static int planeVectorCopyFrom(lua_State *L)
 {
- {"add", addTVectors},
- {"sub", subTVectors},
- {"mul", vectorMultiplyOperation},
- {"cross", navVectorCrossProduct},
- {"length", vectorLength},
- {"unit", calcUnitVector},
- {"rotate", vectorRotate},
- {"lerp", vectorLERP},
- {"slerp", navVectorSLERP},
- {"upAndRight", navVectorFindUpAndRight},
- {"x", navVectorXComponent},
- {"y", navVectorYComponent},
- {"z", navVectorZComponent},
- {"angle", angleBetweenTVectors},
- {"__tostring", navVectorToString},
- {"__add", addTVectors},
- {"__sub", subTVectors},
- {"__mul", vectorMultiplyOperation},
- {"__mod", navVectorCrossProduct},
- {"__unm", negateTVector},
- {"__len", vectorLength},
- {"__bnot", calcUnitVector},
- {NULL, NULL}
-};
+ checkPVector(L, 1) = checkPVector(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
 
-static const struct luaL_Reg planeVectorMetaTable[] =
+static int navVectorAddInPlace(lua_State *L)
 {
- {"add", addPVectors},
- {"sub", subPVectors},
- {"mul", vectorMultiplyOperation},
- {"length", vectorLength},
- {"unit", calcUnitVector},
- {"rotate", vectorRotate},
- {"lerp", vectorLERP},
- {"conj", planeVectorFindConjugate},
- {"u", planeVectorUComponent},
- {"v", planeVectorVComponent},
- {"angle", angleBetweenPVectors},
- {"__tostring", planeVectorToString},
- {"__add", addPVectors},
- {"__sub", subPVectors},
- {"__mul", vectorMultiplyOperation},
- {"__unm", negatePVector},
- {"__len", vectorLength},
- {"__bnot", calcUnitVector},
- {NULL, NULL}
-};
+ checkTVector(L, 1) += checkTVector(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
 
-void openLuaVectorLibrary(lua_State *L)
+static int planeVectorAddInPlace(lua_State *L)
 {
- luaL_newmetatable(L, vector2Meta);
- lua_pushstring(L, "__index");
- lua_pushvalue(L, -2);
- lua_settable(L, -3);
- luaL_setfuncs(L, planeVectorMetaTable, 0);
- lua_pop(L, 1);
+ checkPVector(L, 1) += checkPVector(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
 
- luaL_newmetatable(L, vector3Meta);
- lua_pushstring(L, "__index");
- lua_pushvalue(L, -2);
- lua_settable(L, -3);
- luaL_setfuncs(L, navVectorMetaTable, 0);
+static int navVectorSubInPlace(lua_State *L)
+{
+ checkTVector(L, 1) -= checkTVector(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int planeVectorSubInPlace(lua_State *L)
+{
+ checkPVector(L, 1) -= checkPVector(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int navVectorScaleInPlace(lua_State *L)
+{
+ checkTVector(L, 1) *= luaL_checknumber(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int planeVectorScaleInPlace(lua_State *L)
+{
+ checkPVector(L, 1) *= luaL_checknumber(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int navVectorNegateInPlace(lua_State *L)
+{
+ TVector &nv = checkTVector(L, 1);
+ nv = -nv;
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int planeVectorNegateInPlace(lua_State *L)
+{
+ PVector &pv = checkPVector(L, 1);
+ pv = -pv;
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int navVectorUnitInPlace(lua_State *L)
+{
+ TVector &nv = checkTVector(L, 1);
+ nv = unitVector(nv);
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int planeVectorUnitInPlace(lua_State *L)
+{
+ PVector &pv = checkPVector(L, 1);
+ pv = unitVector(pv);
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int navVectorCrossInPlace(lua_State *L)
+{
+ TVector &nv = checkTVector(L, 1);
+ nv = nv / checkTVector(L, 2);
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int navVectorRotateInPlace(lua_State *L)
+{
+ TVector &nv = checkTVector(L, 1);
+ nv = rotateTVectorAboutAxis(nv, checkTVector(L, 2), luaL_checknumber(L, 3));
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int planeVectorRotateInPlace(lua_State *L)
+{
+ PVector &pv = checkPVector(L, 1);
+ pv = rotatePVectorAboutOrigin(pv, luaL_checknumber(L, 2));
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int navVectorLERPInPlace(lua_State *L)
+{
+ TVector &nv = checkTVector(L, 1);
+ nv = LERP(nv, checkTVector(L, 2), luaL_checknumber(L, 3));
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int planeVectorLERPInPlace(lua_State *L)
+{
+ PVector &pv = checkPVector(L, 1);
+ pv = LERP(pv, checkPVector(L, 2), luaL_checknumber(L, 3));
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int planeVectorConjugateInPlace(lua_State *L)
+{
+ PVector &pv = checkPVector(L, 1);
+ pv = ~pv;
+ lua_settop(L, 1);
+ return 1;
+}
+
+// Vector arrays
+// A navvectorarray userdata holds a TVectorArray, so whole-array methods run
+// the batch kernels from PTVectorArrays.h over all of its vectors in one call.
+// Indices are 1 based as usual for Lua.
+
+static TVectorArray& checkTVectorArray(lua_State *L, int arg)
+{
+ if (!hasMetatable(L, arg, navVectorArrayMetaIndex)) luaL_checkudata(L, arg, vector3ArrayMeta);
+ return *(TVectorArray*)lua_touserdata(L, arg);
+}
+
+// Beyond this the byte size of each component array could overflow
+static const lua_Integer maxArraySize = std::numeric_limits<std::ptrdiff_t>::max()/sizeof(VectorPrecision);
+
+static std::size_t checkArraySize(lua_State *L, int arg)
+{
+ lua_Integer n = luaL_checkinteger(L, arg);
+ luaL_argcheck(L, n >= 0, arg, "negative array size");
+ luaL_argcheck(L, n <= maxArraySize, arg, "array size too large");
+ return n;
+}
+
+// Runs allocate(), returning false if it ran out of memory. A C++ exception
+// must not unwind through Lua's C frames, and luaL_error must not be called
+// from inside a catch, so callers raise the error once this has returned.
+template <typename Allocate>
+static bool tryAllocate(const Allocate &allocate)
+{
+ try
+ {
+  allocate();
+  return true;
+ }
+ catch (const std::bad_alloc&)
+ {
+ }
+ catch (const std::length_error&)
+ {
+ }
+ return false;
+}
+
+template <typename T>
+static int destroyScratch(lua_State *L)
+{
+ ((T*)lua_touserdata(L, 1))->~T();
+ return 0;
+}
+
+// An empty T, such as a std::vector, owned by a new userdata on the stack.
+// Scratch containers kept there are collected by Lua, so a Lua error can't
+// leak them. name is the registry name of the metatable that destroys them.
+template <typename T>
+static T& pushScratch(lua_State *L, const char *name)
+{
+ // an empty vector owns no memory until its metatable is set
+ T *scratch = new (lua_newuserdata(L, sizeof(T))) T();
+ if (luaL_newmetatable(L, name))
+ {
+  lua_pushcfunction(L, destroyScratch<T>);
+  lua_setfield(L, -2, "__gc");
+ }
+ lua_setmetatable(L, -2);
+ return *scratch;
+}
+
+static TVectorArray& pushTVectorArray(lua_State *L, std::size_t n)
+{
+ void *block = lua_newuserdata(L, sizeof(TVectorArray));
+ TVectorArray *a = nullptr;
+ // without its metatable the userdata is never destroyed, so a failed construction leaves nothing behind
+ if (!tryAllocate([&]() { a = new (block) TVectorArray(n); })) luaL_error(L, "not enough memory for %I vectors", (lua_Integer)n);
+ lua_pushvalue(L, navVectorArrayMetaIndex);
+ lua_setmetatable(L, -2);
+ return *a;
+}
+
+// The navvector at t[i], where t is the sequence at arg, or an error naming
+// the element
+static TVector checkTVectorElement(lua_State *L, int arg, lua_Integer i)
+{
+ lua_geti(L, arg, i);
+ if (vectorTypeOf(L, -1) != TVectorType) luaL_argerror(L, arg, lua_pushfstring(L, "points[%I]: navvector expected", i));
+ TVector v = *(TVector*)lua_touserdata(L, -1);
  lua_pop(L, 1);
+ return v;
+}
+
+// A navvectorarray of the navvectors in the sequence at arg, left on the
+// stack. It is Lua's from the start, so an error part way through leaks nothing.
+static TVectorArray& pushTVectorTable(lua_State *L, int arg)
+{
+ lua_Integer n = luaL_len(L, arg);
+ TVectorArray &points = pushTVectorArray(L, n);
+ for (lua_Integer i = 1; i <= n; ++i) points.set(i - 1, checkTVectorElement(L, arg, i));
+ return points;
+}
+
+// Runs kernel(), which resizes and fills result. If it runs out of memory
+// part way, result goes back to its old size so its components stay the
+// same length, and a Lua error is raised.
+template <typename Kernel>
+static void runArrayKernel(lua_State *L, TVectorArray &result, const Kernel &kernel)
+{
+ const std::size_t old = result.size();
+ if (tryAllocate(kernel)) return;
+ // shrinking the components that grew doesn't allocate
+ result.resize(old);
+ luaL_error(L, "not enough memory for the result array");
+}
+
+// The array at dstArg if the caller gave one, otherwise a new empty array.
+// Either way it is left on the stack for the kernel to resize and fill.
+static TVectorArray& arrayResult(lua_State *L, int dstArg)
+{
+ if (lua_isnoneornil(L, dstArg)) return pushTVectorArray(L, 0);
+ TVectorArray &dst = checkTVectorArray(L, dstArg);
+ lua_pushvalue(L, dstArg);
+ return dst;
+}
 
- luaL_newlib(L, vectorLibMethods);
+static std::size_t checkArrayIndex(lua_State *L, const TVectorArray &a, int arg)
+{
+ lua_Integer i = luaL_checkinteger(L, arg);
+ luaL_argcheck(L, i >= 1 && (lua_Unsigned)i <= a.size(), arg, "index out of range");
+ return i - 1;
+}
+
+static void checkSameSize(lua_State *L, const TVectorArray &a, const TVectorArray &b, int arg)
+{
+ luaL_argcheck(L, a.size() == b.size(), arg, "array size mismatch");
+}
+
+// vector.array(n [, v]) makes n vectors, all zero or all v
+// vector.array(t) copies the navvectors in the sequence t
+static int newVectorArray(lua_State *L)
+{
+ if (lua_istable(L, 1))
+ {
+  pushTVectorTable(L, 1);
+  return 1;
+ }
+
+ std::size_t n = checkArraySize(L, 1);
+ bool filled = !lua_isnoneornil(L, 2);
+ TVector fill = filled ? checkTVector(L, 2) : 0_x;
+ TVectorArray &a = pushTVectorArray(L, n);
+ if (filled) for (std::size_t i = 0; i < n; ++i) a.set(i, fill);
+ return 1;
+}
+
+static int navVectorArrayDestroy(lua_State *L)
+{
+ checkTVectorArray(L, 1).~TVectorArray();
+ return 0;
+}
+
+static int navVectorArraySize(lua_State *L)
+{
+ lua_pushinteger(L, checkTVectorArray(L, 1).size());
+ return 1;
+}
+
+static int navVectorArrayResize(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ std::size_t n = checkArraySize(L, 2);
+ runArrayKernel(L, a, [&]() { a.resize(n); });
+ lua_settop(L, 1);
+ return 1;
+}
+
+// a:get(i [, dst])
+static int navVectorArrayGet(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ luaReturnTVector(L, 3, a[checkArrayIndex(L, a, 2)]);
+ return 1;
+}
+
+// a:set(i, v) or a:set(i, x, y, z)
+static int navVectorArraySet(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ std::size_t i = checkArrayIndex(L, a, 2);
+ if (lua_gettop(L) >= 5)
+  a.set(i, {(VectorPrecision)luaL_checknumber(L, 3), (VectorPrecision)luaL_checknumber(L, 4), (VectorPrecision)luaL_checknumber(L, 5)});
+ else a.set(i, checkTVector(L, 3));
+ lua_settop(L, 1);
+ return 1;
+}
+
+// a:add(b [, dst]) where b is an array of the same size, or one vector added to every element
+static int navVectorArrayAdd(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ if (vectorTypeOf(L, 2) == TVectorType)
+ {
+  TVector b = checkTVector(L, 2);
+  TVectorArray &result = arrayResult(L, 3);
+  runArrayKernel(L, result, [&]() { addVectorArrays(a, b, result); });
+  return 1;
+ }
+ TVectorArray &b = checkTVectorArray(L, 2);
+ checkSameSize(L, a, b, 2);
+ TVectorArray &result = arrayResult(L, 3);
+ runArrayKernel(L, result, [&]() { addVectorArrays(a, b, result); });
+ return 1;
+}
+
+static int navVectorArraySub(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ TVectorArray &b = checkTVectorArray(L, 2);
+ checkSameSize(L, a, b, 2);
+ TVectorArray &result = arrayResult(L, 3);
+ runArrayKernel(L, result, [&]() { subtractVectorArrays(a, b, result); });
+ return 1;
+}
+
+static int navVectorArrayScale(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ VectorPrecision s = luaL_checknumber(L, 2);
+ TVectorArray &result = arrayResult(L, 3);
+ runArrayKernel(L, result, [&]() { scaleVectorArray(a, s, result); });
+ return 1;
+}
+
+// a:rotate(axis, angle [, dst]) with axis a UNIT VECTOR, as for navvector rotate
+static int navVectorArrayRotate(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ TVectorRotation r(checkTVector(L, 2), luaL_checknumber(L, 3));
+ TVectorArray &result = arrayResult(L, 4);
+ runArrayKernel(L, result, [&]() { r.apply(a, result); });
+ return 1;
+}
+
+static int navVectorArrayNormalize(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ TVectorArray &result = arrayResult(L, 2);
+ runArrayKernel(L, result, [&]() { normalizeVectorArray(a, result); });
+ return 1;
+}
+
+static int navVectorArrayLERP(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ TVectorArray &b = checkTVectorArray(L, 2);
+ checkSameSize(L, a, b, 2);
+ VectorPrecision s = luaL_checknumber(L, 3);
+ TVectorArray &result = arrayResult(L, 4);
+ runArrayKernel(L, result, [&]() { lerpVectorArrays(a, b, s, result); });
+ return 1;
+}
+
+// a:dot(v [, t]) returns a sequence of a[i] * v, written into t if given
+static int navVectorArrayDot(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ TVector v = checkTVector(L, 2);
+ if (!lua_isnoneornil(L, 3)) luaL_checktype(L, 3, LUA_TTABLE);
+
+ ScalarArray &dots = pushScratch<ScalarArray>(L, "navvectorscratch.scalars");
+ if (lua_isnoneornil(L, 3)) lua_createtable(L, a.size(), 0);
+ else lua_pushvalue(L, 3);
+ if (!tryAllocate([&]() { dotVectorArrays(a, v, dots); })) luaL_error(L, "not enough memory for %I dot products", (lua_Integer)a.size());
+ for (std::size_t i = 0; i < dots.size(); ++i)
+ {
+  lua_pushnumber(L, dots[i]);
+  lua_rawseti(L, -2, i + 1);
+ }
+ return 1;
+}
+
+// a:bounds() returns the minimum and maximum corners
+static int navVectorArrayBounds(lua_State *L)
+{
+ TVectorArray &a = checkTVectorArray(L, 1);
+ luaL_argcheck(L, a.size() > 0, 1, "empty array");
+ TVector min, max;
+ boundsVectorArray(a, min, max);
+ pushTVector(L, min);
+ pushTVector(L, max);
+ return 2;
+}
+
+static int navVectorArrayCentroid(lua_State *L)
+{
+ luaReturnTVector(L, 2, centroidVectorArray(checkTVectorArray(L, 1)));
+ return 1;
+}
+
+static int navVectorArrayToString(lua_State *L)
+{
+ lua_pushfstring(L, "navvectorarray(%d)", (int)checkTVectorArray(L, 1).size());
+ return 1;
+}
+
+// Views
+// Element access straight into the host's buffer. Released views raise an
+// error on any use. See LuaVectorLib.h for the host side.
+
+static LuaVectorView& checkVectorView(lua_State *L, int arg)
+{
+ if (!hasMetatable(L, arg, vectorViewMetaIndex)) luaL_checkudata(L, arg, vectorViewMeta);
+ LuaVectorView &view = *(LuaVectorView*)lua_touserdata(L, arg);
+ if (view.ref == LUA_NOREF) luaL_error(L, "vector view has been released");
+ return view;
+}
+
+static std::size_t checkViewIndex(lua_State *L, const LuaVectorView &view, int arg)
+{
+ lua_Integer i = luaL_checkinteger(L, arg);
+ luaL_argcheck(L, i >= 1 && (lua_Unsigned)i <= view.size, arg, "index out of range");
+ return i - 1;
+}
+
+static LuaVectorView& checkWritableView(lua_State *L, int arg)
+{
+ LuaVectorView &view = checkVectorView(L, arg);
+ if (view.readOnly) luaL_error(L, "vector view is read only");
+ return view;
+}
+
+static int vectorViewSize(lua_State *L)
+{
+ lua_pushinteger(L, checkVectorView(L, 1).size);
+ return 1;
+}
+
+static int vectorViewIsValid(lua_State *L)
+{
+ // checkVectorView would raise the error this is asked to avoid
+ LuaVectorView *view = (LuaVectorView*)luaL_checkudata(L, 1, vectorViewMeta);
+ lua_pushboolean(L, view->ref != LUA_NOREF);
+ return 1;
+}
+
+// v:get(i [, dst])
+static int vectorViewGet(lua_State *L)
+{
+ LuaVectorView &view = checkVectorView(L, 1);
+ std::size_t i = checkViewIndex(L, view, 2);
+ if (view.isTVector) luaReturnTVector(L, 3, ((TVector*)view.data)[i]);
+ else luaReturnPVector(L, 3, ((PVector*)view.data)[i]);
+ return 1;
+}
+
+// v:components(i) returns the components as numbers, without making a vector
+static int vectorViewComponents(lua_State *L)
+{
+ LuaVectorView &view = checkVectorView(L, 1);
+ std::size_t i = checkViewIndex(L, view, 2);
+ if (view.isTVector)
+ {
+  const TVector &nv = ((TVector*)view.data)[i];
+  lua_pushnumber(L, nv.xEast);
+  lua_pushnumber(L, nv.yNorth);
+  lua_pushnumber(L, nv.zUp);
+  return 3;
+ }
+ const PVector &pv = ((PVector*)view.data)[i];
+ lua_pushnumber(L, pv.u);
+ lua_pushnumber(L, pv.v);
+ return 2;
+}
+
+// v:set(i, vector), v:set(i, x, y, z) or v:set(i, u, v)
+static int vectorViewSet(lua_State *L)
+{
+ LuaVectorView &view = checkWritableView(L, 1);
+ std::size_t i = checkViewIndex(L, view, 2);
+ if (view.isTVector)
+ {
+  TVector &nv = ((TVector*)view.data)[i];
+  if (lua_gettop(L) >= 5)
+  {
+   nv.xEast = luaL_checknumber(L, 3);
+   nv.yNorth = luaL_checknumber(L, 4);
+   nv.zUp = luaL_checknumber(L, 5);
+  }
+  else nv = checkTVector(L, 3);
+ }
+ else
+ {
+  PVector &pv = ((PVector*)view.data)[i];
+  if (lua_gettop(L) >= 4)
+  {
+   pv.u = luaL_checknumber(L, 3);
+   pv.v = luaL_checknumber(L, 4);
+  }
+  else pv = checkPVector(L, 3);
+ }
+ lua_settop(L, 1);
+ return 1;
+}
+
+// v:toArray([dst]) copies a navvector view into a navvectorarray for the whole-array methods
+static int vectorViewToArray(lua_State *L)
+{
+ LuaVectorView &view = checkVectorView(L, 1);
+ luaL_argcheck(L, view.isTVector, 1, "navvector view expected");
+ TVectorArray &a = arrayResult(L, 2);
+ const TVector *data = (const TVector*)view.data;
+ runArrayKernel(L, a, [&]()
+ {
+  a.resize(view.size);
+  for (std::size_t i = 0; i < view.size; ++i) a.set(i, data[i]);
+ });
+ return 1;
+}
+
+// v:fromArray(a) copies a navvectorarray of the same size back into the view
+static int vectorViewFromArray(lua_State *L)
+{
+ LuaVectorView &view = checkWritableView(L, 1);
+ luaL_argcheck(L, view.isTVector, 1, "navvector view expected");
+ TVectorArray &a = checkTVectorArray(L, 2);
+ luaL_argcheck(L, a.size() == view.size, 2, "array size mismatch");
+ a.copyTo((TVector*)view.data);
+ lua_settop(L, 1);
+ return 1;
+}
+
+static int vectorViewToString(lua_State *L)
+{
+ LuaVectorView *view = (LuaVectorView*)luaL_checkudata(L, 1, vectorViewMeta);
+ if (view->ref == LUA_NOREF) lua_pushstring(L, "vectorview(released)");
+ else lua_pushfstring(L, "vectorview(%s, %d)", view->isTVector ? vector3Meta : vector2Meta, (int)view->size);
+ return 1;
+}
+
+// k-d trees
+// vector.kdtree(points) builds a TVectorKDTree from a navvectorarray or a
+// sequence of navvectors. Query results are 1 based indices into points.
+
+static TVectorKDTree& checkTVectorKDTree(lua_State *L, int arg)
+{
+ if (!hasMetatable(L, arg, navVectorKDTreeMetaIndex)) luaL_checkudata(L, arg, vector3KDTreeMeta);
+ return *(TVectorKDTree*)lua_touserdata(L, arg);
+}
+
+static void pushIndexTable(lua_State *L, const std::vector<std::size_t> &indices)
+{
+ lua_createtable(L, indices.size(), 0);
+ for (std::size_t i = 0; i < indices.size(); ++i)
+ {
+  lua_pushinteger(L, indices[i] + 1);
+  lua_rawseti(L, -2, i + 1);
+ }
+}
+
+static int newVectorKDTree(lua_State *L)
+{
+ const TVectorArray &points = lua_istable(L, 1) ? pushTVectorTable(L, 1) : checkTVectorArray(L, 1);
+ void *block = lua_newuserdata(L, sizeof(TVectorKDTree));
+ if (!tryAllocate([&]() { new (block) TVectorKDTree(points); })) luaL_error(L, "not enough memory for a k-d tree of %I points", (lua_Integer)points.size());
+ lua_pushvalue(L, navVectorKDTreeMetaIndex);
+ lua_setmetatable(L, -2);
+ return 1;
+}
+
+static int navVectorKDTreeDestroy(lua_State *L)
+{
+ checkTVectorKDTree(L, 1).~TVectorKDTree();
+ return 0;
+}
+
+static int navVectorKDTreeSize(lua_State *L)
+{
+ lua_pushinteger(L, checkTVectorKDTree(L, 1).size());
+ return 1;
+}
+
+// tree:nearest(q) returns the index of the nearest point and its distance,
+// or nil if nothing matches. tree:nearest(q, k) returns a sequence of the k
+// nearest indices, closest first, and a sequence of their distances.
+static int navVectorKDTreeNearest(lua_State *L)
+{
+ TVectorKDTree &tree = checkTVectorKDTree(L, 1);
+ TVector q = checkTVector(L, 2);
+ const bool single = lua_isnoneornil(L, 3);
+ lua_Integer k = single ? 1 : luaL_checkinteger(L, 3);
+ luaL_argcheck(L, k >= 0, 3, "negative count");
+
+ // the results live in Lua-owned scratch so an error can't leak them
+ std::vector<std::size_t> &indices = pushScratch<std::vector<std::size_t> >(L, "navvectorscratch.indices");
+ std::vector<VectorPrecision> &distancesSquared = pushScratch<std::vector<VectorPrecision> >(L, "navvectorscratch.distances");
+ // more than size() would only reserve space that can't be filled
+ const std::size_t count = std::min<lua_Unsigned>(k, tree.size());
+ if (!tryAllocate([&]() { tree.nearest(q, count, indices, distancesSquared); })) luaL_error(L, "not enough memory for %I nearest points", k);
+ if (single)
+ {
+  if (indices.empty()) return 0;
+  lua_pushinteger(L, indices[0] + 1);
+  lua_pushnumber(L, std::sqrt(distancesSquared[0]));
+  return 2;
+ }
+
+ pushIndexTable(L, indices);
+ lua_createtable(L, distancesSquared.size(), 0);
+ for (std::size_t i = 0; i < distancesSquared.size(); ++i)
+ {
+  lua_pushnumber(L, std::sqrt(distancesSquared[i]));
+  lua_rawseti(L, -2, i + 1);
+ }
+ return 2;
+}
+
+// tree:within(q, r) returns a sequence of the indices of every point within r of q
+static int navVectorKDTreeWithin(lua_State *L)
+{
+ TVectorKDTree &tree = checkTVectorKDTree(L, 1);
+ TVector q = checkTVector(L, 2);
+ lua_Number r = luaL_checknumber(L, 3);
+ std::vector<std::size_t> &indices = pushScratch<std::vector<std::size_t> >(L, "navvectorscratch.indices");
+ if (!tryAllocate([&]() { tree.withinRadius(q, r, indices); })) luaL_error(L, "not enough memory for the points within %f", r);
+ pushIndexTable(L, indices);
+ return 1;
+}
+
+// tree:nearestEach(a) returns a sequence of the nearest point to each vector in the navvectorarray a,
+// false where nothing matches
+static int navVectorKDTreeNearestEach(lua_State *L)
+{
+ TVectorKDTree &tree = checkTVectorKDTree(L, 1);
+ TVectorArray &queries = checkTVectorArray(L, 2);
+ luaL_argcheck(L, tree.size() > 0, 1, "empty tree");
+ std::vector<std::size_t> &indices = pushScratch<std::vector<std::size_t> >(L, "navvectorscratch.indices");
+ if (!tryAllocate([&]() { tree.nearest(queries, indices); })) luaL_error(L, "not enough memory for %I nearest points", (lua_Integer)queries.size());
+ // queries that match nothing get false, keeping the sequence whole
+ lua_createtable(L, indices.size(), 0);
+ for (std::size_t i = 0; i < indices.size(); ++i)
+ {
+  if (indices[i] < tree.size()) lua_pushinteger(L, indices[i] + 1);
+  else lua_pushboolean(L, 0);
+  lua_rawseti(L, -2, i + 1);
+ }
+ return 1;
+}
+
+static int navVectorKDTreeToString(lua_State *L)
+{
+ lua_pushfstring(L, "navvectorkdtree(%d)", (int)checkTVectorKDTree(L, 1).size());
+ return 1;
+}
+
+// Splines
+// vector.spline(points [, kind]) builds a TVectorSpline through a
+// navvectorarray or a sequence of navvectors, kind being "catmullrom" (the
+// default), "centripetal" or "bezier". Whole paths come back as arrays.
+
+static const char *const splineKinds[] = {"catmullrom", "centripetal", "bezier", NULL};
+static const SplineType splineTypes[] = {SplineType::catmullRom, SplineType::centripetalCatmullRom, SplineType::bezier};
+
+static TVectorSpline& checkTVectorSpline(lua_State *L, int arg)
+{
+ if (!hasMetatable(L, arg, navVectorSplineMetaIndex)) luaL_checkudata(L, arg, vector3SplineMeta);
+ return *(TVectorSpline*)lua_touserdata(L, arg);
+}
+
+static int newVectorSpline(lua_State *L)
+{
+ SplineType type = splineTypes[luaL_checkoption(L, 2, "catmullrom", splineKinds)];
+ const TVectorArray &points = lua_istable(L, 1) ? pushTVectorTable(L, 1) : checkTVectorArray(L, 1);
+ void *block = lua_newuserdata(L, sizeof(TVectorSpline));
+ if (!tryAllocate([&]() { new (block) TVectorSpline(points, type); })) luaL_error(L, "not enough memory for a spline of %I points", (lua_Integer)points.size());
+ lua_pushvalue(L, navVectorSplineMetaIndex);
+ lua_setmetatable(L, -2);
+ return 1;
+}
+
+static int navVectorSplineDestroy(lua_State *L)
+{
+ checkTVectorSpline(L, 1).~TVectorSpline();
+ return 0;
+}
+
+static int navVectorSplineSegments(lua_State *L)
+{
+ lua_pushinteger(L, checkTVectorSpline(L, 1).segments());
+ return 1;
+}
+
+static int navVectorSplineLength(lua_State *L)
+{
+ lua_pushnumber(L, checkTVectorSpline(L, 1).length());
+ return 1;
+}
+
+// s:at(t [, dst]) for t from 0 to 1
+static int navVectorSplineAt(lua_State *L)
+{
+ TVectorSpline &spline = checkTVectorSpline(L, 1);
+ luaReturnTVector(L, 3, spline.at(luaL_checknumber(L, 2)));
+ return 1;
+}
+
+static int navVectorSplineTangent(lua_State *L)
+{
+ TVectorSpline &spline = checkTVectorSpline(L, 1);
+ luaReturnTVector(L, 3, spline.tangent(luaL_checknumber(L, 2)));
+ return 1;
+}
+
+// s:atDistance(d [, dst]) the point d along the curve
+static int navVectorSplineAtDistance(lua_State *L)
+{
+ TVectorSpline &spline = checkTVectorSpline(L, 1);
+ luaReturnTVector(L, 3, spline.atDistance(luaL_checknumber(L, 2)));
+ return 1;
+}
+
+// the arrays for the sample methods, which must be different if both are given
+static std::size_t checkSampleArguments(lua_State *L)
+{
+ std::size_t n = checkArraySize(L, 2);
+ luaL_argcheck(L, lua_isnoneornil(L, 3) || !lua_rawequal(L, 3, 4), 4, "points and tangents must be different arrays");
+ return n;
+}
+
+// Runs sample(), leaving both arrays empty and raising an error if it runs
+// out of memory part way
+template <typename Sample>
+static void sampleOrError(lua_State *L, std::size_t n, TVectorArray &points, TVectorArray &tangents, const Sample &sample)
+{
+ if (tryAllocate(sample)) return;
+ points.resize(0);
+ tangents.resize(0);
+ luaL_error(L, "not enough memory for %I samples", (lua_Integer)n);
+}
+
+// s:sample(n [, points [, tangents]]) returns n points evenly spaced in t and their tangents
+static int navVectorSplineSample(lua_State *L)
+{
+ TVectorSpline &spline = checkTVectorSpline(L, 1);
+ std::size_t n = checkSampleArguments(L);
+ TVectorArray &points = arrayResult(L, 3);
+ TVectorArray &tangents = arrayResult(L, 4);
+ sampleOrError(L, n, points, tangents, [&]() { spline.sample(n, points, tangents); });
+ return 2;
+}
+
+// s:sampleByDistance(n [, points [, tangents]]) the same evenly spaced along the curve, with unit tangents
+static int navVectorSplineSampleByDistance(lua_State *L)
+{
+ TVectorSpline &spline = checkTVectorSpline(L, 1);
+ std::size_t n = checkSampleArguments(L);
+ TVectorArray &points = arrayResult(L, 3);
+ TVectorArray &tangents = arrayResult(L, 4);
+ sampleOrError(L, n, points, tangents, [&]() { spline.sampleByDistance(n, points, tangents); });
+ return 2;
+}
+
+static int navVectorSplineToString(lua_State *L)
+{
+ lua_pushfstring(L, "navvectorspline(%d)", (int)checkTVectorSpline(L, 1).segments());
+ return 1;
+}
+
+// Polygons
+// vector.polygon(points) makes a polygon from a sequence of planevectors,
+// which keeps an edge index for its containment tests. Points to test may be
+// planevectors or navvectors, whose x and y are used, and whole
+// navvectorarrays can be tested at once.
+
+struct LuaPolygon
+{
+ PVectorArray vertices;
+ PolygonEdgeIndex index;
+};
+
+static LuaPolygon& checkPolygon(lua_State *L, int arg)
+{
+ if (!hasMetatable(L, arg, planeVectorPolygonMetaIndex)) luaL_checkudata(L, arg, vector2PolygonMeta);
+ return *(LuaPolygon*)lua_touserdata(L, arg);
+}
+
+// A new polygon with the vertices that make(vertices) fills in. The userdata
+// comes first, so no C++ container is alive across a Lua allocation.
+template <typename Make>
+static void pushPolygon(lua_State *L, const Make &make)
+{
+ void *block = lua_newuserdata(L, sizeof(LuaPolygon));
+ if (!tryAllocate([&]()
+ {
+  PVectorArray vertices;
+  make(vertices);
+  new (block) LuaPolygon{vertices, PolygonEdgeIndex(vertices)};
+ }))
+  luaL_error(L, "not enough memory for a polygon");
+ lua_pushvalue(L, planeVectorPolygonMetaIndex);
+ lua_setmetatable(L, -2);
+}
+
+static PVector checkPlanePoint(lua_State *L, int arg)
+{
+ lua_Number number;
+ TVector nv;
+ PVector pv;
+ int type = getArgument(L, arg, number, nv, pv);
+ if (type == TVectorType) return {nv.xEast, nv.yNorth};
+ if (type != PVectorType) luaL_argerror(L, arg, "'Vector' expected");
+ return pv;
+}
+
+// Points as the x and y of a navvectorarray. A sequence of planevectors or
+// navvectors is copied into a new array first, left on the stack, so an
+// element that isn't a vector leaks nothing.
+static const TVectorArray& checkPlanePoints(lua_State *L, int arg)
+{
+ if (!lua_istable(L, arg)) return checkTVectorArray(L, arg);
+ lua_Integer n = luaL_len(L, arg);
+ TVectorArray &points = pushTVectorArray(L, n);
+ for (lua_Integer i = 1; i <= n; ++i)
+ {
+  lua_geti(L, arg, i);
+  const int type = vectorTypeOf(L, -1);
+  if (type == PVectorType)
+  {
+   const PVector pv = *(PVector*)lua_touserdata(L, -1);
+   points.set(i - 1, {pv.u, pv.v, 0.0});
+  }
+  else if (type == TVectorType) points.set(i - 1, *(TVector*)lua_touserdata(L, -1));
+  else luaL_argerror(L, arg, lua_pushfstring(L, "points[%I]: vector expected", i));
+  lua_pop(L, 1);
+ }
+ return points;
+}
+
+static void planePointsOf(const TVectorArray &a, PVectorArray &points)
+{
+ points.u = a.xEast;
+ points.v = a.yNorth;
+}
+
+static int newVectorPolygon(lua_State *L)
+{
+ luaL_checktype(L, 1, LUA_TTABLE);
+ const TVectorArray &points = checkPlanePoints(L, 1);
+ pushPolygon(L, [&](PVectorArray &vertices) { planePointsOf(points, vertices); });
+ return 1;
+}
+
+static int planeVectorPolygonDestroy(lua_State *L)
+{
+ checkPolygon(L, 1).~LuaPolygon();
+ return 0;
+}
+
+static int planeVectorPolygonSize(lua_State *L)
+{
+ lua_pushinteger(L, checkPolygon(L, 1).vertices.size());
+ return 1;
+}
+
+// poly:area() is positive for anticlockwise vertices
+static int planeVectorPolygonArea(lua_State *L)
+{
+ lua_pushnumber(L, polygonSignedArea(checkPolygon(L, 1).vertices));
+ return 1;
+}
+
+static int planeVectorPolygonCentroid(lua_State *L)
+{
+ pushPVector(L, polygonCentroid(checkPolygon(L, 1).vertices));
+ return 1;
+}
+
+static int planeVectorPolygonContains(lua_State *L)
+{
+ lua_pushboolean(L, checkPolygon(L, 1).index.contains(checkPlanePoint(L, 2)));
+ return 1;
+}
+
+// poly:containsEach(points) returns a sequence of booleans, one for each point
+static int planeVectorPolygonContainsEach(lua_State *L)
+{
+ LuaPolygon &polygon = checkPolygon(L, 1);
+ const TVectorArray &a = checkPlanePoints(L, 2);
+ // the flags live in Lua-owned scratch so an error can't leak them
+ std::vector<std::uint8_t> &inside = pushScratch<std::vector<std::uint8_t> >(L, "navvectorscratch.flags");
+ lua_createtable(L, a.size(), 0);
+ if (!tryAllocate([&]()
+ {
+  PVectorArray points;
+  planePointsOf(a, points);
+  polygon.index.contains(points, inside);
+ }))
+  luaL_error(L, "not enough memory to test %I points", (lua_Integer)a.size());
+ for (std::size_t i = 0; i < inside.size(); ++i)
+ {
+  lua_pushboolean(L, inside[i]);
+  lua_rawseti(L, -2, i + 1);
+ }
+ return 1;
+}
+
+static int planeVectorPolygonHull(lua_State *L)
+{
+ LuaPolygon &polygon = checkPolygon(L, 1);
+ pushPolygon(L, [&](PVectorArray &hull) { convexHull(polygon.vertices, hull); });
+ return 1;
+}
+
+// poly:offset(d [, miterLimit]) returns a new polygon d further out, or in if d is negative
+static int planeVectorPolygonOffset(lua_State *L)
+{
+ LuaPolygon &polygon = checkPolygon(L, 1);
+ const VectorPrecision distance = luaL_checknumber(L, 2), miterLimit = luaL_optnumber(L, 3, 2.0);
+ pushPolygon(L, [&](PVectorArray &offset) { offsetPolygon(polygon.vertices, distance, offset, miterLimit); });
+ return 1;
+}
+
+static int planeVectorPolygonVertices(lua_State *L)
+{
+ const PVectorArray &vertices = checkPolygon(L, 1).vertices;
+ lua_createtable(L, vertices.size(), 0);
+ for (std::size_t i = 0; i < vertices.size(); ++i)
+ {
+  pushPVector(L, vertices[i]);
+  lua_rawseti(L, -2, i + 1);
+ }
+ return 1;
+}
+
+static int planeVectorPolygonToString(lua_State *L)
+{
+ lua_pushfstring(L, "planevectorpolygon(%d)", (int)checkPolygon(L, 1).vertices.size());
+ return 1;
+}
+
+static int navVectorToString(lua_State *L)
+{
+ char str[30];
+ TVector nv = checkTVector(L, 1);
+ snprintf(str, 30, "(%.3f, %.3f, %.3f)", nv.xEast, nv.yNorth, nv.zUp);
+ lua_pushstring(L, str);
+ return 1;
+}
+
+static int planeVectorToString(lua_State *L)
+{
+ char str[20];
+ PVector pv = checkPVector(L, 1);
+ snprintf(str, 20, "(%.3f, %.3f)", pv.u, pv.v);
+ lua_pushstring(L, str);
+ return 1;
+}
+
+static const struct luaL_Reg vectorLibMethods[] =
+{
+ {"new", newVector},
+ {"length", vectorLength},
+ {"unit", calcUnitVector},
+ {"rotate", vectorRotate},
+ {"lerp", vectorLERP},
+ {"array", newVectorArray},
+ {"kdtree", newVectorKDTree},
+ {"spline", newVectorSpline},
+ {"polygon", newVectorPolygon},
+ {NULL, NULL}
+};
+
+static const struct luaL_Reg navVectorMetaTable[] =
+{
+ {"add", addTVectors},
+ {"sub", subTVectors},
+ {"mul", vectorMultiplyOperation},
+ {"cross", navVectorCrossProduct},
+ {"length", vectorLength},
+ {"unit", calcUnitVector},
+ {"rotate", vectorRotate},
+ {"lerp", vectorLERP},
+ {"slerp", navVectorSLERP},
+ {"upAndRight", navVectorFindUpAndRight},
+ {"x", navVectorXComponent},
+ {"y", navVectorYComponent},
+ {"z", navVectorZComponent},
+ {"angle", angleBetweenTVectors},
+ {"set", navVectorSet},
+ {"copyFrom", navVectorCopyFrom},
+ {"addInPlace", navVectorAddInPlace},
+ {"subInPlace", navVectorSubInPlace},
+ {"scaleInPlace", navVectorScaleInPlace},
+ {"negateInPlace", navVectorNegateInPlace},
+ {"unitInPlace", navVectorUnitInPlace},
+ {"crossInPlace", navVectorCrossInPlace},
+ {"rotateInPlace", navVectorRotateInPlace},
+ {"lerpInPlace", navVectorLERPInPlace},
+ {"__tostring", navVectorToString},
+ {"__add", addTVectors},
+ {"__sub", subTVectors},
+ {"__mul", vectorMultiplyOperation},
+ {"__mod", navVectorCrossProduct},
+ {"__unm", negateTVector},
+ {"__len", vectorLength},
+ {"__bnot", calcUnitVector},
+ {NULL, NULL}
+};
+
+static const struct luaL_Reg planeVectorMetaTable[] =
+{
+ {"add", addPVectors},
+ {"sub", subPVectors},
+ {"mul", vectorMultiplyOperation},
+ {"length", vectorLength},
+ {"unit", calcUnitVector},
+ {"rotate", vectorRotate},
+ {"lerp", vectorLERP},
+ {"conj", planeVectorFindConjugate},
+ {"u", planeVectorUComponent},
+ {"v", planeVectorVComponent},
+ {"angle", angleBetweenPVectors},
+ {"set", planeVectorSet},
+ {"copyFrom", planeVectorCopyFrom},
+ {"addInPlace", planeVectorAddInPlace},
+ {"subInPlace", planeVectorSubInPlace},
+ {"scaleInPlace", planeVectorScaleInPlace},
+ {"negateInPlace", planeVectorNegateInPlace},
+ {"unitInPlace", planeVectorUnitInPlace},
+ {"rotateInPlace", planeVectorRotateInPlace},
+ {"lerpInPlace", planeVectorLERPInPlace},
+ {"conjInPlace", planeVectorConjugateInPlace},
+ {"__tostring", planeVectorToString},
+ {"__add", addPVectors},
+ {"__sub", subPVectors},
+ {"__mul", vectorMultiplyOperation},
+ {"__unm", negatePVector},
+ {"__len", vectorLength},
+ {"__bnot", calcUnitVector},
+ {NULL, NULL}
+};
+
+static const struct luaL_Reg navVectorArrayMetaTable[] =
+{
+ {"size", navVectorArraySize},
+ {"resize", navVectorArrayResize},
+ {"get", navVectorArrayGet},
+ {"set", navVectorArraySet},
+ {"add", navVectorArrayAdd},
+ {"sub", navVectorArraySub},
+ {"scale", navVectorArrayScale},
+ {"rotate", navVectorArrayRotate},
+ {"normalize", navVectorArrayNormalize},
+ {"lerp", navVectorArrayLERP},
+ {"dot", navVectorArrayDot},
+ {"bounds", navVectorArrayBounds},
+ {"centroid", navVectorArrayCentroid},
+ {"__len", navVectorArraySize},
+ {"__tostring", navVectorArrayToString},
+ {"__gc", navVectorArrayDestroy},
+ {NULL, NULL}
+};
+
+static const struct luaL_Reg vectorViewMetaTable[] =
+{
+ {"size", vectorViewSize},
+ {"valid", vectorViewIsValid},
+ {"get", vectorViewGet},
+ {"components", vectorViewComponents},
+ {"set", vectorViewSet},
+ {"toArray", vectorViewToArray},
+ {"fromArray", vectorViewFromArray},
+ {"__len", vectorViewSize},
+ {"__tostring", vectorViewToString},
+ {NULL, NULL}
+};
+
+static const struct luaL_Reg navVectorKDTreeMetaTable[] =
+{
+ {"size", navVectorKDTreeSize},
+ {"nearest", navVectorKDTreeNearest},
+ {"within", navVectorKDTreeWithin},
+ {"nearestEach", navVectorKDTreeNearestEach},
+ {"__len", navVectorKDTreeSize},
+ {"__tostring", navVectorKDTreeToString},
+ {"__gc", navVectorKDTreeDestroy},
+ {NULL, NULL}
+};
+
+static const struct luaL_Reg planeVectorPolygonMetaTable[] =
+{
+ {"size", planeVectorPolygonSize},
+ {"area", planeVectorPolygonArea},
+ {"centroid", planeVectorPolygonCentroid},
+ {"contains", planeVectorPolygonContains},
+ {"containsEach", planeVectorPolygonContainsEach},
+ {"hull", planeVectorPolygonHull},
+ {"offset", planeVectorPolygonOffset},
+ {"vertices", planeVectorPolygonVertices},
+ {"__len", planeVectorPolygonSize},
+ {"__tostring", planeVectorPolygonToString},
+ {"__gc", planeVectorPolygonDestroy},
+ {NULL, NULL}
+};
+
+static const struct luaL_Reg navVectorSplineMetaTable[] =
+{
+ {"segments", navVectorSplineSegments},
+ {"length", navVectorSplineLength},
+ {"at", navVectorSplineAt},
+ {"tangent", navVectorSplineTangent},
+ {"atDistance", navVectorSplineAtDistance},
+ {"sample", navVectorSplineSample},
+ {"sampleByDistance", navVectorSplineSampleByDistance},
+ {"__tostring", navVectorSplineToString},
+ {"__gc", navVectorSplineDestroy},
+ {NULL, NULL}
+};
+
+// Registers funcs into the table on top of the stack with the metatables as upvalues
+static void setVectorFuncs(lua_State *L, const luaL_Reg *funcs)
+{
+ luaL_getmetatable(L, vector3Meta);
+ luaL_getmetatable(L, vector2Meta);
+ luaL_getmetatable(L, vector3ArrayMeta);
+ luaL_getmetatable(L, vectorViewMeta);
+ luaL_getmetatable(L, vector3KDTreeMeta);
+ luaL_getmetatable(L, vector3SplineMeta);
+ luaL_getmetatable(L, vector2PolygonMeta);
+ luaL_setfuncs(L, funcs, 7);
+}
+
+static void newVectorMetatable(lua_State *L, const char *name)
+{
+ luaL_newmetatable(L, name);
+ lua_pushstring(L, "__index");
+ lua_pushvalue(L, -2);
+ lua_settable(L, -3);
+ lua_pop(L, 1);
+}
+
+static void setMetatableFuncs(lua_State *L, const char *name, const luaL_Reg *funcs)
+{
+ luaL_getmetatable(L, name);
+ setVectorFuncs(L, funcs);
+ lua_pop(L, 1);
+}
+
+void openLuaVectorLibrary(lua_State *L)
+{
+ newVectorMetatable(L, vector2Meta);
+ newVectorMetatable(L, vector3Meta);
+ newVectorMetatable(L, vector3ArrayMeta);
+ newVectorMetatable(L, vectorViewMeta);
+ newVectorMetatable(L, vector3KDTreeMeta);
+ newVectorMetatable(L, vector3SplineMeta);
+ newVectorMetatable(L, vector2PolygonMeta);
+
+ // all the metatables have to exist before any of them gets its functions
+ setMetatableFuncs(L, vector2Meta, planeVectorMetaTable);
+ setMetatableFuncs(L, vector3Meta, navVectorMetaTable);
+ setMetatableFuncs(L, vector3ArrayMeta, navVectorArrayMetaTable);
+ setMetatableFuncs(L, vectorViewMeta, vectorViewMetaTable);
+ setMetatableFuncs(L, vector3KDTreeMeta, navVectorKDTreeMetaTable);
+ setMetatableFuncs(L, vector3SplineMeta, navVectorSplineMetaTable);
+ setMetatableFuncs(L, vector2PolygonMeta, planeVectorPolygonMetaTable);
+
+ luaL_newlibtable(L, vectorLibMethods);
+ setVectorFuncs(L, vectorLibMethods);
  lua_setglobal(L, "vector");
  if (luaL_dostring(L, "vector.nzero = vector.new(0, 0, 0)\nvector.pzero = vector.new(0, 0)\n"))
  {
@@ -28,6 +28,7 @@
 #define LUAVECTORLIB_H
 
 #include "PTVectors.h"
+#include <cstddef>
 #include <lua.hpp>
 
 #if (LUA_VERSION_NUM != 503)
@@ -44,5 +45,39 @@ TVector luaToTVector(lua_State *L, int arg);
 PVector luaToPVector(lua_State *L, int arg);
 TVector luaCheckTVector(lua_State *L, int arg);
 PVector luaCheckPVector(lua_State *L, int arg);
+TVector& luaCheckTVectorRef(lua_State *L, int arg);
+PVector& luaCheckPVectorRef(lua_State *L, int arg);
+
+// Views of host vector buffers
+// A view gives Lua bounds-checked access to an existing buffer of TVectors or
+// PVectors without copying it. luaPush*VectorView pushes the view and returns
+// its handle. The view stays alive until luaReleaseVectorView, even if Lua
+// drops every reference to it, so the handle can be kept as long as needed.
+//
+// std::vector<TVector> positions;
+// LuaVectorView *view = luaPushTVectorView(L, positions.data(), positions.size());
+// lua_setglobal(L, "positions");
+// ...
+// luaUpdateVectorView(view, positions.data(), positions.size()); // after positions reallocates
+// luaReleaseVectorView(L, view); // before positions goes away
+//
+// Once released, any use of the view from Lua raises an error and the handle
+// must not be used again.
+struct LuaVectorView
+{
+ void *data;
+ std::size_t size;
+ bool isTVector;
+ bool readOnly;
+ int ref;
+};
+
+LuaVectorView* luaPushTVectorView(lua_State *L, TVector *data, std::size_t n);
+LuaVectorView* luaPushPVectorView(lua_State *L, PVector *data, std::size_t n);
+LuaVectorView* luaPushTVectorView(lua_State *L, const TVector *data, std::size_t n);   // read only
+LuaVectorView* luaPushPVectorView(lua_State *L, const PVector *data, std::size_t n);   // read only
+void luaUpdateVectorView(LuaVectorView *view, TVector *data, std::size_t n);
+void luaUpdateVectorView(LuaVectorView *view, PVector *data, std::size_t n);
+void luaReleaseVectorView(lua_State *L, LuaVectorView *view);
 
 #endif // LUAVECTORLIB_H
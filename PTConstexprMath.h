@@ -0,0 +1,233 @@
+/******************************************************************************
+*
+*     PTConstexprMath.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTCONSTEXPRMATH_H_INCLUDED
+#define PTCONSTEXPRMATH_H_INCLUDED
+
+#include <cmath>
+#include <limits>
+
+// Compile-time sin, cos, atan2, sqrt and hypot.
+// The <cmath> functions aren't constexpr in standard C++, so PTVectors.h calls
+// the vector* versions at the bottom of this file. They evaluate the
+// constexpr* implementations when the compiler is evaluating a constant
+// expression, and call <cmath> exactly as before otherwise, so runtime
+// results don't change and constants like
+//
+// constexpr PVector northEast = 45_deg;
+//
+// are folded by any compiler, not just those that treat libm as constexpr.
+// The implementations work in double and are within an ulp or two of libm,
+// so they round to the same float almost always.
+//
+// Spotting constant evaluation needs __builtin_is_constant_evaluated (GCC 9,
+// Clang 9, MSVC 19.25 and later). Without it the vector* functions always
+// call <cmath>, which is what PTVectors.h did before.
+
+#if defined(__has_builtin)
+ #if __has_builtin(__builtin_is_constant_evaluated)
+  #define PTVECTORS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+ #endif
+#endif
+#if !defined(PTVECTORS_CONSTANT_EVALUATED) && ((defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+ #define PTVECTORS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#if !defined(PTVECTORS_CONSTANT_EVALUATED)
+ #define PTVECTORS_CONSTANT_EVALUATED() false
+#endif
+
+// pi/2 split so k*pi/2 can be taken off exactly for any k below 2^20
+constexpr double constexprPiOver2High = 1.57079632673412561417e+00;
+constexpr double constexprPiOver2Low = 6.07710050650619224932e-11;
+constexpr double constexprPiOver2 = 1.57079632679489661923;
+constexpr double constexprPi = 3.14159265358979323846;
+
+constexpr double constexprFabs(double x)
+{
+ return (x < 0) ? -x : x + 0.0;
+}
+
+// round to nearest; doubles this large are already whole
+constexpr double constexprRound(double x)
+{
+ return (constexprFabs(x) >= 4503599627370496.0) ? x
+        : (x < 0) ? -double(static_cast<long long>(0.5 - x))
+        : double(static_cast<long long>(x + 0.5));
+}
+
+// Taylor series on |r| <= pi/4, summed smallest term first
+constexpr double constexprSinSeries(double r2, double term, int n)
+{
+ return (n > 12) ? term : term + constexprSinSeries(r2, -term*r2/((2*n)*(2*n + 1)), n + 1);
+}
+
+constexpr double constexprCosSeries(double r2, double term, int n)
+{
+ return (n > 12) ? term : term + constexprCosSeries(r2, -term*r2/((2*n - 1)*(2*n)), n + 1);
+}
+
+// sin(k*pi/2 + r) by the quadrant k mod 4
+constexpr double constexprSinQuadrant(double r, int quadrant)
+{
+ return (quadrant == 0) ? constexprSinSeries(r*r, r, 1)
+        : (quadrant == 1) ? constexprCosSeries(r*r, 1.0, 1)
+        : (quadrant == 2) ? -constexprSinSeries(r*r, r, 1)
+        : -constexprCosSeries(r*r, 1.0, 1);
+}
+
+// k mod 4 for a whole k of either sign
+constexpr int constexprQuadrant(double k)
+{
+ return int(k - 4.0*constexprRound(k/4.0 - 0.375));
+}
+
+// x = k*pi/2 + r, and cos is sin one quadrant on
+constexpr double constexprSinReduced(double x, double k, int shift)
+{
+ return constexprSinQuadrant((x - k*constexprPiOver2High) - k*constexprPiOver2Low, (constexprQuadrant(k) + shift) % 4);
+}
+
+constexpr double constexprSin(double x)
+{
+ return constexprSinReduced(x, constexprRound(x/constexprPiOver2), 0);
+}
+
+constexpr double constexprCos(double x)
+{
+ return constexprSinReduced(x, constexprRound(x/constexprPiOver2), 1);
+}
+
+// atan on |t| <= tan(pi/8), where 23 terms reach double precision
+constexpr double constexprAtanSeries(double t2, double power, int n)
+{
+ return (n > 22) ? power/(2*n + 1) : power/(2*n + 1) - constexprAtanSeries(t2, power*t2, n + 1);
+}
+
+constexpr double constexprAtanSmall(double t)
+{
+ return t*constexprAtanSeries(t*t, 1.0, 0);
+}
+
+// atan(z) for 0 <= z <= 1, using atan(z) = pi/4 + atan((z - 1)/(z + 1)) above tan(pi/8)
+constexpr double constexprAtanUnit(double z)
+{
+ return (z > 0.41421356237309504880) ? constexprPi/4 + constexprAtanSmall((z - 1)/(z + 1)) : constexprAtanSmall(z);
+}
+
+constexpr double constexprAtanPositive(double z)
+{
+ return (z > 1) ? constexprPiOver2 - constexprAtanUnit(1/z) : constexprAtanUnit(z);
+}
+
+constexpr double constexprAtan(double z)
+{
+ return (z < 0) ? -constexprAtanPositive(-z) : constexprAtanPositive(z);
+}
+
+constexpr double constexprAtan2(double y, double x)
+{
+ return (x > 0) ? constexprAtan(y/x)
+        : (x < 0) ? ((y < 0) ? constexprAtan(y/x) - constexprPi : constexprAtan(y/x) + constexprPi)
+        : (y > 0) ? constexprPiOver2
+        : (y < 0) ? -constexprPiOver2
+        : 0.0;
+}
+
+// Newton's method, starting above the root so each step comes down, and
+// stopping once a step no longer does. It runs in long double, where there is
+// one, so the final rounding to double is almost always the correct one.
+constexpr long double constexprSqrtNewton(long double x, long double estimate)
+{
+ return (0.5L*(estimate + x/estimate) >= estimate) ? estimate : constexprSqrtNewton(x, 0.5L*(estimate + x/estimate));
+}
+
+// x is scaled by powers of 2^64 into [2^-64, 2^64] to keep the Newton steps few
+constexpr long double constexprSqrtScaled(long double x)
+{
+ return (x > 18446744073709551616.0L) ? 4294967296.0L*constexprSqrtScaled(x/18446744073709551616.0L)
+        : (x < 5.42101086242752217004e-20L) ? constexprSqrtScaled(x*18446744073709551616.0L)/4294967296.0L
+        : constexprSqrtNewton(x, 0.5L*(x + 1));
+}
+
+constexpr double constexprSqrt(double x)
+{
+ return (x < 0 || x != x) ? std::numeric_limits<double>::quiet_NaN()
+        : (x == 0 || x == std::numeric_limits<double>::infinity()) ? x
+        : double(constexprSqrtScaled(x));
+}
+
+// the larger magnitude is factored out so the squares can't overflow
+constexpr double constexprHypotOrdered(double large, double small)
+{
+ return (large == 0) ? 0.0 : large*constexprSqrt(1 + (small/large)*(small/large));
+}
+
+constexpr double constexprHypot(double x, double y)
+{
+ return (constexprFabs(x) < constexprFabs(y)) ? constexprHypotOrdered(constexprFabs(y), constexprFabs(x))
+        : constexprHypotOrdered(constexprFabs(x), constexprFabs(y));
+}
+
+// The calls PTVectors.h makes. Each returns whatever the <cmath> call it
+// replaces returned, so float arguments still go through the double libm
+// functions at runtime.
+
+template <typename T>
+constexpr auto vectorSin(T x) -> decltype(sin(x))
+{
+ return PTVECTORS_CONSTANT_EVALUATED() ? decltype(sin(x))(constexprSin(x)) : sin(x);
+}
+
+template <typename T>
+constexpr auto vectorCos(T x) -> decltype(cos(x))
+{
+ return PTVECTORS_CONSTANT_EVALUATED() ? decltype(cos(x))(constexprCos(x)) : cos(x);
+}
+
+template <typename T, typename U>
+constexpr auto vectorAtan2(T y, U x) -> decltype(atan2(y, x))
+{
+ return PTVECTORS_CONSTANT_EVALUATED() ? decltype(atan2(y, x))(constexprAtan2(y, x)) : atan2(y, x);
+}
+
+template <typename T, typename U>
+constexpr auto vectorHypot(T x, U y) -> decltype(hypot(x, y))
+{
+ return PTVECTORS_CONSTANT_EVALUATED() ? decltype(hypot(x, y))(constexprHypot(x, y)) : hypot(x, y);
+}
+
+template <typename T>
+constexpr auto vectorFabs(T x) -> decltype(fabs(x))
+{
+ return PTVECTORS_CONSTANT_EVALUATED() ? decltype(fabs(x))(constexprFabs(x)) : fabs(x);
+}
+
+template <typename T>
+constexpr T vectorSqrt(T x)
+{
+ return PTVECTORS_CONSTANT_EVALUATED() ? T(constexprSqrt(x)) : std::sqrt(x);
+}
+
+#endif // PTCONSTEXPRMATH_H_INCLUDED
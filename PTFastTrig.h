@@ -0,0 +1,193 @@
+/******************************************************************************
+*
+*     PTFastTrig.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTFASTTRIG_H_INCLUDED
+#define PTFASTTRIG_H_INCLUDED
+
+#include "PTVectorSIMD.h"
+#include <cmath>
+
+// Polynomial sin, cos and atan2 accurate to about float precision, for angle
+// heavy code that doesn't need libm's last bit. They work in the argument's
+// own precision, and sincos shares one range reduction
+// between both results. The scalar and SIMDPack versions use the same
+// reduction and polynomials, so they agree.
+//
+// Absolute error against libm, for the same argument:
+//  fastSin, fastCos, fastSinCos   <= 1.2e-7 for float, 3e-9 for double,
+//                                 for |x| <= 1e4. The reduction by pi/2 loses
+//                                 accuracy beyond that, like simdSin
+//  fastAtan2                      <= 6e-7 rad for float, 2.5e-7 rad for double
+//                                 atan2(+-0, x < 0) gives +pi either way
+//
+// Defining PTVECTORS_FAST_TRIG before including PTVectors.h switches
+// unitVectorAtAngle, rotatePVectorAboutOrigin and planeVectorAngle (and so the
+// _deg literals at runtime) to these. Constant expressions still use the
+// exact versions in PTConstexprMath.h. The batch versions are in
+// PTVectorArrays.h.
+
+// The element type of a scalar or a SIMDPack, and constants of it
+template <typename V>
+struct FastTrigElement
+{
+ typedef V Type;
+ static V constant(double c) { return V(c); }
+};
+
+template <typename T>
+struct FastTrigElement<SIMDPack<T> >
+{
+ typedef T Type;
+ static SIMDPack<T> constant(double c) { return SIMDPack<T>::broadcast(T(c)); }
+};
+
+// Rounds to the nearest whole number while |x| < 2^22 for float, 2^51 for double
+template <typename V>
+inline V fastRound(V x)
+{
+ typedef FastTrigElement<V> E;
+ const V magic = E::constant((sizeof(typename E::Type) > sizeof(float)) ? 6755399441055744.0 : 12582912.0);
+ return (x + magic) - magic;
+}
+
+// x = k*pi/2 + r with |r| <= pi/4; pi/2 is split in three so that k*pi/2
+// comes off exactly
+template <typename V>
+inline V fastReduceQuarterTurns(V x, V k)
+{
+ typedef FastTrigElement<V> E;
+ return ((x - k*E::constant(1.5703125)) - k*E::constant(4.837512969970703125e-4)) - k*E::constant(7.54978995489188216e-8);
+}
+
+// minimax polynomials on |r| <= pi/4, as in Cephes sinf and cosf
+template <typename V>
+inline V fastSinPolynomial(V r)
+{
+ typedef FastTrigElement<V> E;
+ const V z = r*r;
+ return r + r*z*((E::constant(-1.9515295891e-4)*z + E::constant(8.3321608736e-3))*z - E::constant(1.6666654611e-1));
+}
+
+template <typename V>
+inline V fastCosPolynomial(V r)
+{
+ typedef FastTrigElement<V> E;
+ const V z = r*r;
+ return E::constant(1) - E::constant(0.5)*z + z*z*((E::constant(2.443315711809948e-5)*z - E::constant(1.388731625493765e-3))*z + E::constant(4.166664568298827e-2));
+}
+
+// Odd minimax polynomial for atan on [0, 1], absolute error 2.5e-7
+template <typename V>
+inline V fastAtanUnit(V t)
+{
+ typedef FastTrigElement<V> E;
+ const V z = t*t;
+ V p = E::constant(6.81179301089947299e-03);
+ p = p*z - E::constant(3.36042197168465946e-02);
+ p = p*z + E::constant(7.96236713889578716e-02);
+ p = p*z - E::constant(1.32333420422759213e-01);
+ p = p*z + E::constant(1.98078155510651266e-01);
+ p = p*z - E::constant(3.33173680532316369e-01);
+ p = p*z + E::constant(9.99996111549142384e-01);
+ return t*p;
+}
+
+// The quadrant k mod 4 swaps and negates the two polynomials
+template <typename S>
+inline void fastSinCos(S x, S &sine, S &cosine)
+{
+ const S k = fastRound(x*S(0.63661977236758134308));
+ const S r = fastReduceQuarterTurns(x, k);
+ const S s = fastSinPolynomial(r), c = fastCosPolynomial(r);
+ const int quadrant = (std::fabs(k) < S(1073741824)) ? int(k) : 0;
+ sine = (quadrant & 1) ? c : s;
+ cosine = (quadrant & 1) ? s : c;
+ if (quadrant & 2) sine = -sine;
+ if ((quadrant + 1) & 2) cosine = -cosine;
+}
+
+template <typename S>
+inline S fastSin(S x)
+{
+ S sine, cosine;
+ fastSinCos(x, sine, cosine);
+ return sine;
+}
+
+template <typename S>
+inline S fastCos(S x)
+{
+ S sine, cosine;
+ fastSinCos(x, sine, cosine);
+ return cosine;
+}
+
+// atan of the smaller of |y| and |x| over the larger, then unfolded into the
+// right octant
+template <typename S>
+inline S fastAtan2(S y, S x)
+{
+ const S ax = std::fabs(x), ay = std::fabs(y);
+ const S large = (ax < ay) ? ay : ax, small = (ax < ay) ? ax : ay;
+ S a = (large == 0) ? S(0) : fastAtanUnit(small/large);
+ if (ax < ay) a = S(1.57079632679489661923) - a;
+ if (x < 0) a = S(3.14159265358979323846) - a;
+ return (y < 0) ? -a : a;
+}
+
+// The same for a pack of angles. With q = k mod 4 the polynomials swap for odd
+// q, sin is negated for q = 2, 3 and cos for q = 1, 2.
+template <typename T>
+inline void simdFastSinCos(SIMDPack<T> x, SIMDPack<T> &sine, SIMDPack<T> &cosine)
+{
+ typedef SIMDPack<T> P;
+ const P zero = P::broadcast(0);
+ const P k = fastRound(x*P::broadcast(T(0.63661977236758134308)));
+ const P r = fastReduceQuarterTurns(x, k);
+ const P s = fastSinPolynomial(r), c = fastCosPolynomial(r);
+
+ const P q = k - P::broadcast(4)*fastRound(k*P::broadcast(T(0.25)) - P::broadcast(T(0.375)));
+ const P odd = k - P::broadcast(2)*fastRound(k*P::broadcast(T(0.5)) - P::broadcast(T(0.25)));
+ const P qFromMiddle = q - P::broadcast(T(1.5));
+ sine = simdSelect(simdLessThan(P::broadcast(T(0.5)), odd), c, s);
+ cosine = simdSelect(simdLessThan(P::broadcast(T(0.5)), odd), s, c);
+ sine = simdSelect(simdLessThan(P::broadcast(T(1.5)), q), zero - sine, sine);
+ cosine = simdSelect(simdLessThan(simdMax(qFromMiddle, zero - qFromMiddle), P::broadcast(1)), zero - cosine, cosine);
+}
+
+template <typename T>
+inline SIMDPack<T> simdFastAtan2(SIMDPack<T> y, SIMDPack<T> x)
+{
+ typedef SIMDPack<T> P;
+ const P zero = P::broadcast(0);
+ const P ax = simdMax(x, zero - x), ay = simdMax(y, zero - y);
+ const P large = simdMax(ax, ay), small = simdMin(ax, ay);
+ P a = simdSelect(simdIsZero(large), zero, fastAtanUnit(small/large));
+ a = simdSelect(simdLessThan(ax, ay), P::broadcast(T(1.57079632679489661923)) - a, a);
+ a = simdSelect(simdLessThan(x, zero), P::broadcast(T(3.14159265358979323846)) - a, a);
+ return simdSelect(simdLessThan(y, zero), zero - a, a);
+}
+
+#endif // PTFASTTRIG_H_INCLUDED
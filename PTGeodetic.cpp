@@ -0,0 +1,232 @@
+/******************************************************************************
+*
+*     PTGeodetic.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTGeodetic.h"
+#include <algorithm>
+#include <cmath>
+
+typedef SIMDPack<double> Pack;
+
+// e^2 = f(2 - f)
+static double eccentricitySquared(const Ellipsoid &ellipsoid)
+{
+ return ellipsoid.flattening*(2.0 - ellipsoid.flattening);
+}
+
+// ENU lanes may be float, the arithmetic is always double
+template <typename S>
+static void storeLanes(Pack p, S *out)
+{
+ double lanes[Pack::width];
+ p.store(lanes);
+ for (std::size_t j = 0; j < Pack::width; ++j) out[j] = S(lanes[j]);
+}
+
+template <typename S>
+static Pack loadLanes(const S *in)
+{
+ double lanes[Pack::width];
+ for (std::size_t j = 0; j < Pack::width; ++j) lanes[j] = double(in[j]);
+ return Pack::load(lanes);
+}
+
+// The prime vertical radius of curvature N = a/sqrt(1 - e^2 sin^2(lat)) and
+// then ((N + h)cos(lat)cos(lon), (N + h)cos(lat)sin(lon), (N(1 - e^2) + h)sin(lat))
+static void geodeticPackToECEF(Pack latitude, Pack longitude, Pack altitude, const Ellipsoid &ellipsoid, Pack &x, Pack &y, Pack &z)
+{
+ const double e2 = eccentricitySquared(ellipsoid);
+ const Pack sinLat = simdSin(latitude), cosLat = simdCos(latitude);
+ const Pack n = Pack::broadcast(ellipsoid.semiMajorAxis)*simdRecipSqrt(Pack::broadcast(1.0) - Pack::broadcast(e2)*sinLat*sinLat);
+ const Pack horizontal = (n + altitude)*cosLat;
+ x = horizontal*simdCos(longitude);
+ y = horizontal*simdSin(longitude);
+ z = (n*Pack::broadcast(1.0 - e2) + altitude)*sinLat;
+}
+
+TVectorD geodeticToECEF(const GeodeticPosition &p, const Ellipsoid &ellipsoid)
+{
+ const double e2 = eccentricitySquared(ellipsoid);
+ const double sinLat = std::sin(p.latitude), cosLat = std::cos(p.latitude);
+ const double n = ellipsoid.semiMajorAxis/std::sqrt(1.0 - e2*sinLat*sinLat);
+ const double horizontal = (n + p.altitude)*cosLat;
+ return {horizontal*std::cos(p.longitude), horizontal*std::sin(p.longitude), (n*(1.0 - e2) + p.altitude)*sinLat};
+}
+
+// Heikkinen's closed form, as given by Zhu (1994). It breaks down only within
+// a few tens of kilometres of the centre of the Earth.
+GeodeticPosition ecefToGeodetic(const TVectorD &ecef, const Ellipsoid &ellipsoid)
+{
+ const double a = ellipsoid.semiMajorAxis;
+ const double b = a*(1.0 - ellipsoid.flattening);
+ const double a2 = a*a, b2 = b*b;
+ const double e2 = eccentricitySquared(ellipsoid);
+ const double ep2 = (a2 - b2)/b2;
+ const double x = ecef.xEast, y = ecef.yNorth, z = ecef.zUp;
+ const double p2 = x*x + y*y, z2 = z*z;
+ const double p = std::sqrt(p2);
+
+ const double f = 54.0*b2*z2;
+ const double g = p2 + (1.0 - e2)*z2 - e2*(a2 - b2);
+ const double c = e2*e2*f*p2/(g*g*g);
+ const double s = std::cbrt(1.0 + c + std::sqrt(c*c + 2.0*c));
+ const double k = s + 1.0 + 1.0/s;
+ const double pk = f/(3.0*k*k*g*g);
+ const double q = std::sqrt(1.0 + 2.0*e2*e2*pk);
+ // zero on the polar axis, where rounding can leave it just below
+ const double r0Squared = 0.5*a2*(1.0 + 1.0/q) - pk*(1.0 - e2)*z2/(q*(1.0 + q)) - 0.5*pk*p2;
+ const double r0 = -pk*e2*p/(1.0 + q) + std::sqrt(std::max(r0Squared, 0.0));
+ const double t = p - e2*r0;
+ const double u = std::sqrt(t*t + z2);
+ const double v = std::sqrt(t*t + (1.0 - e2)*z2);
+ const double z0 = b2*z/(a*v);
+ return {std::atan2(z + ep2*z0, p), std::atan2(y, x), u*(1.0 - b2/(a*v))};
+}
+
+void geodeticToECEF(const GeodeticArray &in, TVectorArrayD &out, VectorThreadPool *pool, const Ellipsoid &ellipsoid)
+{
+ const std::size_t n = in.size();
+ out.resize(n);
+ forEachBlock(n, geodeticBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+  {
+   Pack x, y, z;
+   geodeticPackToECEF(Pack::load(&in.latitude[i]), Pack::load(&in.longitude[i]), Pack::load(&in.altitude[i]), ellipsoid, x, y, z);
+   x.store(&out.xEast[i]);
+   y.store(&out.yNorth[i]);
+   z.store(&out.zUp[i]);
+  }
+  for (; i < end; ++i) out.set(i, geodeticToECEF(in[i], ellipsoid));
+ });
+}
+
+void ecefToGeodetic(const TVectorArrayD &in, GeodeticArray &out, VectorThreadPool *pool, const Ellipsoid &ellipsoid)
+{
+ const std::size_t n = in.size();
+ out.resize(n);
+ forEachBlock(n, geodeticBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  for (std::size_t i = begin; i < end; ++i) out.set(i, ecefToGeodetic(in[i], ellipsoid));
+ });
+}
+
+LocalENUFrame::LocalENUFrame(const GeodeticPosition &origin, const Ellipsoid &ellipsoid)
+ : ellipsoid(ellipsoid), origin(origin), originECEF(geodeticToECEF(origin, ellipsoid))
+{
+ const double sinLat = std::sin(origin.latitude), cosLat = std::cos(origin.latitude);
+ const double sinLon = std::sin(origin.longitude), cosLon = std::cos(origin.longitude);
+ ecefToENURotation = {{-sinLon, cosLon, 0.0},
+                      {-sinLat*cosLon, -sinLat*sinLon, cosLat},
+                      {cosLat*cosLon, cosLat*sinLon, sinLat}};
+}
+
+// The offset from the origin is taken before rotating, so the result doesn't
+// lose precision to the size of the ECEF coordinates
+template <typename S>
+static void ecefPackToENU(const LocalENUFrame &frame, Pack x, Pack y, Pack z, BasicTVectorArray<S> &out, std::size_t i)
+{
+ const Matrix3D &r = frame.ecefToENURotation;
+ x = x - Pack::broadcast(frame.originECEF.xEast);
+ y = y - Pack::broadcast(frame.originECEF.yNorth);
+ z = z - Pack::broadcast(frame.originECEF.zUp);
+ storeLanes(Pack::broadcast(r.xRow.xEast)*x + Pack::broadcast(r.xRow.yNorth)*y + Pack::broadcast(r.xRow.zUp)*z, &out.xEast[i]);
+ storeLanes(Pack::broadcast(r.yRow.xEast)*x + Pack::broadcast(r.yRow.yNorth)*y + Pack::broadcast(r.yRow.zUp)*z, &out.yNorth[i]);
+ storeLanes(Pack::broadcast(r.zRow.xEast)*x + Pack::broadcast(r.zRow.yNorth)*y + Pack::broadcast(r.zRow.zUp)*z, &out.zUp[i]);
+}
+
+template <typename S>
+void LocalENUFrame::ecefToENU(const TVectorArrayD &in, BasicTVectorArray<S> &out, VectorThreadPool *pool) const
+{
+ const std::size_t n = in.size();
+ out.resize(n);
+ forEachBlock(n, geodeticBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+   ecefPackToENU(*this, Pack::load(&in.xEast[i]), Pack::load(&in.yNorth[i]), Pack::load(&in.zUp[i]), out, i);
+  for (; i < end; ++i) out.set(i, ecefToENU<S>(in[i]));
+ });
+}
+
+// ECEF = R^T enu + origin, the columns of R being the rows of its transpose
+template <typename S>
+void LocalENUFrame::enuToECEF(const BasicTVectorArray<S> &in, TVectorArrayD &out, VectorThreadPool *pool) const
+{
+ const std::size_t n = in.size();
+ out.resize(n);
+ const Matrix3D &r = ecefToENURotation;
+ forEachBlock(n, geodeticBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+  {
+   const Pack e = loadLanes(&in.xEast[i]), nn = loadLanes(&in.yNorth[i]), u = loadLanes(&in.zUp[i]);
+   (Pack::broadcast(r.xRow.xEast)*e + Pack::broadcast(r.yRow.xEast)*nn + Pack::broadcast(r.zRow.xEast)*u + Pack::broadcast(originECEF.xEast)).store(&out.xEast[i]);
+   (Pack::broadcast(r.xRow.yNorth)*e + Pack::broadcast(r.yRow.yNorth)*nn + Pack::broadcast(r.zRow.yNorth)*u + Pack::broadcast(originECEF.yNorth)).store(&out.yNorth[i]);
+   (Pack::broadcast(r.xRow.zUp)*e + Pack::broadcast(r.yRow.zUp)*nn + Pack::broadcast(r.zRow.zUp)*u + Pack::broadcast(originECEF.zUp)).store(&out.zUp[i]);
+  }
+  for (; i < end; ++i) out.set(i, enuToECEF(in[i]));
+ });
+}
+
+template <typename S>
+void LocalENUFrame::geodeticToENU(const GeodeticArray &in, BasicTVectorArray<S> &out, VectorThreadPool *pool) const
+{
+ const std::size_t n = in.size();
+ out.resize(n);
+ forEachBlock(n, geodeticBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+  {
+   Pack x, y, z;
+   geodeticPackToECEF(Pack::load(&in.latitude[i]), Pack::load(&in.longitude[i]), Pack::load(&in.altitude[i]), ellipsoid, x, y, z);
+   ecefPackToENU(*this, x, y, z, out, i);
+  }
+  for (; i < end; ++i) out.set(i, geodeticToENU<S>(in[i]));
+ });
+}
+
+template <typename S>
+void LocalENUFrame::enuToGeodetic(const BasicTVectorArray<S> &in, GeodeticArray &out, VectorThreadPool *pool) const
+{
+ const std::size_t n = in.size();
+ out.resize(n);
+ forEachBlock(n, geodeticBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  for (std::size_t i = begin; i < end; ++i) out.set(i, enuToGeodetic(in[i]));
+ });
+}
+
+#define PTGEODETIC_INSTANTIATE(S) \
+ template void LocalENUFrame::ecefToENU(const TVectorArrayD&, BasicTVectorArray<S>&, VectorThreadPool*) const; \
+ template void LocalENUFrame::enuToECEF(const BasicTVectorArray<S>&, TVectorArrayD&, VectorThreadPool*) const; \
+ template void LocalENUFrame::geodeticToENU(const GeodeticArray&, BasicTVectorArray<S>&, VectorThreadPool*) const; \
+ template void LocalENUFrame::enuToGeodetic(const BasicTVectorArray<S>&, GeodeticArray&, VectorThreadPool*) const;
+
+PTGEODETIC_INSTANTIATE(float)
+PTGEODETIC_INSTANTIATE(double)
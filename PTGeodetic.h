@@ -0,0 +1,160 @@
+/******************************************************************************
+*
+*     PTGeodetic.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTGEODETIC_H_INCLUDED
+#define PTGEODETIC_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTMatrix.h"
+#include "PTVectorThreadPool.h"
+#include <cstddef>
+
+// Conversion between geodetic coordinates (latitude, longitude and height
+// above the ellipsoid), Earth-centred Earth-fixed (ECEF) coordinates and a
+// local east, north, up (ENU) frame about a fixed origin. Geodetic and ECEF
+// coordinates are always double; angles are in radians and distances in
+// metres. ECEF vectors keep x, y and z in xEast, yNorth and zUp.
+//
+// LocalENUFrame site(GeodeticPosition{degreesToRadians(51.5), 0.0, 45.0});
+// TVectorD offset = site.geodeticToENU<double>(fix);
+// site.geodeticToENU(fixes, enuPositions, &pool);
+//
+// The batch conversions work through the arrays in blocks of
+// geodeticBlockSize points, spread across a VectorThreadPool when one is given.
+// Geodetic to ECEF and ENU uses the SIMD sin and cos, and agrees with the
+// scalar functions to well under a micrometre. ECEF to geodetic uses
+// Heikkinen's closed form, with no iteration; a round trip comes back within
+// 1e-7m in height and 1e-15 rad in latitude anywhere above the Earth's core.
+
+static const std::size_t geodeticBlockSize = 4096;
+
+struct Ellipsoid
+{
+ double semiMajorAxis;
+ double flattening;
+};
+
+constexpr Ellipsoid wgs84Ellipsoid = {6378137.0, 1.0/298.257223563};
+
+struct GeodeticPosition
+{
+ double latitude;
+ double longitude;
+ double altitude;
+};
+
+// Structure of arrays of geodetic positions, like TVectorArray
+struct GeodeticArray
+{
+ ScalarArrayD latitude;
+ ScalarArrayD longitude;
+ ScalarArrayD altitude;
+
+ GeodeticArray() = default;
+ explicit GeodeticArray(std::size_t n) : latitude(n), longitude(n), altitude(n) {}
+
+ std::size_t size() const
+ {
+  return latitude.size();
+ }
+
+ void resize(std::size_t n)
+ {
+  latitude.resize(n);
+  longitude.resize(n);
+  altitude.resize(n);
+ }
+
+ GeodeticPosition operator[](std::size_t i) const
+ {
+  return {latitude[i], longitude[i], altitude[i]};
+ }
+
+ void set(std::size_t i, const GeodeticPosition &p)
+ {
+  latitude[i] = p.latitude;
+  longitude[i] = p.longitude;
+  altitude[i] = p.altitude;
+ }
+};
+
+TVectorD geodeticToECEF(const GeodeticPosition &p, const Ellipsoid &ellipsoid = wgs84Ellipsoid);
+GeodeticPosition ecefToGeodetic(const TVectorD &ecef, const Ellipsoid &ellipsoid = wgs84Ellipsoid);
+
+// batch versions, out may alias in
+void geodeticToECEF(const GeodeticArray &in, TVectorArrayD &out, VectorThreadPool *pool = nullptr, const Ellipsoid &ellipsoid = wgs84Ellipsoid);
+void ecefToGeodetic(const TVectorArrayD &in, GeodeticArray &out, VectorThreadPool *pool = nullptr, const Ellipsoid &ellipsoid = wgs84Ellipsoid);
+
+// An ENU frame about a fixed origin. The rotation from ECEF is worked out once,
+// so each point costs the ellipsoid terms and one matrix multiply.
+// ENU vectors may be float or double. Float keeps about a centimetre at
+// 100km from the origin.
+struct LocalENUFrame
+{
+ Ellipsoid ellipsoid;
+ GeodeticPosition origin;
+ TVectorD originECEF;
+ // rows east, north and up at the origin, in ECEF
+ Matrix3D ecefToENURotation;
+
+ explicit LocalENUFrame(const GeodeticPosition &origin, const Ellipsoid &ellipsoid = wgs84Ellipsoid);
+
+ template <typename S>
+ BasicTVector<S> ecefToENU(const TVectorD &ecef) const
+ {
+  return static_cast<BasicTVector<S> >(ecefToENURotation*(ecef - originECEF));
+ }
+
+ template <typename S>
+ TVectorD enuToECEF(const BasicTVector<S> &enu) const
+ {
+  return transpose(ecefToENURotation)*static_cast<TVectorD>(enu) + originECEF;
+ }
+
+ template <typename S>
+ BasicTVector<S> geodeticToENU(const GeodeticPosition &p) const
+ {
+  return ecefToENU<S>(geodeticToECEF(p, ellipsoid));
+ }
+
+ template <typename S>
+ GeodeticPosition enuToGeodetic(const BasicTVector<S> &enu) const
+ {
+  return ecefToGeodetic(enuToECEF(enu), ellipsoid);
+ }
+
+ // batch versions, instantiated for float and double ENU arrays in PTGeodetic.cpp
+ template <typename S>
+ void ecefToENU(const TVectorArrayD &in, BasicTVectorArray<S> &out, VectorThreadPool *pool = nullptr) const;
+ template <typename S>
+ void enuToECEF(const BasicTVectorArray<S> &in, TVectorArrayD &out, VectorThreadPool *pool = nullptr) const;
+ template <typename S>
+ void geodeticToENU(const GeodeticArray &in, BasicTVectorArray<S> &out, VectorThreadPool *pool = nullptr) const;
+ template <typename S>
+ void enuToGeodetic(const BasicTVectorArray<S> &in, GeodeticArray &out, VectorThreadPool *pool = nullptr) const;
+};
+
+#endif // PTGEODETIC_H_INCLUDED
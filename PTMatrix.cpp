@@ -0,0 +1,118 @@
+/******************************************************************************
+*
+*     PTMatrix.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTMatrix.h"
+
+template <typename S>
+void transformVectorArray(const BasicMatrix3<S> &m, const BasicTVectorArray<S> &in, BasicTVectorArray<S> &out)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = in.size();
+ out.resize(n);
+
+ const Pack m00 = Pack::broadcast(m.xRow.xEast), m01 = Pack::broadcast(m.xRow.yNorth), m02 = Pack::broadcast(m.xRow.zUp);
+ const Pack m10 = Pack::broadcast(m.yRow.xEast), m11 = Pack::broadcast(m.yRow.yNorth), m12 = Pack::broadcast(m.yRow.zUp);
+ const Pack m20 = Pack::broadcast(m.zRow.xEast), m21 = Pack::broadcast(m.zRow.yNorth), m22 = Pack::broadcast(m.zRow.zUp);
+
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack x = Pack::load(&in.xEast[i]), y = Pack::load(&in.yNorth[i]), z = Pack::load(&in.zUp[i]);
+  (m00*x + m01*y + m02*z).store(&out.xEast[i]);
+  (m10*x + m11*y + m12*z).store(&out.yNorth[i]);
+  (m20*x + m21*y + m22*z).store(&out.zUp[i]);
+ }
+ for (; i < n; ++i) out.set(i, m*in[i]);
+}
+
+template <typename S>
+void transformVectorArray(const BasicAffineTransform<S> &t, const BasicTVectorArray<S> &in, BasicTVectorArray<S> &out)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = in.size();
+ out.resize(n);
+
+ const Pack m00 = Pack::broadcast(t.linear.xRow.xEast), m01 = Pack::broadcast(t.linear.xRow.yNorth), m02 = Pack::broadcast(t.linear.xRow.zUp);
+ const Pack m10 = Pack::broadcast(t.linear.yRow.xEast), m11 = Pack::broadcast(t.linear.yRow.yNorth), m12 = Pack::broadcast(t.linear.yRow.zUp);
+ const Pack m20 = Pack::broadcast(t.linear.zRow.xEast), m21 = Pack::broadcast(t.linear.zRow.yNorth), m22 = Pack::broadcast(t.linear.zRow.zUp);
+ const Pack tx = Pack::broadcast(t.translation.xEast);
+ const Pack ty = Pack::broadcast(t.translation.yNorth);
+ const Pack tz = Pack::broadcast(t.translation.zUp);
+
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack x = Pack::load(&in.xEast[i]), y = Pack::load(&in.yNorth[i]), z = Pack::load(&in.zUp[i]);
+  (m00*x + m01*y + m02*z + tx).store(&out.xEast[i]);
+  (m10*x + m11*y + m12*z + ty).store(&out.yNorth[i]);
+  (m20*x + m21*y + m22*z + tz).store(&out.zUp[i]);
+ }
+ for (; i < n; ++i) out.set(i, t*in[i]);
+}
+
+template <typename S>
+void transformVectorArray(const BasicAffineTransform<S> &t, const BasicTVector<S> *in, BasicTVector<S> *out, std::size_t n)
+{
+ for (std::size_t i = 0; i < n; ++i) out[i] = t*in[i];
+}
+
+template <typename S>
+void transformVectorArray(const BasicPlaneTransform<S> &t, const BasicPVectorArray<S> &in, BasicPVectorArray<S> &out)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = in.size();
+ out.resize(n);
+
+ const Pack m00 = Pack::broadcast(t.uRow.u), m01 = Pack::broadcast(t.uRow.v);
+ const Pack m10 = Pack::broadcast(t.vRow.u), m11 = Pack::broadcast(t.vRow.v);
+ const Pack tu = Pack::broadcast(t.translation.u);
+ const Pack tv = Pack::broadcast(t.translation.v);
+
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack u = Pack::load(&in.u[i]), v = Pack::load(&in.v[i]);
+  (m00*u + m01*v + tu).store(&out.u[i]);
+  (m10*u + m11*v + tv).store(&out.v[i]);
+ }
+ for (; i < n; ++i) out.set(i, t*in[i]);
+}
+
+template <typename S>
+void transformDirectionArray(const BasicAffineTransform<S> &t, const BasicTVectorArray<S> &in, BasicTVectorArray<S> &out)
+{
+ transformVectorArray(t.linear, in, out);
+}
+
+#define PTMATRIX_INSTANTIATE(S) \
+ template void transformVectorArray(const BasicMatrix3<S>&, const BasicTVectorArray<S>&, BasicTVectorArray<S>&); \
+ template void transformVectorArray(const BasicAffineTransform<S>&, const BasicTVectorArray<S>&, BasicTVectorArray<S>&); \
+ template void transformVectorArray(const BasicAffineTransform<S>&, const BasicTVector<S>*, BasicTVector<S>*, std::size_t); \
+ template void transformVectorArray(const BasicPlaneTransform<S>&, const BasicPVectorArray<S>&, BasicPVectorArray<S>&); \
+ template void transformDirectionArray(const BasicAffineTransform<S>&, const BasicTVectorArray<S>&, BasicTVectorArray<S>&);
+
+PTMATRIX_INSTANTIATE(float)
+PTMATRIX_INSTANTIATE(double)
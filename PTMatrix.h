@@ -0,0 +1,420 @@
+/******************************************************************************
+*
+*     PTMatrix.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTMATRIX_H_INCLUDED
+#define PTMATRIX_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTVectorRotation.h"
+#include "PTQuaternion.h"
+#include <cstddef>
+
+// Matrices for changes of frame
+// Matrix3 is a linear map of TVectors, AffineTransform a Matrix3 followed by a
+// translation (the top three rows of a 4x4 whose bottom row is 0 0 0 1), and
+// PlaneTransform the same for PVectors (2x3). operator* applies a transform
+// to a vector or composes two transforms, so a chain of frame changes becomes
+// one transform that is applied in a single pass over an array.
+//
+// AffineTransform toWorld = translationTransform(position) * rotationToAffine(heading);
+// AffineTransform toCamera = inverse(cameraToWorld) * toWorld;  // body first, then camera
+// transformVectorArray(toCamera, bodyPoints, cameraPoints);
+
+template <typename S>
+struct BasicMatrix3
+{
+ typedef S Scalar;
+
+ BasicTVector<S> xRow;
+ BasicTVector<S> yRow;
+ BasicTVector<S> zRow;
+
+ template <typename U>
+ constexpr explicit operator BasicMatrix3<U>() const
+ {
+  return {static_cast<BasicTVector<U> >(xRow), static_cast<BasicTVector<U> >(yRow), static_cast<BasicTVector<U> >(zRow)};
+ }
+};
+
+typedef BasicMatrix3<VectorPrecision> Matrix3;
+typedef BasicMatrix3<double> Matrix3D;
+
+template <typename S>
+struct BasicAffineTransform
+{
+ typedef S Scalar;
+
+ BasicMatrix3<S> linear;
+ BasicTVector<S> translation;
+
+ template <typename U>
+ constexpr explicit operator BasicAffineTransform<U>() const
+ {
+  return {static_cast<BasicMatrix3<U> >(linear), static_cast<BasicTVector<U> >(translation)};
+ }
+};
+
+typedef BasicAffineTransform<VectorPrecision> AffineTransform;
+typedef BasicAffineTransform<double> AffineTransformD;
+
+template <typename S>
+struct BasicPlaneTransform
+{
+ typedef S Scalar;
+
+ BasicPVector<S> uRow;
+ BasicPVector<S> vRow;
+ BasicPVector<S> translation;
+
+ template <typename U>
+ constexpr explicit operator BasicPlaneTransform<U>() const
+ {
+  return {static_cast<BasicPVector<U> >(uRow), static_cast<BasicPVector<U> >(vRow), static_cast<BasicPVector<U> >(translation)};
+ }
+};
+
+typedef BasicPlaneTransform<VectorPrecision> PlaneTransform;
+typedef BasicPlaneTransform<double> PlaneTransformD;
+
+// Matrix3
+template <typename S = VectorPrecision>
+constexpr BasicMatrix3<S> identityMatrix3()
+{
+ return {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+}
+
+// scales each axis by the matching component of scale
+template <typename S>
+constexpr BasicMatrix3<S> scaleMatrix3(const BasicTVector<S> &scale)
+{
+ return {{scale.xEast, 0.0, 0.0}, {0.0, scale.yNorth, 0.0}, {0.0, 0.0, scale.zUp}};
+}
+
+template <typename S>
+constexpr BasicMatrix3<S> transpose(const BasicMatrix3<S> &m)
+{
+ return {{m.xRow.xEast, m.yRow.xEast, m.zRow.xEast},
+         {m.xRow.yNorth, m.yRow.yNorth, m.zRow.yNorth},
+         {m.xRow.zUp, m.yRow.zUp, m.zRow.zUp}};
+}
+
+template <typename S>
+constexpr BasicTVector<S> operator*(const BasicMatrix3<S> &lhs, const BasicTVector<S> &rhs)
+{
+ return {lhs.xRow*rhs, lhs.yRow*rhs, lhs.zRow*rhs};
+}
+
+// operator* between matrices composes them: (a*b)*v == a*(b*v)
+template <typename S>
+constexpr BasicMatrix3<S> operator*(const BasicMatrix3<S> &lhs, const BasicMatrix3<S> &rhs)
+{
+ return transpose(BasicMatrix3<S>{lhs*BasicTVector<S>{rhs.xRow.xEast, rhs.yRow.xEast, rhs.zRow.xEast},
+                                  lhs*BasicTVector<S>{rhs.xRow.yNorth, rhs.yRow.yNorth, rhs.zRow.yNorth},
+                                  lhs*BasicTVector<S>{rhs.xRow.zUp, rhs.yRow.zUp, rhs.zRow.zUp}});
+}
+
+template <typename S>
+constexpr BasicMatrix3<S> operator*(const BasicMatrix3<S> &lhs, typename BasicMatrix3<S>::Scalar rhs)
+{
+ return {lhs.xRow*rhs, lhs.yRow*rhs, lhs.zRow*rhs};
+}
+
+template <typename S>
+constexpr bool operator==(const BasicMatrix3<S> &lhs, const BasicMatrix3<S> &rhs)
+{
+ return (lhs.xRow == rhs.xRow) && (lhs.yRow == rhs.yRow) && (lhs.zRow == rhs.zRow);
+}
+
+template <typename S>
+constexpr bool operator!=(const BasicMatrix3<S> &lhs, const BasicMatrix3<S> &rhs)
+{
+ return !(lhs == rhs);
+}
+
+template <typename S>
+constexpr S determinant(const BasicMatrix3<S> &m)
+{
+ return m.xRow*(m.yRow/m.zRow);
+}
+
+// The columns of the inverse are the cross products of pairs of rows, over the determinant
+template <typename S>
+constexpr BasicMatrix3<S> matrix3InverseFromCofactors(const BasicTVector<S> &c0, const BasicTVector<S> &c1, const BasicTVector<S> &c2, S recipDeterminant)
+{
+ return transpose(BasicMatrix3<S>{c0, c1, c2})*recipDeterminant;
+}
+
+// A singular matrix gives infinities and NaNs, like dividing by zero. Check
+// determinant() first if the matrix may be singular.
+template <typename S>
+constexpr BasicMatrix3<S> inverse(const BasicMatrix3<S> &m)
+{
+ return matrix3InverseFromCofactors(m.yRow/m.zRow, m.zRow/m.xRow, m.xRow/m.yRow, S(1.0/determinant(m)));
+}
+
+template <typename S>
+constexpr BasicMatrix3<S> rotationToMatrix3(const BasicTVectorRotation<S> &r)
+{
+ return {r.xRow, r.yRow, r.zRow};
+}
+
+// expects q to be a UNIT QUATERNION
+template <typename S>
+constexpr BasicMatrix3<S> quaternionToMatrix3(const BasicQuaternion<S> &q)
+{
+ return rotationToMatrix3(quaternionToRotation(q));
+}
+
+// AffineTransform
+template <typename S = VectorPrecision>
+constexpr BasicAffineTransform<S> identityTransform()
+{
+ return {identityMatrix3<S>(), {0.0, 0.0, 0.0}};
+}
+
+template <typename S>
+constexpr BasicAffineTransform<S> translationTransform(const BasicTVector<S> &offset)
+{
+ return {identityMatrix3<S>(), offset};
+}
+
+template <typename S>
+constexpr BasicAffineTransform<S> linearTransform(const BasicMatrix3<S> &m)
+{
+ return {m, {0.0, 0.0, 0.0}};
+}
+
+// TVectorRotation holds the same rows and translation, including the
+// rotation about a point
+template <typename S>
+constexpr BasicAffineTransform<S> rotationToAffine(const BasicTVectorRotation<S> &r)
+{
+ return {rotationToMatrix3(r), r.translation};
+}
+
+// expects q to be a UNIT QUATERNION
+template <typename S>
+constexpr BasicAffineTransform<S> rotationToAffine(const BasicQuaternion<S> &q)
+{
+ return linearTransform(quaternionToMatrix3(q));
+}
+
+// transforms a point, the translation included
+template <typename S>
+constexpr BasicTVector<S> operator*(const BasicAffineTransform<S> &lhs, const BasicTVector<S> &rhs)
+{
+ return lhs.linear*rhs + lhs.translation;
+}
+
+// transforms a direction or offset, which the translation doesn't move
+template <typename S>
+constexpr BasicTVector<S> transformDirection(const BasicAffineTransform<S> &t, const BasicTVector<S> &v)
+{
+ return t.linear*v;
+}
+
+// (a*b)*p == a*(b*p), so b is applied first
+template <typename S>
+constexpr BasicAffineTransform<S> operator*(const BasicAffineTransform<S> &lhs, const BasicAffineTransform<S> &rhs)
+{
+ return {lhs.linear*rhs.linear, lhs*rhs.translation};
+}
+
+template <typename S>
+constexpr bool operator==(const BasicAffineTransform<S> &lhs, const BasicAffineTransform<S> &rhs)
+{
+ return (lhs.linear == rhs.linear) && (lhs.translation == rhs.translation);
+}
+
+template <typename S>
+constexpr bool operator!=(const BasicAffineTransform<S> &lhs, const BasicAffineTransform<S> &rhs)
+{
+ return !(lhs == rhs);
+}
+
+template <typename S>
+constexpr BasicAffineTransform<S> affineInverseFromLinear(const BasicMatrix3<S> &linearInverse, const BasicTVector<S> &translation)
+{
+ return {linearInverse, -(linearInverse*translation)};
+}
+
+// as inverse(Matrix3), a singular transform gives infinities and NaNs
+template <typename S>
+constexpr BasicAffineTransform<S> inverse(const BasicAffineTransform<S> &t)
+{
+ return affineInverseFromLinear(inverse(t.linear), t.translation);
+}
+
+// The inverse of a transform made only of rotations and translations, whose
+// linear part is orthonormal. Cheaper than inverse() and exact to rounding.
+template <typename S>
+constexpr BasicAffineTransform<S> rigidInverse(const BasicAffineTransform<S> &t)
+{
+ return affineInverseFromLinear(transpose(t.linear), t.translation);
+}
+
+// To and from a row major 4x4 matrix, m[4*row + column], for graphics APIs.
+// The bottom row is taken to be 0 0 0 1 and isn't read.
+template <typename S>
+constexpr BasicAffineTransform<S> affineFromMatrix4(const S m[16])
+{
+ return {{{m[0], m[1], m[2]}, {m[4], m[5], m[6]}, {m[8], m[9], m[10]}}, {m[3], m[7], m[11]}};
+}
+
+template <typename S>
+void affineToMatrix4(const BasicAffineTransform<S> &t, S m[16])
+{
+ const BasicTVector<S> rows[3] = {t.linear.xRow, t.linear.yRow, t.linear.zRow};
+ const S translation[3] = {t.translation.xEast, t.translation.yNorth, t.translation.zUp};
+ for (int row = 0; row < 3; ++row)
+ {
+  m[4*row] = rows[row].xEast;
+  m[4*row + 1] = rows[row].yNorth;
+  m[4*row + 2] = rows[row].zUp;
+  m[4*row + 3] = translation[row];
+ }
+ m[12] = 0.0;
+ m[13] = 0.0;
+ m[14] = 0.0;
+ m[15] = 1.0;
+}
+
+// PlaneTransform
+template <typename S = VectorPrecision>
+constexpr BasicPlaneTransform<S> identityPlaneTransform()
+{
+ return {{1.0, 0.0}, {0.0, 1.0}, {0.0, 0.0}};
+}
+
+template <typename S>
+constexpr BasicPlaneTransform<S> planeTranslation(const BasicPVector<S> &offset)
+{
+ return {{1.0, 0.0}, {0.0, 1.0}, offset};
+}
+
+template <typename S>
+constexpr BasicPlaneTransform<S> planeScale(const BasicPVector<S> &scale)
+{
+ return {{scale.u, 0.0}, {0.0, scale.v}, {0.0, 0.0}};
+}
+
+// anti-clockwise, as rotatePVectorAboutOrigin
+template <typename S>
+constexpr BasicPlaneTransform<S> planeRotationFromUnit(const BasicPVector<S> &unit)
+{
+ return {{unit.u, -unit.v}, {unit.v, unit.u}, {0.0, 0.0}};
+}
+
+template <typename S = VectorPrecision>
+constexpr BasicPlaneTransform<S> planeRotation(typename BasicPVector<S>::Scalar angleRadians)
+{
+ return planeRotationFromUnit(unitVectorAtAngle<S>(angleRadians));
+}
+
+template <typename S>
+constexpr BasicPVector<S> operator*(const BasicPlaneTransform<S> &lhs, const BasicPVector<S> &rhs)
+{
+ return BasicPVector<S>{lhs.uRow*rhs, lhs.vRow*rhs} + lhs.translation;
+}
+
+template <typename S>
+constexpr BasicPVector<S> transformDirection(const BasicPlaneTransform<S> &t, const BasicPVector<S> &v)
+{
+ return {t.uRow*v, t.vRow*v};
+}
+
+// (a*b)*p == a*(b*p)
+template <typename S>
+constexpr BasicPlaneTransform<S> operator*(const BasicPlaneTransform<S> &lhs, const BasicPlaneTransform<S> &rhs)
+{
+ return {{lhs.uRow.u*rhs.uRow.u + lhs.uRow.v*rhs.vRow.u, lhs.uRow.u*rhs.uRow.v + lhs.uRow.v*rhs.vRow.v},
+         {lhs.vRow.u*rhs.uRow.u + lhs.vRow.v*rhs.vRow.u, lhs.vRow.u*rhs.uRow.v + lhs.vRow.v*rhs.vRow.v},
+         lhs*rhs.translation};
+}
+
+template <typename S>
+constexpr BasicPlaneTransform<S> planeRotationAboutPoint(const BasicPVector<S> &point, typename BasicPVector<S>::Scalar angleRadians)
+{
+ return planeTranslation(point)*planeRotation<S>(angleRadians)*planeTranslation(-point);
+}
+
+template <typename S>
+constexpr bool operator==(const BasicPlaneTransform<S> &lhs, const BasicPlaneTransform<S> &rhs)
+{
+ return (lhs.uRow == rhs.uRow) && (lhs.vRow == rhs.vRow) && (lhs.translation == rhs.translation);
+}
+
+template <typename S>
+constexpr bool operator!=(const BasicPlaneTransform<S> &lhs, const BasicPlaneTransform<S> &rhs)
+{
+ return !(lhs == rhs);
+}
+
+template <typename S>
+constexpr S determinant(const BasicPlaneTransform<S> &t)
+{
+ return t.uRow.u*t.vRow.v - t.uRow.v*t.vRow.u;
+}
+
+template <typename S>
+constexpr BasicPlaneTransform<S> planeInverseFromLinear(const BasicPVector<S> &uRow, const BasicPVector<S> &vRow, const BasicPVector<S> &translation)
+{
+ return {uRow, vRow, -BasicPVector<S>{uRow*translation, vRow*translation}};
+}
+
+template <typename S>
+constexpr BasicPlaneTransform<S> planeInverseScaled(const BasicPlaneTransform<S> &t, S recipDeterminant)
+{
+ return planeInverseFromLinear(BasicPVector<S>{t.vRow.v, -t.uRow.v}*recipDeterminant,
+                               BasicPVector<S>{-t.vRow.u, t.uRow.u}*recipDeterminant,
+                               t.translation);
+}
+
+// a singular transform gives infinities and NaNs
+template <typename S>
+constexpr BasicPlaneTransform<S> inverse(const BasicPlaneTransform<S> &t)
+{
+ return planeInverseScaled(t, S(1.0/determinant(t)));
+}
+
+// Batch transforms, out may alias in
+// Each element is bit-identical to the scalar operator*, unless the compiler
+// contracts the scalar version into FMA.
+// Instantiated for float and double in PTMatrix.cpp
+template <typename S>
+void transformVectorArray(const BasicMatrix3<S> &m, const BasicTVectorArray<S> &in, BasicTVectorArray<S> &out);
+template <typename S>
+void transformVectorArray(const BasicAffineTransform<S> &t, const BasicTVectorArray<S> &in, BasicTVectorArray<S> &out);
+template <typename S>
+void transformVectorArray(const BasicAffineTransform<S> &t, const BasicTVector<S> *in, BasicTVector<S> *out, std::size_t n);
+template <typename S>
+void transformVectorArray(const BasicPlaneTransform<S> &t, const BasicPVectorArray<S> &in, BasicPVectorArray<S> &out);
+
+// transformDirection() for every element
+template <typename S>
+void transformDirectionArray(const BasicAffineTransform<S> &t, const BasicTVectorArray<S> &in, BasicTVectorArray<S> &out);
+
+#endif // PTMATRIX_H_INCLUDED
@@ -0,0 +1,69 @@
+/******************************************************************************
+*
+*     PTQuaternion.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTQuaternion.h"
+
+template <typename S>
+void rotateTVectorArrayByQuaternion(const BasicTVectorArray<S> &in, const BasicQuaternion<S> &q, BasicTVectorArray<S> &out)
+{
+ quaternionToRotation(q).apply(in, out);
+}
+
+template <typename S>
+void rotateTVectorArrayByQuaternion(const BasicTVector<S> *in, const BasicQuaternion<S> &q, BasicTVector<S> *out, std::size_t n)
+{
+ quaternionToRotation(q).apply(in, out, n);
+}
+
+template <typename S>
+BasicQuaternion<S> quaternionSLERP(const BasicQuaternion<S> &unitStart,
+                                   const BasicQuaternion<S> &unitFinish,
+                                   typename BasicQuaternion<S>::Scalar slerp)
+{
+ S cosOmega = quaternionDot(unitStart, unitFinish);
+ BasicQuaternion<S> finish = unitFinish;
+ if (cosOmega < 0.0)
+ {
+  cosOmega = -cosOmega;
+  finish = -finish;
+ }
+
+ // sin(omega) is too small to divide by, and the arc is effectively straight
+ if (cosOmega > 0.9995) return unitVector(LERP(unitStart, finish, slerp));
+
+ S omega = acos(cosOmega);
+ S recipSinOmega = 1.0 / sin(omega);
+ return unitStart*S(sin(omega*(1.0 - slerp))*recipSinOmega)
+        + finish*S(sin(omega*slerp)*recipSinOmega);
+}
+
+#define PTQUATERNION_INSTANTIATE(S) \
+ template void rotateTVectorArrayByQuaternion(const BasicTVectorArray<S>&, const BasicQuaternion<S>&, BasicTVectorArray<S>&); \
+ template void rotateTVectorArrayByQuaternion(const BasicTVector<S>*, const BasicQuaternion<S>&, BasicTVector<S>*, std::size_t); \
+ template BasicQuaternion<S> quaternionSLERP(const BasicQuaternion<S>&, const BasicQuaternion<S>&, S);
+
+PTQUATERNION_INSTANTIATE(float)
+PTQUATERNION_INSTANTIATE(double)
@@ -0,0 +1,188 @@
+/******************************************************************************
+*
+*     PTQuaternion.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTQUATERNION_H_INCLUDED
+#define PTQUATERNION_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTVectorRotation.h"
+
+// Define Quaternion
+// w is the scalar part and v the vector part, so a rotation of theta about
+// a unit axis is {cos(theta/2), axis*sin(theta/2)}
+template <typename S>
+struct BasicQuaternion
+{
+ typedef S Scalar;
+
+ S w;
+ BasicTVector<S> v;
+
+ template <typename U>
+ constexpr explicit operator BasicQuaternion<U>() const
+ {
+  return {U(w), static_cast<BasicTVector<U> >(v)};
+ }
+};
+
+typedef BasicQuaternion<VectorPrecision> Quaternion;
+typedef BasicQuaternion<double> QuaternionD;
+
+// Like the vector literals, quaternion constants can be built at compile time
+// constexpr Quaternion yaw = quaternionFromAxisAngle(1_z, degreesToRadians(30));
+// Quaternion heading = yaw * pitch;   // pitch first, then yaw
+template <typename S>
+constexpr BasicQuaternion<S> quaternionFromAxisAngle(const BasicTVector<S> &axis, typename BasicTVector<S>::Scalar angleRadians)
+{
+ return {S(vectorCos(angleRadians*0.5)), axis*S(vectorSin(angleRadians*0.5))};
+}
+
+template <typename S = VectorPrecision>
+constexpr BasicQuaternion<S> identityQuaternion()
+{
+ return {1.0, {0.0, 0.0, 0.0}};
+}
+
+// Operators for Quaternion
+template <typename S>
+constexpr BasicQuaternion<S> operator-(const BasicQuaternion<S> &q)
+{
+ return {-q.w, -q.v};
+}
+
+// ~ will calculate the conjugate, which is the inverse rotation for unit quaternions
+template <typename S>
+constexpr BasicQuaternion<S> operator~(const BasicQuaternion<S> &q)
+{
+ return {q.w, -q.v};
+}
+
+template <typename S>
+constexpr BasicQuaternion<S> operator+(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+ return {lhs.w + rhs.w, lhs.v + rhs.v};
+}
+
+template <typename S>
+constexpr BasicQuaternion<S> operator-(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+ return {lhs.w - rhs.w, lhs.v - rhs.v};
+}
+
+// operator* between quaternions composes the rotations: (a*b) rotates by b, then by a
+template <typename S>
+constexpr BasicQuaternion<S> operator*(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+ return {lhs.w*rhs.w - lhs.v*rhs.v,
+         rhs.v*lhs.w + lhs.v*rhs.w + lhs.v/rhs.v};
+}
+
+template <typename S>
+constexpr BasicQuaternion<S> operator*(const BasicQuaternion<S> &lhs, typename BasicQuaternion<S>::Scalar rhs)
+{
+ return {lhs.w*rhs, lhs.v*rhs};
+}
+
+template <typename S>
+constexpr BasicQuaternion<S> operator*(typename BasicQuaternion<S>::Scalar lhs, const BasicQuaternion<S> &rhs)
+{
+ return rhs * lhs;
+}
+
+template <typename S>
+constexpr bool operator==(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+ return (lhs.w == rhs.w) && (lhs.v == rhs.v);
+}
+
+template <typename S>
+constexpr bool operator!=(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+ return (lhs.w != rhs.w) || (lhs.v != rhs.v);
+}
+
+template <typename S>
+constexpr S quaternionDot(const BasicQuaternion<S> &lhs, const BasicQuaternion<S> &rhs)
+{
+ return lhs.w*rhs.w + lhs.v*rhs.v;
+}
+
+// abs() lets unitVector() and LERP() from PTVectors.h work on quaternions,
+// so unitVector(q) is the normalised quaternion
+template <typename S>
+constexpr S abs(const BasicQuaternion<S> &q)
+{
+ return vectorSqrt(quaternionDot(q, q));
+}
+
+// expects q to be a UNIT QUATERNION
+// v' = v + w*t + qv/t, where t = 2*(qv/v)
+template <typename S>
+constexpr BasicTVector<S> rotateTVectorByQuaternion(const BasicTVector<S> &v, const BasicQuaternion<S> &q)
+{
+ return v + (q.v/v)*(2.0*q.w) + q.v/((q.v/v)*2.0);
+}
+
+// expects q to be a UNIT QUATERNION
+template <typename S>
+constexpr BasicTVectorRotation<S> quaternionToRotation(const BasicQuaternion<S> &q)
+{
+ return BasicTVectorRotation<S>({S(1.0 - 2.0*(q.v.yNorth*q.v.yNorth + q.v.zUp*q.v.zUp)),
+                                 S(2.0*(q.v.xEast*q.v.yNorth - q.w*q.v.zUp)),
+                                 S(2.0*(q.v.xEast*q.v.zUp + q.w*q.v.yNorth))},
+                                {S(2.0*(q.v.xEast*q.v.yNorth + q.w*q.v.zUp)),
+                                 S(1.0 - 2.0*(q.v.xEast*q.v.xEast + q.v.zUp*q.v.zUp)),
+                                 S(2.0*(q.v.yNorth*q.v.zUp - q.w*q.v.xEast))},
+                                {S(2.0*(q.v.xEast*q.v.zUp - q.w*q.v.yNorth)),
+                                 S(2.0*(q.v.yNorth*q.v.zUp + q.w*q.v.xEast)),
+                                 S(1.0 - 2.0*(q.v.xEast*q.v.xEast + q.v.yNorth*q.v.yNorth))});
+}
+
+// Batch rotation, out may alias in
+// The quaternion is converted to a matrix once, then applied with the SIMD kernel
+// Instantiated for float and double in PTQuaternion.cpp
+template <typename S>
+void rotateTVectorArrayByQuaternion(const BasicTVectorArray<S> &in, const BasicQuaternion<S> &q, BasicTVectorArray<S> &out);
+template <typename S>
+void rotateTVectorArrayByQuaternion(const BasicTVector<S> *in, const BasicQuaternion<S> &q, BasicTVector<S> *out, std::size_t n);
+
+// Interpolation between orientations
+// Both take the shortest path, flipping the sign of unitFinish if needed
+
+// normalised linear interpolation, cheap but not constant angular velocity
+template <typename S>
+constexpr BasicQuaternion<S> quaternionNLERP(const BasicQuaternion<S> &unitStart, const BasicQuaternion<S> &unitFinish, typename BasicQuaternion<S>::Scalar lerp)
+{
+ return unitVector(LERP(unitStart, (quaternionDot(unitStart, unitFinish) < 0.0) ? -unitFinish : unitFinish, lerp));
+}
+
+// expects UNIT QUATERNIONS
+// falls back to NLERP when the orientations are too close for a stable SLERP
+// NOT constexpr
+template <typename S>
+BasicQuaternion<S> quaternionSLERP(const BasicQuaternion<S> &unitStart, const BasicQuaternion<S> &unitFinish, typename BasicQuaternion<S>::Scalar slerp);
+
+#endif // PTQUATERNION_H_INCLUDED
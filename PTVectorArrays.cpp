@@ -0,0 +1,751 @@
+/******************************************************************************
+*
+*     PTVectorArrays.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorArrays.h"
+#include "PTFastTrig.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+// The kernels below all follow the same shape: a main loop over whole packs,
+// then the scalar operators from PTVectors.h for the remaining tail elements.
+
+template <typename S>
+static void addLanes(const BasicScalarArray<S> &a, const BasicScalarArray<S> &b, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+  (Pack::load(&a[i]) + Pack::load(&b[i])).store(&result[i]);
+ for (; i < n; ++i) result[i] = a[i] + b[i];
+}
+
+template <typename S>
+static void subtractLanes(const BasicScalarArray<S> &a, const BasicScalarArray<S> &b, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+  (Pack::load(&a[i]) - Pack::load(&b[i])).store(&result[i]);
+ for (; i < n; ++i) result[i] = a[i] - b[i];
+}
+
+template <typename S>
+static void scaleLane(const BasicScalarArray<S> &a, S s, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ const Pack ps = Pack::broadcast(s);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+  (Pack::load(&a[i]) * ps).store(&result[i]);
+ for (; i < n; ++i) result[i] = a[i] * s;
+}
+
+template <typename S>
+static void offsetLane(const BasicScalarArray<S> &a, S s, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ const Pack ps = Pack::broadcast(s);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+  (Pack::load(&a[i]) + ps).store(&result[i]);
+ for (; i < n; ++i) result[i] = a[i] + s;
+}
+
+// a*(1 - s) + b*s, the same expression as LERP()
+template <typename S>
+static void lerpLanes(const BasicScalarArray<S> &a, const BasicScalarArray<S> &b, S s, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ const S r = 1.0 - s;
+ const Pack pr = Pack::broadcast(r), ps = Pack::broadcast(s);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+  (Pack::load(&a[i])*pr + Pack::load(&b[i])*ps).store(&result[i]);
+ for (; i < n; ++i) result[i] = a[i]*r + b[i]*s;
+}
+
+template <typename S>
+static void boundsLane(const BasicScalarArray<S> &a, S &min, S &max)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ min = std::numeric_limits<S>::infinity();
+ max = -min;
+ std::size_t i = 0;
+ if (n >= Pack::width)
+ {
+  Pack packMin = Pack::load(&a[0]), packMax = packMin;
+  for (i = Pack::width; i + Pack::width <= n; i += Pack::width)
+  {
+   Pack x = Pack::load(&a[i]);
+   packMin = simdMin(packMin, x);
+   packMax = simdMax(packMax, x);
+  }
+  S lanes[Pack::width];
+  packMin.store(lanes);
+  for (std::size_t j = 0; j < Pack::width; ++j) min = (lanes[j] < min) ? lanes[j] : min;
+  packMax.store(lanes);
+  for (std::size_t j = 0; j < Pack::width; ++j) max = (max < lanes[j]) ? lanes[j] : max;
+ }
+ for (; i < n; ++i)
+ {
+  min = (a[i] < min) ? a[i] : min;
+  max = (max < a[i]) ? a[i] : max;
+ }
+}
+
+// Sums packs in S over short blocks, then adds each block's total into a double
+template <typename S>
+static double sumLane(const BasicScalarArray<S> &a)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t block = 256*Pack::width;
+ const std::size_t n = a.size();
+ double total = 0.0;
+ std::size_t i = 0;
+ while (i + Pack::width <= n)
+ {
+  const std::size_t end = (n - i > block) ? i + block : n;
+  Pack sum = Pack::broadcast(0);
+  for (; i + Pack::width <= end; i += Pack::width) sum = sum + Pack::load(&a[i]);
+  S lanes[Pack::width];
+  sum.store(lanes);
+  for (std::size_t j = 0; j < Pack::width; ++j) total += lanes[j];
+ }
+ for (; i < n; ++i) total += a[i];
+ return total;
+}
+
+template <typename S>
+void addVectorArrays(const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b, BasicTVectorArray<S> &result)
+{
+ assert(a.size() == b.size());
+ result.resize(a.size());
+ addLanes(a.xEast, b.xEast, result.xEast);
+ addLanes(a.yNorth, b.yNorth, result.yNorth);
+ addLanes(a.zUp, b.zUp, result.zUp);
+}
+
+template <typename S>
+void addVectorArrays(const BasicPVectorArray<S> &a, const BasicPVectorArray<S> &b, BasicPVectorArray<S> &result)
+{
+ assert(a.size() == b.size());
+ result.resize(a.size());
+ addLanes(a.u, b.u, result.u);
+ addLanes(a.v, b.v, result.v);
+}
+
+template <typename S>
+void addVectorArrays(const BasicTVectorArray<S> &a, const BasicTVector<S> &b, BasicTVectorArray<S> &result)
+{
+ result.resize(a.size());
+ offsetLane(a.xEast, b.xEast, result.xEast);
+ offsetLane(a.yNorth, b.yNorth, result.yNorth);
+ offsetLane(a.zUp, b.zUp, result.zUp);
+}
+
+template <typename S>
+void addVectorArrays(const BasicPVectorArray<S> &a, const BasicPVector<S> &b, BasicPVectorArray<S> &result)
+{
+ result.resize(a.size());
+ offsetLane(a.u, b.u, result.u);
+ offsetLane(a.v, b.v, result.v);
+}
+
+template <typename S>
+void subtractVectorArrays(const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b, BasicTVectorArray<S> &result)
+{
+ assert(a.size() == b.size());
+ result.resize(a.size());
+ subtractLanes(a.xEast, b.xEast, result.xEast);
+ subtractLanes(a.yNorth, b.yNorth, result.yNorth);
+ subtractLanes(a.zUp, b.zUp, result.zUp);
+}
+
+template <typename S>
+void subtractVectorArrays(const BasicPVectorArray<S> &a, const BasicPVectorArray<S> &b, BasicPVectorArray<S> &result)
+{
+ assert(a.size() == b.size());
+ result.resize(a.size());
+ subtractLanes(a.u, b.u, result.u);
+ subtractLanes(a.v, b.v, result.v);
+}
+
+template <typename S>
+void scaleVectorArray(const BasicTVectorArray<S> &a, typename BasicTVectorArray<S>::Scalar s, BasicTVectorArray<S> &result)
+{
+ result.resize(a.size());
+ scaleLane(a.xEast, s, result.xEast);
+ scaleLane(a.yNorth, s, result.yNorth);
+ scaleLane(a.zUp, s, result.zUp);
+}
+
+template <typename S>
+void scaleVectorArray(const BasicPVectorArray<S> &a, typename BasicPVectorArray<S>::Scalar s, BasicPVectorArray<S> &result)
+{
+ result.resize(a.size());
+ scaleLane(a.u, s, result.u);
+ scaleLane(a.v, s, result.v);
+}
+
+template <typename S>
+void dotVectorArrays(const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ assert(a.size() == b.size());
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack d = Pack::load(&a.xEast[i])*Pack::load(&b.xEast[i])
+         + Pack::load(&a.yNorth[i])*Pack::load(&b.yNorth[i])
+         + Pack::load(&a.zUp[i])*Pack::load(&b.zUp[i]);
+  d.store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = a[i] * b[i];
+}
+
+template <typename S>
+void dotVectorArrays(const BasicPVectorArray<S> &a, const BasicPVectorArray<S> &b, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ assert(a.size() == b.size());
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack d = Pack::load(&a.u[i])*Pack::load(&b.u[i]) + Pack::load(&a.v[i])*Pack::load(&b.v[i]);
+  d.store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = a[i] * b[i];
+}
+
+template <typename S>
+void dotVectorArrays(const BasicTVectorArray<S> &a, const BasicTVector<S> &b, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ const Pack bx = Pack::broadcast(b.xEast), by = Pack::broadcast(b.yNorth), bz = Pack::broadcast(b.zUp);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack d = Pack::load(&a.xEast[i])*bx + Pack::load(&a.yNorth[i])*by + Pack::load(&a.zUp[i])*bz;
+  d.store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = a[i] * b;
+}
+
+template <typename S>
+void dotVectorArrays(const BasicPVectorArray<S> &a, const BasicPVector<S> &b, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ const Pack bu = Pack::broadcast(b.u), bv = Pack::broadcast(b.v);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack d = Pack::load(&a.u[i])*bu + Pack::load(&a.v[i])*bv;
+  d.store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = a[i] * b;
+}
+
+template <typename S>
+void crossVectorArrays(const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b, BasicTVectorArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ assert(a.size() == b.size());
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack ax = Pack::load(&a.xEast[i]), ay = Pack::load(&a.yNorth[i]), az = Pack::load(&a.zUp[i]);
+  Pack bx = Pack::load(&b.xEast[i]), by = Pack::load(&b.yNorth[i]), bz = Pack::load(&b.zUp[i]);
+  (ay*bz - az*by).store(&result.xEast[i]);
+  (az*bx - ax*bz).store(&result.yNorth[i]);
+  (ax*by - ay*bx).store(&result.zUp[i]);
+ }
+ for (; i < n; ++i) result.set(i, a[i] / b[i]);
+}
+
+template <typename S>
+void lengthVectorArray(const BasicTVectorArray<S> &a, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack x = Pack::load(&a.xEast[i]), y = Pack::load(&a.yNorth[i]), z = Pack::load(&a.zUp[i]);
+  simdSqrt(x*x + y*y + z*z).store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = length(a[i]);
+}
+
+template <typename S>
+void lengthVectorArray(const BasicPVectorArray<S> &a, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack u = Pack::load(&a.u[i]), v = Pack::load(&a.v[i]);
+  simdSqrt(u*u + v*v).store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = length(a[i]);
+}
+
+template <typename S>
+void lengthSquaredVectorArray(const BasicTVectorArray<S> &a, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack x = Pack::load(&a.xEast[i]), y = Pack::load(&a.yNorth[i]), z = Pack::load(&a.zUp[i]);
+  (x*x + y*y + z*z).store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = lengthSquared(a[i]);
+}
+
+template <typename S>
+void lengthSquaredVectorArray(const BasicPVectorArray<S> &a, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack u = Pack::load(&a.u[i]), v = Pack::load(&a.v[i]);
+  (u*u + v*v).store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = lengthSquared(a[i]);
+}
+
+template <typename S>
+static SIMDPack<S> absLanes(SIMDPack<S> p)
+{
+ return simdMax(p, SIMDPack<S>::broadcast(0) - p);
+}
+
+// atan2 of the cross and dot products as in angleBetweenVectors(), but with
+// the vectorised fastAtan2, in the tail too so every element agrees
+template <typename S>
+void angleBetweenVectorArrays(const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ assert(a.size() == b.size());
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack ax = Pack::load(&a.xEast[i]), ay = Pack::load(&a.yNorth[i]), az = Pack::load(&a.zUp[i]);
+  Pack bx = Pack::load(&b.xEast[i]), by = Pack::load(&b.yNorth[i]), bz = Pack::load(&b.zUp[i]);
+  Pack cx = ay*bz - az*by, cy = az*bx - ax*bz, cz = ax*by - ay*bx;
+  simdFastAtan2(simdSqrt(cx*cx + cy*cy + cz*cz), ax*bx + ay*by + az*bz).store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = fastAtan2(length(a[i]/b[i]), a[i]*b[i]);
+}
+
+template <typename S>
+void angleBetweenVectorArrays(const BasicPVectorArray<S> &a, const BasicPVectorArray<S> &b, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ assert(a.size() == b.size());
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack au = Pack::load(&a.u[i]), av = Pack::load(&a.v[i]);
+  Pack bu = Pack::load(&b.u[i]), bv = Pack::load(&b.v[i]);
+  simdFastAtan2(absLanes(au*bv - av*bu), au*bu + av*bv).store(&result[i]);
+ }
+ for (; i < n; ++i) result[i] = fastAtan2(std::fabs(a[i].u*b[i].v - a[i].v*b[i].u), a[i]*b[i]);
+}
+
+// Lanes whose squared length has overflowed, or is zero or subnormal, so
+// their reciprocal square root is inaccurate or infinite
+template <typename S>
+static auto outsideNormalRange(SIMDPack<S> squared) -> decltype(simdLessThan(squared, squared))
+{
+ return simdOr(simdLessThan(squared, SIMDPack<S>::broadcast(std::numeric_limits<S>::min())), simdLessThan(SIMDPack<S>::broadcast(std::numeric_limits<S>::max()), squared));
+}
+
+// Each lane's largest component, or 1 for zero lanes, to divide the lanes by
+template <typename S>
+static SIMDPack<S> largestDivisor(SIMDPack<S> largest)
+{
+ return simdSelect(simdIsZero(largest), SIMDPack<S>::broadcast(1), largest);
+}
+
+// The tail of the normalize kernels, taking the same steps as the packs so
+// every element gets the same treatment
+template <typename S>
+static S unitLane(S &x, S &y, S z)
+{
+ S squared = x*x + y*y + z*z;
+ if (!(squared >= std::numeric_limits<S>::min() && squared <= std::numeric_limits<S>::max()))
+ {
+  const S largest = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+  if (largest == S(0)) return z;
+  x /= largest;
+  y /= largest;
+  z /= largest;
+  squared = x*x + y*y + z*z;
+ }
+ const S scale = S(1)/std::sqrt(squared);
+ x *= scale;
+ y *= scale;
+ return z*scale;
+}
+
+template <typename S>
+void normalizeVectorArray(const BasicTVectorArray<S> &a, BasicTVectorArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack x = Pack::load(&a.xEast[i]), y = Pack::load(&a.yNorth[i]), z = Pack::load(&a.zUp[i]);
+  Pack squared = x*x + y*y + z*z;
+  if (simdAny(outsideNormalRange(squared)))
+  {
+   // dividing by the largest component first keeps the squared length
+   // between 1 and 3, so it can't overflow or go subnormal
+   const Pack divisor = largestDivisor(simdMax(simdMax(absLanes(x), absLanes(y)), absLanes(z)));
+   x = x/divisor;
+   y = y/divisor;
+   z = z/divisor;
+   squared = x*x + y*y + z*z;
+  }
+  // zero vectors get a scale of 1 so they come through unchanged
+  const Pack scale = simdSelect(simdIsZero(squared), Pack::broadcast(1), simdRecipSqrt(squared));
+  (x*scale).store(&result.xEast[i]);
+  (y*scale).store(&result.yNorth[i]);
+  (z*scale).store(&result.zUp[i]);
+ }
+ for (; i < n; ++i)
+ {
+  S x = a.xEast[i], y = a.yNorth[i];
+  const S z = unitLane(x, y, a.zUp[i]);
+  result.xEast[i] = x;
+  result.yNorth[i] = y;
+  result.zUp[i] = z;
+ }
+}
+
+template <typename S>
+void normalizeVectorArray(const BasicPVectorArray<S> &a, BasicPVectorArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack u = Pack::load(&a.u[i]), v = Pack::load(&a.v[i]);
+  Pack squared = u*u + v*v;
+  if (simdAny(outsideNormalRange(squared)))
+  {
+   const Pack divisor = largestDivisor(simdMax(absLanes(u), absLanes(v)));
+   u = u/divisor;
+   v = v/divisor;
+   squared = u*u + v*v;
+  }
+  const Pack scale = simdSelect(simdIsZero(squared), Pack::broadcast(1), simdRecipSqrt(squared));
+  (u*scale).store(&result.u[i]);
+  (v*scale).store(&result.v[i]);
+ }
+ for (; i < n; ++i)
+ {
+  S u = a.u[i], v = a.v[i];
+  unitLane(u, v, S(0));
+  result.u[i] = u;
+  result.v[i] = v;
+ }
+}
+
+template <typename S>
+void lerpVectorArrays(const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b, typename BasicTVectorArray<S>::Scalar s, BasicTVectorArray<S> &result)
+{
+ assert(a.size() == b.size());
+ result.resize(a.size());
+ lerpLanes(a.xEast, b.xEast, s, result.xEast);
+ lerpLanes(a.yNorth, b.yNorth, s, result.yNorth);
+ lerpLanes(a.zUp, b.zUp, s, result.zUp);
+}
+
+template <typename S>
+void lerpVectorArrays(const BasicPVectorArray<S> &a, const BasicPVectorArray<S> &b, typename BasicPVectorArray<S>::Scalar s, BasicPVectorArray<S> &result)
+{
+ assert(a.size() == b.size());
+ result.resize(a.size());
+ lerpLanes(a.u, b.u, s, result.u);
+ lerpLanes(a.v, b.v, s, result.v);
+}
+
+template <typename S>
+void boundsVectorArray(const BasicTVectorArray<S> &a, BasicTVector<S> &min, BasicTVector<S> &max)
+{
+ boundsLane(a.xEast, min.xEast, max.xEast);
+ boundsLane(a.yNorth, min.yNorth, max.yNorth);
+ boundsLane(a.zUp, min.zUp, max.zUp);
+}
+
+template <typename S>
+void boundsVectorArray(const BasicPVectorArray<S> &a, BasicPVector<S> &min, BasicPVector<S> &max)
+{
+ boundsLane(a.u, min.u, max.u);
+ boundsLane(a.v, min.v, max.v);
+}
+
+template <typename S>
+BasicTVector<S> centroidVectorArray(const BasicTVectorArray<S> &a)
+{
+ if (a.size() == 0) return {0.0, 0.0, 0.0};
+ const double n = a.size();
+ return {S(sumLane(a.xEast)/n), S(sumLane(a.yNorth)/n), S(sumLane(a.zUp)/n)};
+}
+
+template <typename S>
+BasicPVector<S> centroidVectorArray(const BasicPVectorArray<S> &a)
+{
+ if (a.size() == 0) return {0.0, 0.0};
+ const double n = a.size();
+ return {S(sumLane(a.u)/n), S(sumLane(a.v)/n)};
+}
+
+// stores path.at(t) for one pack of t values at index i
+template <typename S>
+static void storeSLERPPack(const BasicTVectorSLERPPath<S> &path, SIMDPack<S> t, BasicTVectorArray<S> &result, std::size_t i)
+{
+ typedef SIMDPack<S> Pack;
+ Pack a, b;
+ BasicTVector<S> first, second;
+ if (path.linear)
+ {
+  a = Pack::broadcast(1) - t;
+  b = t;
+  first = path.start;
+  second = path.finish;
+ }
+ else
+ {
+  Pack angle = Pack::broadcast(path.omega)*t;
+  a = simdCos(angle);
+  b = simdSin(angle);
+  first = path.start;
+  second = path.ortho;
+ }
+ (a*Pack::broadcast(first.xEast) + b*Pack::broadcast(second.xEast)).store(&result.xEast[i]);
+ (a*Pack::broadcast(first.yNorth) + b*Pack::broadcast(second.yNorth)).store(&result.yNorth[i]);
+ (a*Pack::broadcast(first.zUp) + b*Pack::broadcast(second.zUp)).store(&result.zUp[i]);
+}
+
+template <typename S>
+void slerpVectorArray(const BasicTVectorSLERPPath<S> &path, std::size_t samples, BasicTVectorArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ result.resize(samples);
+ const S step = (samples > 1) ? 1.0 / (samples - 1) : 0.0;
+
+ S offsets[Pack::width];
+ for (std::size_t j = 0; j < Pack::width; ++j) offsets[j] = j;
+ const Pack packOffsets = Pack::load(offsets);
+ const Pack packStep = Pack::broadcast(step);
+
+ std::size_t i = 0;
+ for (; i + Pack::width <= samples; i += Pack::width)
+  storeSLERPPack(path, (Pack::broadcast(i) + packOffsets)*packStep, result, i);
+ for (; i < samples; ++i) result.set(i, path.at(i*step));
+}
+
+template <typename S>
+void slerpVectorArray(const BasicTVectorSLERPPath<S> &path, const BasicScalarArray<S> &slerp, BasicTVectorArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = slerp.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+  storeSLERPPack(path, Pack::load(&slerp[i]), result, i);
+ for (; i < n; ++i) result.set(i, path.at(slerp[i]));
+}
+
+template <typename S>
+void fastSinCosArray(const BasicScalarArray<S> &angles, BasicScalarArray<S> &sines, BasicScalarArray<S> &cosines)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = angles.size();
+ sines.resize(n);
+ cosines.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack s, c;
+  simdFastSinCos(Pack::load(&angles[i]), s, c);
+  s.store(&sines[i]);
+  c.store(&cosines[i]);
+ }
+ for (; i < n; ++i) fastSinCos(angles[i], sines[i], cosines[i]);
+}
+
+template <typename S>
+void fastUnitVectorsAtAngles(const BasicScalarArray<S> &angles, BasicPVectorArray<S> &result)
+{
+ fastSinCosArray(angles, result.v, result.u);
+}
+
+template <typename S>
+void fastRotatePVectorArray(const BasicPVectorArray<S> &a, const BasicScalarArray<S> &angles, BasicPVectorArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ assert(a.size() == angles.size());
+ const std::size_t n = a.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack s, c;
+  simdFastSinCos(Pack::load(&angles[i]), s, c);
+  Pack u = Pack::load(&a.u[i]), v = Pack::load(&a.v[i]);
+  (u*c - v*s).store(&result.u[i]);
+  (u*s + v*c).store(&result.v[i]);
+ }
+ for (; i < n; ++i)
+ {
+  S s, c;
+  fastSinCos(angles[i], s, c);
+  const S u = a.u[i], v = a.v[i];
+  result.u[i] = u*c - v*s;
+  result.v[i] = u*s + v*c;
+ }
+}
+
+template <typename S>
+void fastRotatePVectorArray(const BasicPVectorArray<S> &a, typename BasicPVectorArray<S>::Scalar angle, BasicPVectorArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ result.resize(n);
+ S s, c;
+ fastSinCos(angle, s, c);
+ const Pack sinePack = Pack::broadcast(s), cosinePack = Pack::broadcast(c);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack u = Pack::load(&a.u[i]), v = Pack::load(&a.v[i]);
+  (u*cosinePack - v*sinePack).store(&result.u[i]);
+  (u*sinePack + v*cosinePack).store(&result.v[i]);
+ }
+ for (; i < n; ++i)
+ {
+  const S u = a.u[i], v = a.v[i];
+  result.u[i] = u*c - v*s;
+  result.v[i] = u*s + v*c;
+ }
+}
+
+template <typename S>
+void fastAtan2Array(const BasicScalarArray<S> &y, const BasicScalarArray<S> &x, BasicScalarArray<S> &result)
+{
+ typedef SIMDPack<S> Pack;
+ assert(y.size() == x.size());
+ const std::size_t n = y.size();
+ result.resize(n);
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+  simdFastAtan2(Pack::load(&y[i]), Pack::load(&x[i])).store(&result[i]);
+ for (; i < n; ++i) result[i] = fastAtan2(y[i], x[i]);
+}
+
+template <typename S>
+void fastPlaneVectorAngleArray(const BasicPVectorArray<S> &a, BasicScalarArray<S> &result)
+{
+ fastAtan2Array(a.v, a.u, result);
+}
+
+#define PTVECTORARRAYS_INSTANTIATE(S) \
+ template void addVectorArrays(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, BasicTVectorArray<S>&); \
+ template void addVectorArrays(const BasicPVectorArray<S>&, const BasicPVectorArray<S>&, BasicPVectorArray<S>&); \
+ template void addVectorArrays(const BasicTVectorArray<S>&, const BasicTVector<S>&, BasicTVectorArray<S>&); \
+ template void addVectorArrays(const BasicPVectorArray<S>&, const BasicPVector<S>&, BasicPVectorArray<S>&); \
+ template void subtractVectorArrays(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, BasicTVectorArray<S>&); \
+ template void subtractVectorArrays(const BasicPVectorArray<S>&, const BasicPVectorArray<S>&, BasicPVectorArray<S>&); \
+ template void scaleVectorArray(const BasicTVectorArray<S>&, S, BasicTVectorArray<S>&); \
+ template void scaleVectorArray(const BasicPVectorArray<S>&, S, BasicPVectorArray<S>&); \
+ template void dotVectorArrays(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, BasicScalarArray<S>&); \
+ template void dotVectorArrays(const BasicPVectorArray<S>&, const BasicPVectorArray<S>&, BasicScalarArray<S>&); \
+ template void dotVectorArrays(const BasicTVectorArray<S>&, const BasicTVector<S>&, BasicScalarArray<S>&); \
+ template void dotVectorArrays(const BasicPVectorArray<S>&, const BasicPVector<S>&, BasicScalarArray<S>&); \
+ template void crossVectorArrays(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, BasicTVectorArray<S>&); \
+ template void lengthVectorArray(const BasicTVectorArray<S>&, BasicScalarArray<S>&); \
+ template void lengthVectorArray(const BasicPVectorArray<S>&, BasicScalarArray<S>&); \
+ template void lengthSquaredVectorArray(const BasicTVectorArray<S>&, BasicScalarArray<S>&); \
+ template void lengthSquaredVectorArray(const BasicPVectorArray<S>&, BasicScalarArray<S>&); \
+ template void angleBetweenVectorArrays(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, BasicScalarArray<S>&); \
+ template void angleBetweenVectorArrays(const BasicPVectorArray<S>&, const BasicPVectorArray<S>&, BasicScalarArray<S>&); \
+ template void normalizeVectorArray(const BasicTVectorArray<S>&, BasicTVectorArray<S>&); \
+ template void normalizeVectorArray(const BasicPVectorArray<S>&, BasicPVectorArray<S>&); \
+ template void lerpVectorArrays(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, S, BasicTVectorArray<S>&); \
+ template void lerpVectorArrays(const BasicPVectorArray<S>&, const BasicPVectorArray<S>&, S, BasicPVectorArray<S>&); \
+ template void boundsVectorArray(const BasicTVectorArray<S>&, BasicTVector<S>&, BasicTVector<S>&); \
+ template void boundsVectorArray(const BasicPVectorArray<S>&, BasicPVector<S>&, BasicPVector<S>&); \
+ template BasicTVector<S> centroidVectorArray(const BasicTVectorArray<S>&); \
+ template BasicPVector<S> centroidVectorArray(const BasicPVectorArray<S>&); \
+ template void slerpVectorArray(const BasicTVectorSLERPPath<S>&, std::size_t, BasicTVectorArray<S>&); \
+ template void slerpVectorArray(const BasicTVectorSLERPPath<S>&, const BasicScalarArray<S>&, BasicTVectorArray<S>&); \
+ template void fastSinCosArray(const BasicScalarArray<S>&, BasicScalarArray<S>&, BasicScalarArray<S>&); \
+ template void fastUnitVectorsAtAngles(const BasicScalarArray<S>&, BasicPVectorArray<S>&); \
+ template void fastRotatePVectorArray(const BasicPVectorArray<S>&, const BasicScalarArray<S>&, BasicPVectorArray<S>&); \
+ template void fastRotatePVectorArray(const BasicPVectorArray<S>&, typename BasicPVectorArray<S>::Scalar, BasicPVectorArray<S>&); \
+ template void fastAtan2Array(const BasicScalarArray<S>&, const BasicScalarArray<S>&, BasicScalarArray<S>&); \
+ template void fastPlaneVectorAngleArray(const BasicPVectorArray<S>&, BasicScalarArray<S>&);
+
+PTVECTORARRAYS_INSTANTIATE(float)
+PTVECTORARRAYS_INSTANTIATE(double)
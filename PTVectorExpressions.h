@@ -0,0 +1,470 @@
+/******************************************************************************
+*
+*     PTVectorExpressions.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTOREXPRESSIONS_H_INCLUDED
+#define PTVECTOREXPRESSIONS_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTVectorSIMD.h"
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+// Lazy arithmetic on TVectorArrays and PVectorArrays.
+// With this header included, +, - and scaling on arrays build an expression
+// instead of computing anything. The expression is evaluated when it is
+// assigned to an array, one pack of every lane at a time, so the whole thing
+// is a single pass over memory with no temporaries.
+//
+// positions += velocities*dt;                       // one pass, no temporary
+// TVectorArray out = a*s + b - c;
+// evaluateVectorArray(a*s + b - c, out);            // the same, into an existing array
+//
+// Arrays are held by pointer, so they must outlive any expression kept in an
+// auto variable. The operations are element-wise and rounded as the batch
+// kernels in PTVectorArrays.h would round them, so the result may alias any
+// of the arrays in the expression.
+//
+//  A + A, A - A, -A
+//  A * s, s * A                 scalar s
+//  A * W                        every element scaled by the matching element of a ScalarArray W
+//  A + V, V + A, A - V, V - A   the same TVector or PVector V for every element
+
+// Base of every expression node. E provides Scalar, dimensions, size(),
+// pack(lane, i) for the pack of the lane starting at element i, and at(lane, i)
+// for a single element.
+template <typename E>
+struct VectorArrayExpression
+{
+ const E& derived() const
+ {
+  return static_cast<const E&>(*this);
+ }
+};
+
+// An array at the leaves of an expression
+template <typename S, std::size_t D>
+struct VectorArrayTerminal : VectorArrayExpression<VectorArrayTerminal<S, D> >
+{
+ typedef S Scalar;
+ static const std::size_t dimensions = D;
+
+ const S *lanes[D];
+ std::size_t n;
+
+ std::size_t size() const
+ {
+  return n;
+ }
+
+ SIMDPack<S> pack(std::size_t lane, std::size_t i) const
+ {
+  return SIMDPack<S>::load(lanes[lane] + i);
+ }
+
+ S at(std::size_t lane, std::size_t i) const
+ {
+  return lanes[lane][i];
+ }
+};
+
+// What can appear as an operand, and the expression it becomes.
+// Anything else leaves the operators below out of overload resolution.
+template <typename T, typename Enable = void>
+struct VectorArrayOperand
+{
+};
+
+template <typename E>
+struct VectorArrayOperand<E, typename std::enable_if<std::is_base_of<VectorArrayExpression<E>, E>::value>::type>
+{
+ typedef E Type;
+ static const E& get(const E &e)
+ {
+  return e;
+ }
+};
+
+template <typename S>
+struct VectorArrayOperand<BasicTVectorArray<S> >
+{
+ typedef VectorArrayTerminal<S, 3> Type;
+ static Type get(const BasicTVectorArray<S> &a)
+ {
+  Type t;
+  t.lanes[0] = a.xEast.data();
+  t.lanes[1] = a.yNorth.data();
+  t.lanes[2] = a.zUp.data();
+  t.n = a.size();
+  return t;
+ }
+};
+
+template <typename S>
+struct VectorArrayOperand<BasicPVectorArray<S> >
+{
+ typedef VectorArrayTerminal<S, 2> Type;
+ static Type get(const BasicPVectorArray<S> &a)
+ {
+  Type t;
+  t.lanes[0] = a.u.data();
+  t.lanes[1] = a.v.data();
+  t.n = a.size();
+  return t;
+ }
+};
+
+// The operations, on packs and on single scalars alike
+struct VectorArrayAdd
+{
+ template <typename T> static T apply(T a, T b) { return a + b; }
+};
+
+struct VectorArraySubtract
+{
+ template <typename T> static T apply(T a, T b) { return a - b; }
+};
+
+struct VectorArrayReverseSubtract
+{
+ template <typename T> static T apply(T a, T b) { return b - a; }
+};
+
+struct VectorArrayMultiply
+{
+ template <typename T> static T apply(T a, T b) { return a * b; }
+};
+
+// l Op r, element by element
+template <typename L, typename R, typename Op>
+struct VectorArrayBinary : VectorArrayExpression<VectorArrayBinary<L, R, Op> >
+{
+ static_assert(std::is_same<typename L::Scalar, typename R::Scalar>::value, "vector array expressions can't mix precisions");
+ static_assert(L::dimensions == R::dimensions, "vector array expressions can't mix TVectors and PVectors");
+
+ typedef typename L::Scalar Scalar;
+ static const std::size_t dimensions = L::dimensions;
+
+ L l;
+ R r;
+
+ VectorArrayBinary(const L &left, const R &right) : l(left), r(right)
+ {
+  assert(l.size() == r.size());
+ }
+
+ std::size_t size() const
+ {
+  return l.size();
+ }
+
+ SIMDPack<Scalar> pack(std::size_t lane, std::size_t i) const
+ {
+  return Op::apply(l.pack(lane, i), r.pack(lane, i));
+ }
+
+ Scalar at(std::size_t lane, std::size_t i) const
+ {
+  return Op::apply(l.at(lane, i), r.at(lane, i));
+ }
+};
+
+// e Op c, with one constant per lane, for scaling and for adding a single vector
+template <typename E, typename Op>
+struct VectorArrayConstant : VectorArrayExpression<VectorArrayConstant<E, Op> >
+{
+ typedef typename E::Scalar Scalar;
+ static const std::size_t dimensions = E::dimensions;
+
+ E e;
+ Scalar c[dimensions];
+
+ explicit VectorArrayConstant(const E &expression) : e(expression) {}
+
+ std::size_t size() const
+ {
+  return e.size();
+ }
+
+ SIMDPack<Scalar> pack(std::size_t lane, std::size_t i) const
+ {
+  return Op::apply(e.pack(lane, i), SIMDPack<Scalar>::broadcast(c[lane]));
+ }
+
+ Scalar at(std::size_t lane, std::size_t i) const
+ {
+  return Op::apply(e.at(lane, i), c[lane]);
+ }
+};
+
+// e * w[i] for a ScalarArray w
+template <typename E>
+struct VectorArrayWeighted : VectorArrayExpression<VectorArrayWeighted<E> >
+{
+ typedef typename E::Scalar Scalar;
+ static const std::size_t dimensions = E::dimensions;
+
+ E e;
+ const Scalar *w;
+
+ VectorArrayWeighted(const E &expression, const BasicScalarArray<Scalar> &weights) : e(expression), w(weights.data())
+ {
+  assert(e.size() == weights.size());
+ }
+
+ std::size_t size() const
+ {
+  return e.size();
+ }
+
+ SIMDPack<Scalar> pack(std::size_t lane, std::size_t i) const
+ {
+  return e.pack(lane, i)*SIMDPack<Scalar>::load(w + i);
+ }
+
+ Scalar at(std::size_t lane, std::size_t i) const
+ {
+  return e.at(lane, i)*w[i];
+ }
+};
+
+template <typename E>
+struct VectorArrayNegate : VectorArrayExpression<VectorArrayNegate<E> >
+{
+ typedef typename E::Scalar Scalar;
+ static const std::size_t dimensions = E::dimensions;
+
+ E e;
+
+ explicit VectorArrayNegate(const E &expression) : e(expression) {}
+
+ std::size_t size() const
+ {
+  return e.size();
+ }
+
+ SIMDPack<Scalar> pack(std::size_t lane, std::size_t i) const
+ {
+  return SIMDPack<Scalar>::broadcast(0) - e.pack(lane, i);
+ }
+
+ Scalar at(std::size_t lane, std::size_t i) const
+ {
+  return -e.at(lane, i);
+ }
+};
+
+// Operators
+
+template <typename L, typename R>
+VectorArrayBinary<typename VectorArrayOperand<L>::Type, typename VectorArrayOperand<R>::Type, VectorArrayAdd>
+operator+(const L &l, const R &r)
+{
+ return {VectorArrayOperand<L>::get(l), VectorArrayOperand<R>::get(r)};
+}
+
+template <typename L, typename R>
+VectorArrayBinary<typename VectorArrayOperand<L>::Type, typename VectorArrayOperand<R>::Type, VectorArraySubtract>
+operator-(const L &l, const R &r)
+{
+ return {VectorArrayOperand<L>::get(l), VectorArrayOperand<R>::get(r)};
+}
+
+template <typename E>
+VectorArrayNegate<typename VectorArrayOperand<E>::Type> operator-(const E &e)
+{
+ return VectorArrayNegate<typename VectorArrayOperand<E>::Type>(VectorArrayOperand<E>::get(e));
+}
+
+template <typename Op, typename E>
+VectorArrayConstant<typename VectorArrayOperand<E>::Type, Op> vectorArrayScalar(const E &e, typename VectorArrayOperand<E>::Type::Scalar s)
+{
+ VectorArrayConstant<typename VectorArrayOperand<E>::Type, Op> node(VectorArrayOperand<E>::get(e));
+ for (std::size_t lane = 0; lane < node.dimensions; ++lane) node.c[lane] = s;
+ return node;
+}
+
+template <typename E>
+VectorArrayConstant<typename VectorArrayOperand<E>::Type, VectorArrayMultiply>
+operator*(const E &e, typename VectorArrayOperand<E>::Type::Scalar s)
+{
+ return vectorArrayScalar<VectorArrayMultiply>(e, s);
+}
+
+template <typename E>
+VectorArrayConstant<typename VectorArrayOperand<E>::Type, VectorArrayMultiply>
+operator*(typename VectorArrayOperand<E>::Type::Scalar s, const E &e)
+{
+ return vectorArrayScalar<VectorArrayMultiply>(e, s);
+}
+
+template <typename E>
+VectorArrayWeighted<typename VectorArrayOperand<E>::Type>
+operator*(const E &e, const BasicScalarArray<typename VectorArrayOperand<E>::Type::Scalar> &weights)
+{
+ return VectorArrayWeighted<typename VectorArrayOperand<E>::Type>(VectorArrayOperand<E>::get(e), weights);
+}
+
+template <typename Op, typename E>
+VectorArrayConstant<typename VectorArrayOperand<E>::Type, Op> vectorArrayOffset(const E &e, const BasicTVector<typename VectorArrayOperand<E>::Type::Scalar> &v)
+{
+ static_assert(VectorArrayOperand<E>::Type::dimensions == 3, "a TVector can only be added to a TVectorArray");
+ VectorArrayConstant<typename VectorArrayOperand<E>::Type, Op> node(VectorArrayOperand<E>::get(e));
+ node.c[0] = v.xEast;
+ node.c[1] = v.yNorth;
+ node.c[2] = v.zUp;
+ return node;
+}
+
+template <typename Op, typename E>
+VectorArrayConstant<typename VectorArrayOperand<E>::Type, Op> vectorArrayOffset(const E &e, const BasicPVector<typename VectorArrayOperand<E>::Type::Scalar> &v)
+{
+ static_assert(VectorArrayOperand<E>::Type::dimensions == 2, "a PVector can only be added to a PVectorArray");
+ VectorArrayConstant<typename VectorArrayOperand<E>::Type, Op> node(VectorArrayOperand<E>::get(e));
+ node.c[0] = v.u;
+ node.c[1] = v.v;
+ return node;
+}
+
+#define PTVECTOREXPRESSIONS_OFFSETS(V) \
+ template <typename E> \
+ VectorArrayConstant<typename VectorArrayOperand<E>::Type, VectorArrayAdd> \
+ operator+(const E &e, const V<typename VectorArrayOperand<E>::Type::Scalar> &v) { return vectorArrayOffset<VectorArrayAdd>(e, v); } \
+ template <typename E> \
+ VectorArrayConstant<typename VectorArrayOperand<E>::Type, VectorArrayAdd> \
+ operator+(const V<typename VectorArrayOperand<E>::Type::Scalar> &v, const E &e) { return vectorArrayOffset<VectorArrayAdd>(e, v); } \
+ template <typename E> \
+ VectorArrayConstant<typename VectorArrayOperand<E>::Type, VectorArraySubtract> \
+ operator-(const E &e, const V<typename VectorArrayOperand<E>::Type::Scalar> &v) { return vectorArrayOffset<VectorArraySubtract>(e, v); } \
+ template <typename E> \
+ VectorArrayConstant<typename VectorArrayOperand<E>::Type, VectorArrayReverseSubtract> \
+ operator-(const V<typename VectorArrayOperand<E>::Type::Scalar> &v, const E &e) { return vectorArrayOffset<VectorArrayReverseSubtract>(e, v); }
+
+PTVECTOREXPRESSIONS_OFFSETS(BasicTVector)
+PTVECTOREXPRESSIONS_OFFSETS(BasicPVector)
+
+#undef PTVECTOREXPRESSIONS_OFFSETS
+
+// Evaluation
+// The destination is resized to the size of the expression. Every lane of a
+// pack is computed from the same elements before the next pack is read, so
+// the destination may also be an operand.
+
+template <typename E, std::size_t D>
+void evaluateVectorArrayLanes(const VectorArrayExpression<E> &expression, typename E::Scalar *const (&out)[D])
+{
+ typedef SIMDPack<typename E::Scalar> Pack;
+ const E &e = expression.derived();
+ const std::size_t n = e.size();
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+  for (std::size_t lane = 0; lane < D; ++lane) e.pack(lane, i).store(out[lane] + i);
+ for (; i < n; ++i)
+  for (std::size_t lane = 0; lane < D; ++lane) out[lane][i] = e.at(lane, i);
+}
+
+template <typename E, typename S>
+void evaluateVectorArray(const VectorArrayExpression<E> &expression, BasicTVectorArray<S> &result)
+{
+ static_assert(std::is_same<typename E::Scalar, S>::value && E::dimensions == 3, "expression doesn't match the TVectorArray");
+ result.resize(expression.derived().size());
+ S *const out[3] = {result.xEast.data(), result.yNorth.data(), result.zUp.data()};
+ evaluateVectorArrayLanes(expression, out);
+}
+
+template <typename E, typename S>
+void evaluateVectorArray(const VectorArrayExpression<E> &expression, BasicPVectorArray<S> &result)
+{
+ static_assert(std::is_same<typename E::Scalar, S>::value && E::dimensions == 2, "expression doesn't match the PVectorArray");
+ result.resize(expression.derived().size());
+ S *const out[2] = {result.u.data(), result.v.data()};
+ evaluateVectorArrayLanes(expression, out);
+}
+
+template <typename S>
+template <typename E>
+BasicTVectorArray<S>::BasicTVectorArray(const VectorArrayExpression<E> &expression)
+{
+ evaluateVectorArray(expression, *this);
+}
+
+template <typename S>
+template <typename E>
+BasicTVectorArray<S>& BasicTVectorArray<S>::operator=(const VectorArrayExpression<E> &expression)
+{
+ evaluateVectorArray(expression, *this);
+ return *this;
+}
+
+template <typename S>
+template <typename E>
+BasicPVectorArray<S>::BasicPVectorArray(const VectorArrayExpression<E> &expression)
+{
+ evaluateVectorArray(expression, *this);
+}
+
+template <typename S>
+template <typename E>
+BasicPVectorArray<S>& BasicPVectorArray<S>::operator=(const VectorArrayExpression<E> &expression)
+{
+ evaluateVectorArray(expression, *this);
+ return *this;
+}
+
+// a += e and a -= e, for an array or expression e
+template <typename S, typename E>
+typename std::enable_if<sizeof(typename VectorArrayOperand<E>::Type) != 0, BasicTVectorArray<S>&>::type
+operator+=(BasicTVectorArray<S> &a, const E &e)
+{
+ evaluateVectorArray(a + e, a);
+ return a;
+}
+
+template <typename S, typename E>
+typename std::enable_if<sizeof(typename VectorArrayOperand<E>::Type) != 0, BasicTVectorArray<S>&>::type
+operator-=(BasicTVectorArray<S> &a, const E &e)
+{
+ evaluateVectorArray(a - e, a);
+ return a;
+}
+
+template <typename S, typename E>
+typename std::enable_if<sizeof(typename VectorArrayOperand<E>::Type) != 0, BasicPVectorArray<S>&>::type
+operator+=(BasicPVectorArray<S> &a, const E &e)
+{
+ evaluateVectorArray(a + e, a);
+ return a;
+}
+
+template <typename S, typename E>
+typename std::enable_if<sizeof(typename VectorArrayOperand<E>::Type) != 0, BasicPVectorArray<S>&>::type
+operator-=(BasicPVectorArray<S> &a, const E &e)
+{
+ evaluateVectorArray(a - e, a);
+ return a;
+}
+
+#endif // PTVECTOREXPRESSIONS_H_INCLUDED
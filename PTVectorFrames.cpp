@@ -0,0 +1,172 @@
+/******************************************************************************
+*
+*     PTVectorFrames.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorFrames.h"
+#include <cmath>
+#include <limits>
+
+// Below this squared length a direction counts as zero. It also keeps the
+// squared horizontal length of any direction that isn't vertical above the
+// smallest normal number, where the SIMD rsqrt is exact enough.
+template <typename S>
+static S minimumLengthSquared()
+{
+ return std::numeric_limits<S>::min()/(std::numeric_limits<S>::epsilon()*std::numeric_limits<S>::epsilon());
+}
+
+template <typename S>
+void calculateFrame(const BasicTVector<S> &direction, BasicTVector<S> &forward, BasicTVector<S> &up, BasicTVector<S> &right)
+{
+ const S x = direction.xEast, y = direction.yNorth, z = direction.zUp;
+ const S horizontalSq = x*x + y*y;
+ const S lengthSq = horizontalSq + z*z;
+ if (lengthSq < minimumLengthSquared<S>())
+ {
+  forward = {0.0, 0.0, 0.0};
+  up = {0.0, 0.0, 0.0};
+  right = {0.0, 0.0, 0.0};
+  return;
+ }
+
+ const S recipLength = S(1.0)/std::sqrt(lengthSq);
+ forward = {x*recipLength, y*recipLength, z*recipLength};
+
+ const S epsilon = std::numeric_limits<S>::epsilon();
+ if (!(epsilon*epsilon*lengthSq < horizontalSq))
+ {
+  const S sign = (z < 0.0) ? -1.0 : 1.0;
+  up = {0.0, sign, 0.0};
+  right = {sign, 0.0, 0.0};
+  return;
+ }
+
+ const S recipHorizontal = S(1.0)/std::sqrt(horizontalSq);
+ const S recipBoth = recipHorizontal*recipLength;
+ right = {y*recipHorizontal, -x*recipHorizontal, 0.0};
+ up = {-x*z*recipBoth, -y*z*recipBoth, horizontalSq*recipBoth};
+}
+
+// The frame for a pack of directions: forward, up and right, x y z each
+template <typename S>
+static void framePack(SIMDPack<S> x, SIMDPack<S> y, SIMDPack<S> z, SIMDPack<S> frame[9])
+{
+ typedef SIMDPack<S> Pack;
+ const Pack zero = Pack::broadcast(0);
+ const S epsilon = std::numeric_limits<S>::epsilon();
+
+ const Pack horizontalSq = x*x + y*y;
+ const Pack lengthSq = horizontalSq + z*z;
+ const auto isZero = simdLessThan(lengthSq, Pack::broadcast(minimumLengthSquared<S>()));
+ const auto isLevel = simdLessThan(Pack::broadcast(epsilon*epsilon)*lengthSq, horizontalSq);
+ const Pack sign = simdSelect(simdLessThan(z, zero), Pack::broadcast(-1), Pack::broadcast(1));
+
+ const Pack recipLength = simdRecipSqrt(lengthSq);
+ const Pack recipHorizontal = simdRecipSqrt(horizontalSq);
+ const Pack recipBoth = recipHorizontal*recipLength;
+
+ frame[0] = x*recipLength;
+ frame[1] = y*recipLength;
+ frame[2] = z*recipLength;
+ frame[3] = simdSelect(isLevel, (zero - x)*z*recipBoth, zero);
+ frame[4] = simdSelect(isLevel, (zero - y)*z*recipBoth, sign);
+ frame[5] = simdSelect(isLevel, horizontalSq*recipBoth, zero);
+ frame[6] = simdSelect(isLevel, y*recipHorizontal, sign);
+ frame[7] = simdSelect(isLevel, (zero - x)*recipHorizontal, zero);
+ frame[8] = zero;
+ for (int k = 0; k < 8; ++k) frame[k] = simdSelect(isZero, zero, frame[k]);
+}
+
+template <typename S>
+void calculateFrameArrays(const BasicTVectorArray<S> &directions,
+                          BasicTVectorArray<S> &forward,
+                          BasicTVectorArray<S> &up,
+                          BasicTVectorArray<S> &right)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = directions.size();
+ forward.resize(n);
+ up.resize(n);
+ right.resize(n);
+ BasicTVectorArray<S> *outputs[3] = {&forward, &up, &right};
+
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack frame[9];
+  framePack(Pack::load(&directions.xEast[i]), Pack::load(&directions.yNorth[i]), Pack::load(&directions.zUp[i]), frame);
+  for (int k = 0; k < 3; ++k)
+  {
+   frame[3*k].store(&outputs[k]->xEast[i]);
+   frame[3*k + 1].store(&outputs[k]->yNorth[i]);
+   frame[3*k + 2].store(&outputs[k]->zUp[i]);
+  }
+ }
+ for (; i < n; ++i)
+ {
+  BasicTVector<S> f, u, r;
+  calculateFrame(directions[i], f, u, r);
+  forward.set(i, f);
+  up.set(i, u);
+  right.set(i, r);
+ }
+}
+
+template <typename S>
+void calculateFrameMatrices(const BasicTVectorArray<S> &directions, std::vector<BasicMatrix3<S> > &frames)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = directions.size();
+ frames.resize(n);
+
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack frame[9];
+  framePack(Pack::load(&directions.xEast[i]), Pack::load(&directions.yNorth[i]), Pack::load(&directions.zUp[i]), frame);
+  S lanes[9][Pack::width];
+  for (int k = 0; k < 9; ++k) frame[k].store(lanes[k]);
+  for (std::size_t j = 0; j < Pack::width; ++j)
+  {
+   frames[i + j] = {{lanes[0][j], lanes[1][j], lanes[2][j]},
+                    {-lanes[6][j], -lanes[7][j], -lanes[8][j]},
+                    {lanes[3][j], lanes[4][j], lanes[5][j]}};
+  }
+ }
+ for (; i < n; ++i)
+ {
+  BasicTVector<S> f, u, r;
+  calculateFrame(directions[i], f, u, r);
+  frames[i] = {f, -r, u};
+ }
+}
+
+#define PTVECTORFRAMES_INSTANTIATE(S) \
+ template void calculateFrame(const BasicTVector<S>&, BasicTVector<S>&, BasicTVector<S>&, BasicTVector<S>&); \
+ template void calculateFrameArrays(const BasicTVectorArray<S>&, BasicTVectorArray<S>&, BasicTVectorArray<S>&, BasicTVectorArray<S>&); \
+ template void calculateFrameMatrices(const BasicTVectorArray<S>&, std::vector<BasicMatrix3<S> >&);
+
+PTVECTORFRAMES_INSTANTIATE(float)
+PTVECTORFRAMES_INSTANTIATE(double)
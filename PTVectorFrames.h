@@ -0,0 +1,75 @@
+/******************************************************************************
+*
+*     PTVectorFrames.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTORFRAMES_H_INCLUDED
+#define PTVECTORFRAMES_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTMatrix.h"
+#include <cstddef>
+#include <vector>
+
+// Orientation frames for many view directions at once
+// The frame is the one calculateUpAndRight() builds: right is level (its z
+// is zero) and up is right / forward, both unit length. Written out,
+//
+//  right = {y, -x, 0}/h                 where h = sqrt(x*x + y*y)
+//  up = {-x*z, -y*z, h*h}/(h*|f|)
+//
+// so each direction costs two reciprocal square roots and no cross products.
+// The batch versions use the SIMD rsqrt, which keeps every component within
+// 1e-6 of calculateUpAndRight() for float.
+//
+// Degenerate directions are handled the same way by every function here:
+//  zero        a direction whose squared length is below
+//              numeric_limits<S>::min()/epsilon^2 (about 1e-12 long for
+//              float, 1e-138 for double) gives zero for all three vectors
+//  vertical    a direction whose horizontal part is within epsilon of its
+//              length gets the fixed frame calculateUpAndRight() gives
+//              straight up or down: up = {0, +-1, 0}, right = {+-1, 0, 0},
+//              signed as z. forward is still the normalised direction.
+//
+// calculateFrameArrays(viewDirections, forward, up, right);
+// calculateFrameMatrices(viewDirections, worldToView);  // then transformVectorArray
+
+// the scalar version, forward being the normalised direction
+template <typename S>
+void calculateFrame(const BasicTVector<S> &direction, BasicTVector<S> &forward, BasicTVector<S> &up, BasicTVector<S> &right);
+
+// a frame for each direction; any of the outputs may alias directions
+template <typename S>
+void calculateFrameArrays(const BasicTVectorArray<S> &directions,
+                          BasicTVectorArray<S> &forward,
+                          BasicTVectorArray<S> &up,
+                          BasicTVectorArray<S> &right);
+
+// The rotation into each frame, with rows forward, -right and up, so that
+// frame*v has x forward, y to the left and z up, and transpose(frame) turns
+// back again. Zero directions give a zero matrix.
+template <typename S>
+void calculateFrameMatrices(const BasicTVectorArray<S> &directions, std::vector<BasicMatrix3<S> > &frames);
+
+#endif // PTVECTORFRAMES_H_INCLUDED
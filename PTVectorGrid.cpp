@@ -0,0 +1,232 @@
+/******************************************************************************
+*
+*     PTVectorGrid.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorGrid.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+
+// cell coordinates are clamped well inside int32, and neighbour offsets are
+// added in 64 bits, so neither can overflow
+static const double maximumCellCoordinate = 1 << 30;
+static const std::size_t removedSlot = std::size_t(-1);
+
+template <typename S>
+BasicPVectorGrid<S>::BasicPVectorGrid(typename BasicPVector<S>::Scalar cellSize)
+ : cell(cellSize), inverseCell(1.0/cellSize)
+{
+ assert(cellSize > 0);
+}
+
+// NaN fails both comparisons and lands on the highest cell, so the cast never
+// sees a value outside int32
+template <typename S>
+std::int32_t BasicPVectorGrid<S>::cellCoordinate(S x) const
+{
+ double c = std::floor(double(x)*inverseCell);
+ if (!(c <= maximumCellCoordinate)) c = maximumCellCoordinate;
+ if (c < -maximumCellCoordinate) c = -maximumCellCoordinate;
+ return std::int32_t(c);
+}
+
+template <typename S>
+typename BasicPVectorGrid<S>::CellKey BasicPVectorGrid<S>::cellKey(std::int32_t cu, std::int32_t cv)
+{
+ return (CellKey(std::uint32_t(cu)) << 32) | std::uint32_t(cv);
+}
+
+template <typename S>
+void BasicPVectorGrid<S>::addEntry(Id id, const BasicPVector<S> &position, CellKey key)
+{
+ std::vector<Entry> &entries = cells[key];
+ entities[id].cell = key;
+ entities[id].slot = entries.size();
+ entries.push_back({position, id});
+}
+
+// Swaps the last entry of the cell into the gap, and drops the cell once empty
+template <typename S>
+void BasicPVectorGrid<S>::removeEntry(Id id)
+{
+ typename std::unordered_map<CellKey, std::vector<Entry>, CellHash>::iterator it = cells.find(entities[id].cell);
+ std::vector<Entry> &entries = it->second;
+ const std::size_t slot = entities[id].slot;
+ if (slot + 1 != entries.size())
+ {
+  entries[slot] = entries.back();
+  entities[entries[slot].id].slot = slot;
+ }
+ entries.pop_back();
+ if (entries.empty()) cells.erase(it);
+ entities[id].slot = removedSlot;
+}
+
+template <typename S>
+typename BasicPVectorGrid<S>::Id BasicPVectorGrid<S>::insert(const BasicPVector<S> &position)
+{
+ Id id;
+ if (freeIds.empty())
+ {
+  id = entities.size();
+  entities.push_back(Entity{0, removedSlot});
+ }
+ else
+ {
+  id = freeIds.back();
+  freeIds.pop_back();
+ }
+ addEntry(id, position, cellKey(cellCoordinate(position.u), cellCoordinate(position.v)));
+ return id;
+}
+
+template <typename S>
+void BasicPVectorGrid<S>::move(Id id, const BasicPVector<S> &position)
+{
+ assert(id < entities.size() && entities[id].slot != removedSlot);
+ const CellKey key = cellKey(cellCoordinate(position.u), cellCoordinate(position.v));
+ if (key == entities[id].cell)
+ {
+  cells[key][entities[id].slot].position = position;
+  return;
+ }
+ removeEntry(id);
+ addEntry(id, position, key);
+}
+
+template <typename S>
+void BasicPVectorGrid<S>::remove(Id id)
+{
+ assert(id < entities.size() && entities[id].slot != removedSlot);
+ removeEntry(id);
+ freeIds.push_back(id);
+}
+
+template <typename S>
+void BasicPVectorGrid<S>::clear()
+{
+ cells.clear();
+ entities.clear();
+ freeIds.clear();
+}
+
+// Each cell is paired with itself and with the half of its neighbourhood that
+// comes after it, so every pair of cells, and so every pair of entities, is
+// tested exactly once. When the neighbourhood holds more cells than the grid
+// does, each occupied cell is paired with the occupied cells after it in the
+// map instead, which bounds the work at the square of the occupied cells.
+template <typename S>
+void BasicPVectorGrid<S>::pairsWithin(typename BasicPVector<S>::Scalar distance, std::vector<Pair> &pairs) const
+{
+ typedef typename std::unordered_map<CellKey, std::vector<Entry>, CellHash>::const_iterator CellIterator;
+ pairs.clear();
+ if (!(distance >= 0)) return;
+ const S distanceSquared = distance*distance;
+ // no two cells are further apart than twice the largest coordinate
+ const double reachCells = std::ceil(double(distance)*inverseCell);
+ const std::int64_t reach = (reachCells < 1) ? 1 : std::int64_t(std::min(reachCells, 2.0*maximumCellCoordinate));
+ const std::int64_t limit = std::int64_t(maximumCellCoordinate);
+ const bool pairCellsDirectly = double(reach + 1)*double(2*reach + 1) > double(cells.size());
+
+ const auto testCells = [&](const std::vector<Entry> &a, const std::vector<Entry> &b)
+ {
+  for (const Entry &ea : a)
+   for (const Entry &eb : b)
+    if (lengthSquared(ea.position - eb.position) <= distanceSquared)
+     pairs.push_back((ea.id < eb.id) ? Pair(ea.id, eb.id) : Pair(eb.id, ea.id));
+ };
+
+ for (CellIterator c = cells.begin(); c != cells.end(); ++c)
+ {
+  const std::vector<Entry> &a = c->second;
+  for (std::size_t i = 0; i < a.size(); ++i)
+   for (std::size_t j = i + 1; j < a.size(); ++j)
+    if (lengthSquared(a[i].position - a[j].position) <= distanceSquared)
+     pairs.push_back((a[i].id < a[j].id) ? Pair(a[i].id, a[j].id) : Pair(a[j].id, a[i].id));
+
+  const std::int64_t cu = std::int32_t(c->first >> 32), cv = std::int32_t(c->first & 0xFFFFFFFFu);
+  if (pairCellsDirectly)
+  {
+   for (CellIterator other = std::next(c); other != cells.end(); ++other)
+   {
+    const std::int64_t ou = std::int32_t(other->first >> 32), ov = std::int32_t(other->first & 0xFFFFFFFFu);
+    if (std::max(std::abs(ou - cu), std::abs(ov - cv)) <= reach) testCells(a, other->second);
+   }
+   continue;
+  }
+
+  // the neighbourhood stops at the clamped coordinates, where the last cells are
+  const std::int64_t duHigh = std::min(reach, limit - cu);
+  const std::int64_t dvLow = std::max(-reach, -limit - cv), dvHigh = std::min(reach, limit - cv);
+  for (std::int64_t du = 0; du <= duHigh; ++du)
+   for (std::int64_t dv = dvLow; dv <= dvHigh; ++dv)
+   {
+    if (du == 0 && dv <= 0) continue;
+    CellIterator other = cells.find(cellKey(std::int32_t(cu + du), std::int32_t(cv + dv)));
+    if (other != cells.end()) testCells(a, other->second);
+   }
+ }
+}
+
+// When the square of cells around p outnumbers the occupied cells, the
+// occupied cells are checked against it instead
+template <typename S>
+void BasicPVectorGrid<S>::withinRadius(const BasicPVector<S> &p, typename BasicPVector<S>::Scalar radius, std::vector<Id> &ids) const
+{
+ typedef typename std::unordered_map<CellKey, std::vector<Entry>, CellHash>::const_iterator CellIterator;
+ ids.clear();
+ if (!(radius >= 0)) return;
+ const S radiusSquared = radius*radius;
+ const std::int32_t uLow = cellCoordinate(p.u - radius), uHigh = cellCoordinate(p.u + radius);
+ const std::int32_t vLow = cellCoordinate(p.v - radius), vHigh = cellCoordinate(p.v + radius);
+
+ const auto testCell = [&](const std::vector<Entry> &entries)
+ {
+  for (const Entry &e : entries)
+   if (lengthSquared(e.position - p) <= radiusSquared) ids.push_back(e.id);
+ };
+
+ if ((double(uHigh) - uLow + 1)*(double(vHigh) - vLow + 1) > double(cells.size()))
+ {
+  for (CellIterator c = cells.begin(); c != cells.end(); ++c)
+  {
+   const std::int32_t cu = std::int32_t(c->first >> 32), cv = std::int32_t(c->first & 0xFFFFFFFFu);
+   if (cu >= uLow && cu <= uHigh && cv >= vLow && cv <= vHigh) testCell(c->second);
+  }
+  return;
+ }
+
+ for (std::int32_t cu = uLow; cu <= uHigh; ++cu)
+  for (std::int32_t cv = vLow; cv <= vHigh; ++cv)
+  {
+   CellIterator c = cells.find(cellKey(cu, cv));
+   if (c != cells.end()) testCell(c->second);
+  }
+}
+
+template class BasicPVectorGrid<float>;
+template class BasicPVectorGrid<double>;
@@ -0,0 +1,133 @@
+/******************************************************************************
+*
+*     PTVectorGrid.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTORGRID_H_INCLUDED
+#define PTVECTORGRID_H_INCLUDED
+
+#include "PTVectors.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A spatial hash of PVector positions on a uniform grid of square u/v cells,
+// for broad phase proximity tests that scale with the number of entities
+// rather than its square.
+// Entities are inserted, moved and removed one at a time and are named by the
+// id insert returns; ids of removed entities are reused. Positions with NaN
+// components are kept in an edge cell and never match a query. Pick a cell size
+// near the distance usually queried: queries look at the cells within
+// ceil(distance/cellSize) of each entity.
+//
+// PVectorGrid grid(2.0);
+// PVectorGrid::Id id = grid.insert(position);
+// grid.move(id, newPosition);
+// grid.pairsWithin(2.0, pairs);                   // every pair of entities within 2.0
+template <typename S>
+class BasicPVectorGrid
+{
+public:
+ typedef S Scalar;
+ typedef std::size_t Id;
+ typedef std::pair<Id, Id> Pair;
+
+ explicit BasicPVectorGrid(typename BasicPVector<S>::Scalar cellSize);
+
+ Id insert(const BasicPVector<S> &position);
+ void move(Id id, const BasicPVector<S> &position);
+ void remove(Id id);
+ void clear();
+
+ // the number of entities in the grid
+ std::size_t size() const
+ {
+  return entities.size() - freeIds.size();
+ }
+
+ S cellSize() const
+ {
+  return cell;
+ }
+
+ BasicPVector<S> position(Id id) const
+ {
+  return cells.at(entities[id].cell)[entities[id].slot].position;
+ }
+
+ // Writes every pair of entities no further apart than distance into pairs,
+ // each pair once with the lower id first, in no particular order. Each
+ // occupied cell looks up about 2*reach^2 neighbours, reach being
+ // ceil(distance/cellSize), or is compared with every other occupied cell
+ // when there are fewer of those. A distance many cells wide gets slow quickly.
+ void pairsWithin(typename BasicPVector<S>::Scalar distance, std::vector<Pair> &pairs) const;
+
+ // Writes the ids of the entities within radius of p into ids, in no
+ // particular order. It looks up (2*radius/cellSize + 1)^2 cells or so, or
+ // checks every occupied cell when there are fewer of those.
+ void withinRadius(const BasicPVector<S> &p, typename BasicPVector<S>::Scalar radius, std::vector<Id> &ids) const;
+
+private:
+ typedef std::uint64_t CellKey;
+
+ // Cells hold positions alongside ids so the pair tests read memory in order
+ struct Entry
+ {
+  BasicPVector<S> position;
+  Id id;
+ };
+
+ struct Entity
+ {
+  CellKey cell;
+  std::size_t slot;    // index of the entity's Entry in its cell
+ };
+
+ struct CellHash
+ {
+  std::size_t operator()(CellKey key) const
+  {
+   key *= 0x9E3779B97F4A7C15ull;
+   return std::size_t(key ^ (key >> 32));
+  }
+ };
+
+ std::int32_t cellCoordinate(S x) const;
+ static CellKey cellKey(std::int32_t cu, std::int32_t cv);
+ void addEntry(Id id, const BasicPVector<S> &position, CellKey key);
+ void removeEntry(Id id);
+
+ S cell;
+ S inverseCell;
+ std::unordered_map<CellKey, std::vector<Entry>, CellHash> cells;
+ std::vector<Entity> entities;
+ std::vector<Id> freeIds;
+};
+
+// instantiated for float and double in PTVectorGrid.cpp
+typedef BasicPVectorGrid<VectorPrecision> PVectorGrid;
+typedef BasicPVectorGrid<double> PVectorGridD;
+
+#endif // PTVECTORGRID_H_INCLUDED
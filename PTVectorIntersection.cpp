@@ -0,0 +1,438 @@
+/******************************************************************************
+*
+*     PTVectorIntersection.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorIntersection.h"
+#include "PTVectorSIMD.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+template <typename S>
+static S miss()
+{
+ return std::numeric_limits<S>::infinity();
+}
+
+// A pack of TVectors, one per lane
+template <typename S>
+struct VectorPack
+{
+ SIMDPack<S> x, y, z;
+};
+
+template <typename S>
+static VectorPack<S> loadVectors(const BasicTVectorArray<S> &a, std::size_t i)
+{
+ typedef SIMDPack<S> Pack;
+ return {Pack::load(&a.xEast[i]), Pack::load(&a.yNorth[i]), Pack::load(&a.zUp[i])};
+}
+
+template <typename S>
+static VectorPack<S> broadcastVector(const BasicTVector<S> &v)
+{
+ typedef SIMDPack<S> Pack;
+ return {Pack::broadcast(v.xEast), Pack::broadcast(v.yNorth), Pack::broadcast(v.zUp)};
+}
+
+template <typename S>
+static VectorPack<S> operator-(const VectorPack<S> &a, const VectorPack<S> &b)
+{
+ return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+template <typename S>
+static SIMDPack<S> dot(const VectorPack<S> &a, const VectorPack<S> &b)
+{
+ return a.x*b.x + a.y*b.y + a.z*b.z;
+}
+
+template <typename S>
+static VectorPack<S> cross(const VectorPack<S> &a, const VectorPack<S> &b)
+{
+ return {a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x};
+}
+
+template <typename S>
+static VectorPack<S> reciprocal(const VectorPack<S> &a)
+{
+ const SIMDPack<S> one = SIMDPack<S>::broadcast(1);
+ return {one/a.x, one/a.y, one/a.z};
+}
+
+// The SIMD kernels follow the scalar functions step for step, with the
+// rejections gathered into one mask and a single select of infinity
+
+template <typename S>
+static inline SIMDPack<S> raySpherePack(const VectorPack<S> &origin, const VectorPack<S> &direction, const VectorPack<S> &centre, SIMDPack<S> radius)
+{
+ typedef SIMDPack<S> Pack;
+ const Pack zero = Pack::broadcast(0), none = Pack::broadcast(miss<S>());
+ const VectorPack<S> offset = origin - centre;
+ const Pack a = dot(direction, direction);
+ const Pack b = dot(offset, direction);
+ const Pack c = dot(offset, offset) - radius*radius;
+ const Pack discriminant = b*b - a*c;
+ const Pack root = simdSqrt(simdMax(discriminant, zero));
+ const Pack near = (zero - b - root)/a;
+ const Pack far = (zero - b + root)/a;
+ const auto isMiss = simdOr(simdOr(simdLessThan(far, zero), simdLessThan(discriminant, zero)), simdIsZero(a));
+ return simdSelect(isMiss, none, simdSelect(simdLessThan(near, zero), far, near));
+}
+
+// Narrows [near, far] to where the ray is between the planes of one slab
+template <typename S>
+static inline void slabPack(SIMDPack<S> origin, SIMDPack<S> recipDirection, SIMDPack<S> min, SIMDPack<S> max, SIMDPack<S> &near, SIMDPack<S> &far)
+{
+ const SIMDPack<S> t1 = (min - origin)*recipDirection;
+ const SIMDPack<S> t2 = (max - origin)*recipDirection;
+ near = simdMax(near, simdMin(t1, t2));
+ far = simdMin(far, simdMax(t1, t2));
+}
+
+template <typename S>
+static inline SIMDPack<S> rayBoxPack(const VectorPack<S> &origin, const VectorPack<S> &recipDirection, const VectorPack<S> &min, const VectorPack<S> &max)
+{
+ typedef SIMDPack<S> Pack;
+ const Pack none = Pack::broadcast(miss<S>());
+ Pack near = Pack::broadcast(0), far = none;
+ slabPack(origin.x, recipDirection.x, min.x, max.x, near, far);
+ slabPack(origin.y, recipDirection.y, min.y, max.y, near, far);
+ slabPack(origin.z, recipDirection.z, min.z, max.z, near, far);
+ // near <= far, false when a ray in the plane of a face has left NaN in
+ // either, so that misses
+ const auto isOrdered = simdOr(simdLessThan(near, far), simdIsZero(far - near));
+ return simdSelect(isOrdered, simdSelect(simdLessThan(Pack::broadcast(std::numeric_limits<S>::max()), far), none, near), none);
+}
+
+// edge1 and edge2 run from corner a to b and c
+template <typename S>
+static inline SIMDPack<S> rayTrianglePack(const VectorPack<S> &origin, const VectorPack<S> &direction,
+                                   const VectorPack<S> &a, const VectorPack<S> &edge1, const VectorPack<S> &edge2)
+{
+ typedef SIMDPack<S> Pack;
+ const Pack zero = Pack::broadcast(0), one = Pack::broadcast(1), none = Pack::broadcast(miss<S>());
+ const VectorPack<S> p = cross(direction, edge2);
+ const Pack determinant = dot(edge1, p);
+ const Pack recipDeterminant = one/determinant;
+ const VectorPack<S> s = origin - a;
+ const Pack u = dot(s, p)*recipDeterminant;
+ const VectorPack<S> q = cross(s, edge1);
+ const Pack v = dot(direction, q)*recipDeterminant;
+ const Pack t = dot(edge2, q)*recipDeterminant;
+ const auto outside = simdOr(simdOr(simdLessThan(u, zero), simdLessThan(one, u)), simdOr(simdLessThan(v, zero), simdLessThan(one, u + v)));
+ const auto isMiss = simdOr(simdOr(outside, simdLessThan(t, zero)), simdIsZero(determinant));
+ return simdSelect(isMiss, none, t);
+}
+
+// Segments from p by r and q by w, giving the fraction along the first
+template <typename S>
+static inline SIMDPack<S> segmentsPack(SIMDPack<S> pu, SIMDPack<S> pv, SIMDPack<S> ru, SIMDPack<S> rv,
+                                SIMDPack<S> qu, SIMDPack<S> qv, SIMDPack<S> wu, SIMDPack<S> wv)
+{
+ typedef SIMDPack<S> Pack;
+ const Pack zero = Pack::broadcast(0), one = Pack::broadcast(1), none = Pack::broadcast(miss<S>());
+ const Pack denominator = ru*wv - rv*wu;
+ const Pack du = qu - pu, dv = qv - pv;
+ const Pack s = (du*wv - dv*wu)/denominator;
+ const Pack t = (du*rv - dv*ru)/denominator;
+ const auto outside = simdOr(simdOr(simdLessThan(s, zero), simdLessThan(one, s)), simdOr(simdLessThan(t, zero), simdLessThan(one, t)));
+ return simdSelect(simdOr(outside, simdIsZero(denominator)), none, s);
+}
+
+template <typename S>
+bool intersectRaySphere(const BasicRay<S> &ray, const BasicBoundingSphere<S> &sphere, S &t)
+{
+ const BasicTVector<S> offset = ray.origin - sphere.centre;
+ const S a = ray.direction*ray.direction;
+ const S b = offset*ray.direction;
+ const S c = offset*offset - sphere.radius*sphere.radius;
+ const S discriminant = b*b - a*c;
+ if (a == 0.0 || discriminant < 0.0) return false;
+
+ const S root = std::sqrt(discriminant);
+ const S near = (-b - root)/a;
+ const S far = (-b + root)/a;
+ const S nearest = (near < 0.0) ? far : near;
+ if (nearest < 0.0) return false;
+ t = nearest;
+ return true;
+}
+
+// min and max as simdMin and simdMax take them, giving b if either is NaN.
+// A ray lying in the plane of a face makes a NaN, so slab and slabPack must
+// pass it on the same way to agree.
+template <typename S>
+static inline S laneMin(S a, S b)
+{
+ return (a < b) ? a : b;
+}
+
+template <typename S>
+static inline S laneMax(S a, S b)
+{
+ return (a > b) ? a : b;
+}
+
+template <typename S>
+static void slab(S origin, S direction, S min, S max, S &near, S &far)
+{
+ const S recipDirection = S(1.0)/direction;
+ const S t1 = (min - origin)*recipDirection;
+ const S t2 = (max - origin)*recipDirection;
+ near = laneMax(near, laneMin(t1, t2));
+ far = laneMin(far, laneMax(t1, t2));
+}
+
+template <typename S>
+bool intersectRayBox(const BasicRay<S> &ray, const BasicBox<S> &box, S &t)
+{
+ S near = 0.0, far = miss<S>();
+ slab(ray.origin.xEast, ray.direction.xEast, box.min.xEast, box.max.xEast, near, far);
+ slab(ray.origin.yNorth, ray.direction.yNorth, box.min.yNorth, box.max.yNorth, near, far);
+ slab(ray.origin.zUp, ray.direction.zUp, box.min.zUp, box.max.zUp, near, far);
+ if (!(near <= far) || far == miss<S>()) return false;
+ t = near;
+ return true;
+}
+
+template <typename S>
+bool intersectRayTriangle(const BasicRay<S> &ray, const BasicTVector<S> &a, const BasicTVector<S> &b, const BasicTVector<S> &c, S &t)
+{
+ const BasicTVector<S> edge1 = b - a, edge2 = c - a;
+ const BasicTVector<S> p = ray.direction/edge2;
+ const S determinant = edge1*p;
+ if (determinant == 0.0) return false;
+
+ const S recipDeterminant = S(1.0)/determinant;
+ const BasicTVector<S> s = ray.origin - a;
+ const S u = (s*p)*recipDeterminant;
+ if (u < 0.0 || 1.0 < u) return false;
+ const BasicTVector<S> q = s/edge1;
+ const S v = (ray.direction*q)*recipDeterminant;
+ if (v < 0.0 || 1.0 < u + v) return false;
+ const S distance = (edge2*q)*recipDeterminant;
+ if (distance < 0.0) return false;
+ t = distance;
+ return true;
+}
+
+template <typename S>
+bool intersectSegments(const BasicPVector<S> &p0, const BasicPVector<S> &p1,
+                       const BasicPVector<S> &q0, const BasicPVector<S> &q1, S &s, S &t)
+{
+ const BasicPVector<S> r = p1 - p0, w = q1 - q0, d = q0 - p0;
+ const S denominator = r.u*w.v - r.v*w.u;
+ if (denominator == 0.0) return false;
+
+ const S alongP = (d.u*w.v - d.v*w.u)/denominator;
+ const S alongQ = (d.u*r.v - d.v*r.u)/denominator;
+ if (alongP < 0.0 || 1.0 < alongP || alongQ < 0.0 || 1.0 < alongQ) return false;
+ s = alongP;
+ t = alongQ;
+ return true;
+}
+
+// The batch forms. Each runs the pack kernel and finishes the block with the
+// scalar function.
+
+template <typename S>
+void intersectRaysSphere(const BasicTVectorArray<S> &origins, const BasicTVectorArray<S> &directions,
+                         const BasicBoundingSphere<S> &sphere, BasicScalarArray<S> &t, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = origins.size();
+ t.resize(n);
+ const VectorPack<S> centre = broadcastVector(sphere.centre);
+ const Pack radius = Pack::broadcast(sphere.radius);
+ forEachBlock(n, intersectionBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+   raySpherePack(loadVectors(origins, i), loadVectors(directions, i), centre, radius).store(&t[i]);
+  for (; i < end; ++i)
+   if (!intersectRaySphere(BasicRay<S>{origins[i], directions[i]}, sphere, t[i])) t[i] = miss<S>();
+ });
+}
+
+template <typename S>
+void intersectRaySpheres(const BasicRay<S> &ray, const BasicTVectorArray<S> &centres, const BasicScalarArray<S> &radii,
+                         BasicScalarArray<S> &t, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = centres.size();
+ t.resize(n);
+ const VectorPack<S> origin = broadcastVector(ray.origin), direction = broadcastVector(ray.direction);
+ forEachBlock(n, intersectionBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+   raySpherePack(origin, direction, loadVectors(centres, i), Pack::load(&radii[i])).store(&t[i]);
+  for (; i < end; ++i)
+   if (!intersectRaySphere(ray, BasicBoundingSphere<S>{centres[i], radii[i]}, t[i])) t[i] = miss<S>();
+ });
+}
+
+template <typename S>
+void intersectRaysBox(const BasicTVectorArray<S> &origins, const BasicTVectorArray<S> &directions,
+                      const BasicBox<S> &box, BasicScalarArray<S> &t, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = origins.size();
+ t.resize(n);
+ const VectorPack<S> min = broadcastVector(box.min), max = broadcastVector(box.max);
+ forEachBlock(n, intersectionBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+   rayBoxPack(loadVectors(origins, i), reciprocal(loadVectors(directions, i)), min, max).store(&t[i]);
+  for (; i < end; ++i)
+   if (!intersectRayBox(BasicRay<S>{origins[i], directions[i]}, box, t[i])) t[i] = miss<S>();
+ });
+}
+
+template <typename S>
+void intersectRayBoxes(const BasicRay<S> &ray, const BasicTVectorArray<S> &mins, const BasicTVectorArray<S> &maxs,
+                       BasicScalarArray<S> &t, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = mins.size();
+ t.resize(n);
+ const VectorPack<S> origin = broadcastVector(ray.origin);
+ const VectorPack<S> recipDirection = reciprocal(broadcastVector(ray.direction));
+ forEachBlock(n, intersectionBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+   rayBoxPack(origin, recipDirection, loadVectors(mins, i), loadVectors(maxs, i)).store(&t[i]);
+  for (; i < end; ++i)
+   if (!intersectRayBox(ray, BasicBox<S>{mins[i], maxs[i]}, t[i])) t[i] = miss<S>();
+ });
+}
+
+template <typename S>
+void intersectRaysTriangle(const BasicTVectorArray<S> &origins, const BasicTVectorArray<S> &directions,
+                           const BasicTVector<S> &a, const BasicTVector<S> &b, const BasicTVector<S> &c,
+                           BasicScalarArray<S> &t, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = origins.size();
+ t.resize(n);
+ const VectorPack<S> corner = broadcastVector(a), edge1 = broadcastVector(b - a), edge2 = broadcastVector(c - a);
+ forEachBlock(n, intersectionBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+   rayTrianglePack(loadVectors(origins, i), loadVectors(directions, i), corner, edge1, edge2).store(&t[i]);
+  for (; i < end; ++i)
+   if (!intersectRayTriangle(BasicRay<S>{origins[i], directions[i]}, a, b, c, t[i])) t[i] = miss<S>();
+ });
+}
+
+template <typename S>
+void intersectRayTriangles(const BasicRay<S> &ray, const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b, const BasicTVectorArray<S> &c,
+                           BasicScalarArray<S> &t, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = a.size();
+ t.resize(n);
+ const VectorPack<S> origin = broadcastVector(ray.origin), direction = broadcastVector(ray.direction);
+ forEachBlock(n, intersectionBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+  {
+   const VectorPack<S> corner = loadVectors(a, i);
+   rayTrianglePack(origin, direction, corner, loadVectors(b, i) - corner, loadVectors(c, i) - corner).store(&t[i]);
+  }
+  for (; i < end; ++i)
+   if (!intersectRayTriangle(ray, a[i], b[i], c[i], t[i])) t[i] = miss<S>();
+ });
+}
+
+template <typename S>
+void intersectSegments(const BasicPVector<S> &p0, const BasicPVector<S> &p1,
+                       const BasicPVectorArray<S> &q0, const BasicPVectorArray<S> &q1,
+                       BasicScalarArray<S> &s, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = q0.size();
+ s.resize(n);
+ const Pack pu = Pack::broadcast(p0.u), pv = Pack::broadcast(p0.v);
+ const Pack ru = Pack::broadcast(p1.u - p0.u), rv = Pack::broadcast(p1.v - p0.v);
+ forEachBlock(n, intersectionBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+  {
+   const Pack qu = Pack::load(&q0.u[i]), qv = Pack::load(&q0.v[i]);
+   segmentsPack(pu, pv, ru, rv, qu, qv, Pack::load(&q1.u[i]) - qu, Pack::load(&q1.v[i]) - qv).store(&s[i]);
+  }
+  S t;
+  for (; i < end; ++i)
+   if (!intersectSegments(p0, p1, q0[i], q1[i], s[i], t)) s[i] = miss<S>();
+ });
+}
+
+template <typename S>
+void intersectSegments(const BasicPVectorArray<S> &p0, const BasicPVectorArray<S> &p1,
+                       const BasicPVector<S> &q0, const BasicPVector<S> &q1,
+                       BasicScalarArray<S> &s, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = p0.size();
+ s.resize(n);
+ const Pack qu = Pack::broadcast(q0.u), qv = Pack::broadcast(q0.v);
+ const Pack wu = Pack::broadcast(q1.u - q0.u), wv = Pack::broadcast(q1.v - q0.v);
+ forEachBlock(n, intersectionBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+  {
+   const Pack pu = Pack::load(&p0.u[i]), pv = Pack::load(&p0.v[i]);
+   segmentsPack(pu, pv, Pack::load(&p1.u[i]) - pu, Pack::load(&p1.v[i]) - pv, qu, qv, wu, wv).store(&s[i]);
+  }
+  S t;
+  for (; i < end; ++i)
+   if (!intersectSegments(p0[i], p1[i], q0, q1, s[i], t)) s[i] = miss<S>();
+ });
+}
+
+#define PTVECTORINTERSECTION_INSTANTIATE(S) \
+ template bool intersectRaySphere(const BasicRay<S>&, const BasicBoundingSphere<S>&, S&); \
+ template void intersectRaysSphere(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, const BasicBoundingSphere<S>&, BasicScalarArray<S>&, VectorThreadPool*); \
+ template void intersectRaySpheres(const BasicRay<S>&, const BasicTVectorArray<S>&, const BasicScalarArray<S>&, BasicScalarArray<S>&, VectorThreadPool*); \
+ template bool intersectRayBox(const BasicRay<S>&, const BasicBox<S>&, S&); \
+ template void intersectRaysBox(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, const BasicBox<S>&, BasicScalarArray<S>&, VectorThreadPool*); \
+ template void intersectRayBoxes(const BasicRay<S>&, const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, BasicScalarArray<S>&, VectorThreadPool*); \
+ template bool intersectRayTriangle(const BasicRay<S>&, const BasicTVector<S>&, const BasicTVector<S>&, const BasicTVector<S>&, S&); \
+ template void intersectRaysTriangle(const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, const BasicTVector<S>&, const BasicTVector<S>&, const BasicTVector<S>&, BasicScalarArray<S>&, VectorThreadPool*); \
+ template void intersectRayTriangles(const BasicRay<S>&, const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, const BasicTVectorArray<S>&, BasicScalarArray<S>&, VectorThreadPool*); \
+ template bool intersectSegments(const BasicPVector<S>&, const BasicPVector<S>&, const BasicPVector<S>&, const BasicPVector<S>&, S&, S&); \
+ template void intersectSegments(const BasicPVector<S>&, const BasicPVector<S>&, const BasicPVectorArray<S>&, const BasicPVectorArray<S>&, BasicScalarArray<S>&, VectorThreadPool*); \
+ template void intersectSegments(const BasicPVectorArray<S>&, const BasicPVectorArray<S>&, const BasicPVector<S>&, const BasicPVector<S>&, BasicScalarArray<S>&, VectorThreadPool*);
+
+PTVECTORINTERSECTION_INSTANTIATE(float)
+PTVECTORINTERSECTION_INSTANTIATE(double)
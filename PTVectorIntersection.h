@@ -0,0 +1,135 @@
+/******************************************************************************
+*
+*     PTVectorIntersection.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#ifndef PTVECTORINTERSECTION_H_INCLUDED
+#define PTVECTORINTERSECTION_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTVectorReductions.h"
+#include "PTVectorThreadPool.h"
+#include <cstddef>
+
+// Ray and segment intersection tests, one at a time or in batches.
+// Each test comes in three forms: the scalar one, many rays against one
+// primitive, and one ray against many primitives. The batch forms run the
+// SIMD kernels over a pack of rays or primitives at once, with the single
+// side broadcast, in blocks of intersectionBlockSize spread across a
+// VectorThreadPool when one is given.
+//
+// Distances are measured in multiples of the ray direction, which need not
+// be unit length, and the nearest hit at or beyond the origin is reported.
+// The scalar forms return false for a miss, and the batch forms write
+// infinity, so the nearest hit of a batch is its minimum.
+//
+// RayD ray = {eye, viewDirection};
+// double t;
+// if (intersectRayTriangle(ray, a, b, c, t)) hit = ray.origin + ray.direction*t;
+// intersectRaysBox(origins, directions, bounds, distances, &pool);
+//
+// Edge cases are decided the same way by the scalar and batch forms, and a
+// ray with zero direction misses everything:
+//  sphere      a ray starting inside gets the distance to where it leaves
+//  box         a ray starting inside gets 0. A ray that lies exactly in the
+//              plane of a face may count as a hit or a miss, but never gives
+//              a NaN distance.
+//  triangle    both sides are hit, and hits on an edge count. Rays in the
+//              plane of the triangle miss.
+//  segments    parallel and collinear segments don't intersect; touching
+//              at an end does.
+
+static const std::size_t intersectionBlockSize = 4096;
+
+template <typename S>
+struct BasicRay
+{
+ BasicTVector<S> origin;
+ BasicTVector<S> direction;
+};
+
+typedef BasicRay<VectorPrecision> Ray;
+typedef BasicRay<double> RayD;
+
+// An axis aligned box, as reduceBounds() gives
+template <typename S>
+struct BasicBox
+{
+ BasicTVector<S> min;
+ BasicTVector<S> max;
+};
+
+typedef BasicBox<VectorPrecision> Box;
+typedef BasicBox<double> BoxD;
+
+// All of these are instantiated for float and double in PTVectorIntersection.cpp
+
+template <typename S>
+bool intersectRaySphere(const BasicRay<S> &ray, const BasicBoundingSphere<S> &sphere, S &t);
+template <typename S>
+void intersectRaysSphere(const BasicTVectorArray<S> &origins, const BasicTVectorArray<S> &directions,
+                         const BasicBoundingSphere<S> &sphere, BasicScalarArray<S> &t, VectorThreadPool *pool = nullptr);
+template <typename S>
+void intersectRaySpheres(const BasicRay<S> &ray, const BasicTVectorArray<S> &centres, const BasicScalarArray<S> &radii,
+                         BasicScalarArray<S> &t, VectorThreadPool *pool = nullptr);
+
+// The slab test; t is where the ray enters the box
+template <typename S>
+bool intersectRayBox(const BasicRay<S> &ray, const BasicBox<S> &box, S &t);
+template <typename S>
+void intersectRaysBox(const BasicTVectorArray<S> &origins, const BasicTVectorArray<S> &directions,
+                      const BasicBox<S> &box, BasicScalarArray<S> &t, VectorThreadPool *pool = nullptr);
+template <typename S>
+void intersectRayBoxes(const BasicRay<S> &ray, const BasicTVectorArray<S> &mins, const BasicTVectorArray<S> &maxs,
+                       BasicScalarArray<S> &t, VectorThreadPool *pool = nullptr);
+
+// Moller-Trumbore, with the triangle as its corners a, b and c
+template <typename S>
+bool intersectRayTriangle(const BasicRay<S> &ray, const BasicTVector<S> &a, const BasicTVector<S> &b, const BasicTVector<S> &c, S &t);
+template <typename S>
+void intersectRaysTriangle(const BasicTVectorArray<S> &origins, const BasicTVectorArray<S> &directions,
+                           const BasicTVector<S> &a, const BasicTVector<S> &b, const BasicTVector<S> &c,
+                           BasicScalarArray<S> &t, VectorThreadPool *pool = nullptr);
+template <typename S>
+void intersectRayTriangles(const BasicRay<S> &ray, const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b, const BasicTVectorArray<S> &c,
+                           BasicScalarArray<S> &t, VectorThreadPool *pool = nullptr);
+
+// Segments from p0 to p1 and q0 to q1 in the plane. s and t are the
+// fractions of the way along each, from 0 to 1, where they cross.
+template <typename S>
+bool intersectSegments(const BasicPVector<S> &p0, const BasicPVector<S> &p1,
+                       const BasicPVector<S> &q0, const BasicPVector<S> &q1, S &s, S &t);
+// The batch forms give the fraction along the first argument: along the one
+// segment for each of many, or along each of many for the one segment.
+template <typename S>
+void intersectSegments(const BasicPVector<S> &p0, const BasicPVector<S> &p1,
+                       const BasicPVectorArray<S> &q0, const BasicPVectorArray<S> &q1,
+                       BasicScalarArray<S> &s, VectorThreadPool *pool = nullptr);
+template <typename S>
+void intersectSegments(const BasicPVectorArray<S> &p0, const BasicPVectorArray<S> &p1,
+                       const BasicPVector<S> &q0, const BasicPVector<S> &q1,
+                       BasicScalarArray<S> &s, VectorThreadPool *pool = nullptr);
+
+#endif // PTVECTORINTERSECTION_H_INCLUDED
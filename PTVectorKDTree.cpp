@@ -0,0 +1,268 @@
+/******************************************************************************
+*
+*     PTVectorKDTree.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorKDTree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+template <typename S>
+static inline S component(const BasicTVector<S> &v, int axis)
+{
+ return (axis == 0) ? v.xEast : (axis == 1) ? v.yNorth : v.zUp;
+}
+
+template <typename S>
+BasicTVectorKDTree<S>::BasicTVectorKDTree(const BasicTVector<S> *points, std::size_t n)
+{
+ build(points, n);
+}
+
+template <typename S>
+BasicTVectorKDTree<S>::BasicTVectorKDTree(const std::vector<BasicTVector<S> > &points)
+{
+ build(points.data(), points.size());
+}
+
+template <typename S>
+BasicTVectorKDTree<S>::BasicTVectorKDTree(const BasicTVectorArray<S> &points)
+{
+ std::vector<BasicTVector<S> > aos(points.size());
+ points.copyTo(aos.data());
+ build(aos.data(), aos.size());
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::build(const BasicTVector<S> *input, std::size_t n)
+{
+ order.resize(n);
+ for (std::size_t i = 0; i < n; ++i) order[i] = i;
+ nodes.clear();
+ nodes.reserve(2*(n/leafSize) + 1);
+ if (n > 0) buildNode(input, 0, n);
+
+ // copy the points into tree order so each leaf is contiguous
+ points.resize(n);
+ for (std::size_t i = 0; i < n; ++i) points[i] = input[order[i]];
+}
+
+// Splits at the median of the axis with the widest extent. nth_element keeps
+// the build O(n log n) without sorting each range.
+template <typename S>
+std::size_t BasicTVectorKDTree<S>::buildNode(const BasicTVector<S> *input, std::size_t begin, std::size_t end)
+{
+ const std::size_t index = nodes.size();
+ nodes.push_back(Node{begin, end, 0, 0, 0.0});
+ if (end - begin <= leafSize) return index;
+
+ BasicTVector<S> low = input[order[begin]], high = low;
+ for (std::size_t i = begin + 1; i < end; ++i)
+ {
+  const BasicTVector<S> &p = input[order[i]];
+  low = {std::min(low.xEast, p.xEast), std::min(low.yNorth, p.yNorth), std::min(low.zUp, p.zUp)};
+  high = {std::max(high.xEast, p.xEast), std::max(high.yNorth, p.yNorth), std::max(high.zUp, p.zUp)};
+ }
+ const BasicTVector<S> extent = high - low;
+ int axis = 0;
+ if (extent.yNorth > extent.xEast) axis = 1;
+ if (extent.zUp > component(extent, axis)) axis = 2;
+
+ const std::size_t mid = begin + (end - begin)/2;
+ // NaN sorts after everything, keeping the ordering strict weak
+ std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+  [input, axis](std::size_t a, std::size_t b)
+  {
+   const S ca = component(input[a], axis), cb = component(input[b], axis);
+   return (ca < cb) || (std::isnan(cb) && !std::isnan(ca));
+  });
+
+ // set before recursing, which reorders the children's ranges
+ nodes[index].axis = axis;
+ nodes[index].split = component(input[order[mid]], axis);
+ buildNode(input, begin, mid);
+ const std::size_t right = buildNode(input, mid, end);
+ nodes[index].right = right;
+ return index;
+}
+
+// Each search goes down the side of the split q is on first, then only visits
+// the other side if the splitting plane is closer than the worst match so far.
+// NaN distances never compare less, so points with NaN components are never
+// matched.
+
+template <typename S>
+void BasicTVectorKDTree<S>::searchNearest(std::size_t node, const BasicTVector<S> &q, std::size_t &best, S &bestDistance) const
+{
+ const Node &n = nodes[node];
+ if (n.right == 0)
+ {
+  for (std::size_t i = n.begin; i < n.end; ++i)
+  {
+   S d = lengthSquared(points[i] - q);
+   if (d < bestDistance)
+   {
+    bestDistance = d;
+    best = i;
+   }
+  }
+  return;
+ }
+
+ const S diff = component(q, n.axis) - n.split;
+ searchNearest((diff < 0) ? node + 1 : n.right, q, best, bestDistance);
+ if (diff*diff < bestDistance) searchNearest((diff < 0) ? n.right : node + 1, q, best, bestDistance);
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::searchNearest(std::size_t node, const BasicTVector<S> &q, std::size_t k, Heap &heap) const
+{
+ const Node &n = nodes[node];
+ if (n.right == 0)
+ {
+  for (std::size_t i = n.begin; i < n.end; ++i)
+  {
+   S d = lengthSquared(points[i] - q);
+   if (std::isnan(d)) continue;
+   if (heap.size() < k)
+   {
+    heap.push_back({d, i});
+    std::push_heap(heap.begin(), heap.end());
+   }
+   else if (d < heap.front().first)
+   {
+    std::pop_heap(heap.begin(), heap.end());
+    heap.back() = {d, i};
+    std::push_heap(heap.begin(), heap.end());
+   }
+  }
+  return;
+ }
+
+ const S diff = component(q, n.axis) - n.split;
+ searchNearest((diff < 0) ? node + 1 : n.right, q, k, heap);
+ if (heap.size() < k || diff*diff < heap.front().first)
+  searchNearest((diff < 0) ? n.right : node + 1, q, k, heap);
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::searchRadius(std::size_t node, const BasicTVector<S> &q, S radiusSquared, std::vector<std::size_t> &indices) const
+{
+ const Node &n = nodes[node];
+ if (n.right == 0)
+ {
+  for (std::size_t i = n.begin; i < n.end; ++i)
+   if (lengthSquared(points[i] - q) <= radiusSquared) indices.push_back(order[i]);
+  return;
+ }
+
+ const S diff = component(q, n.axis) - n.split;
+ searchRadius((diff < 0) ? node + 1 : n.right, q, radiusSquared, indices);
+ if (diff*diff <= radiusSquared) searchRadius((diff < 0) ? n.right : node + 1, q, radiusSquared, indices);
+}
+
+template <typename S>
+std::size_t BasicTVectorKDTree<S>::nearest(const BasicTVector<S> &q) const
+{
+ if (points.empty()) return size();
+ std::size_t best = size();
+ S bestDistance = std::numeric_limits<S>::infinity();
+ searchNearest(0, q, best, bestDistance);
+ return (best < size()) ? order[best] : size();
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::nearest(const BasicTVector<S> &q, std::size_t k, std::vector<std::size_t> &indices, std::vector<S> &distancesSquared) const
+{
+ indices.clear();
+ distancesSquared.clear();
+ if (points.empty() || k == 0) return;
+
+ Heap heap;
+ heap.reserve(k);
+ searchNearest(0, q, k, heap);
+ std::sort_heap(heap.begin(), heap.end());
+ for (const std::pair<S, std::size_t> &match : heap)
+ {
+  indices.push_back(order[match.second]);
+  distancesSquared.push_back(match.first);
+ }
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::nearest(const BasicTVector<S> &q, std::size_t k, std::vector<std::size_t> &indices) const
+{
+ std::vector<S> distancesSquared;
+ nearest(q, k, indices, distancesSquared);
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::withinRadius(const BasicTVector<S> &q, typename BasicTVector<S>::Scalar radius, std::vector<std::size_t> &indices) const
+{
+ indices.clear();
+ if (points.empty() || radius < 0) return;
+ searchRadius(0, q, radius*radius, indices);
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::nearest(const BasicTVectorArray<S> &queries, std::vector<std::size_t> &indices) const
+{
+ indices.resize(queries.size());
+ for (std::size_t i = 0; i < queries.size(); ++i) indices[i] = nearest(queries[i]);
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::nearest(const BasicTVectorArray<S> &queries, std::size_t k, std::vector<std::size_t> &indices) const
+{
+ indices.assign(queries.size()*k, size());
+ if (points.empty() || k == 0) return;
+
+ Heap heap;
+ heap.reserve(k);
+ for (std::size_t i = 0; i < queries.size(); ++i)
+ {
+  heap.clear();
+  searchNearest(0, queries[i], k, heap);
+  std::sort_heap(heap.begin(), heap.end());
+  for (std::size_t j = 0; j < heap.size(); ++j) indices[i*k + j] = order[heap[j].second];
+ }
+}
+
+template <typename S>
+void BasicTVectorKDTree<S>::withinRadius(const BasicTVectorArray<S> &queries, typename BasicTVector<S>::Scalar radius,
+                                         std::vector<std::size_t> &offsets, std::vector<std::size_t> &indices) const
+{
+ offsets.resize(queries.size() + 1);
+ indices.clear();
+ offsets[0] = 0;
+ for (std::size_t i = 0; i < queries.size(); ++i)
+ {
+  if (!points.empty() && radius >= 0) searchRadius(0, queries[i], radius*radius, indices);
+  offsets[i + 1] = indices.size();
+ }
+}
+
+template class BasicTVectorKDTree<float>;
+template class BasicTVectorKDTree<double>;
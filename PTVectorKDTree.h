@@ -0,0 +1,119 @@
+/******************************************************************************
+*
+*     PTVectorKDTree.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTORKDTREE_H_INCLUDED
+#define PTVECTORKDTREE_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include <cstddef>
+#include <vector>
+
+// A k-d tree over a fixed set of TVector positions, for nearest neighbour and
+// radius queries without looping over every point.
+// The tree keeps its own copy of the points, so the source can change or go
+// away after it is built; rebuild it when the points move. Queries return
+// indices into the array the tree was built from, and compare squared
+// distances throughout, so no square roots are taken. Points with NaN
+// components, and queries with them, never match anything.
+//
+// TVectorKDTree tree(positions);                 // std::vector<TVector>, TVectorArray or pointer and count
+// std::size_t closest = tree.nearest(target);
+// tree.nearest(target, 5, indices);              // the five closest, closest first
+// tree.withinRadius(target, 10.0, indices);      // every point within 10
+template <typename S>
+class BasicTVectorKDTree
+{
+public:
+ typedef S Scalar;
+
+ // points per leaf, below this a leaf is simply scanned
+ static const std::size_t leafSize = 8;
+
+ BasicTVectorKDTree() = default;
+ BasicTVectorKDTree(const BasicTVector<S> *points, std::size_t n);
+ explicit BasicTVectorKDTree(const std::vector<BasicTVector<S> > &points);
+ explicit BasicTVectorKDTree(const BasicTVectorArray<S> &points);
+
+ // replaces the contents of the tree with points
+ void build(const BasicTVector<S> *points, std::size_t n);
+
+ std::size_t size() const
+ {
+  return points.size();
+ }
+
+ // the index of the nearest point to q, or size() if nothing matches
+ std::size_t nearest(const BasicTVector<S> &q) const;
+
+ // the indices of the k nearest points to q, closest first, and optionally
+ // their squared distances. Fewer than k are returned if fewer match.
+ void nearest(const BasicTVector<S> &q, std::size_t k, std::vector<std::size_t> &indices) const;
+ void nearest(const BasicTVector<S> &q, std::size_t k, std::vector<std::size_t> &indices, std::vector<S> &distancesSquared) const;
+
+ // the indices of every point within radius of q, in no particular order
+ void withinRadius(const BasicTVector<S> &q, typename BasicTVector<S>::Scalar radius, std::vector<std::size_t> &indices) const;
+
+ // Batched queries, one per vector in queries
+ // nearest: indices[i] is the nearest point to queries[i]
+ void nearest(const BasicTVectorArray<S> &queries, std::vector<std::size_t> &indices) const;
+ // k nearest: indices[i*k + j] is the j'th nearest to queries[i], padded
+ // with size() if fewer than k match
+ void nearest(const BasicTVectorArray<S> &queries, std::size_t k, std::vector<std::size_t> &indices) const;
+ // within radius: the matches for queries[i] are indices[offsets[i]] up to
+ // indices[offsets[i + 1]], and offsets has queries.size() + 1 entries
+ void withinRadius(const BasicTVectorArray<S> &queries, typename BasicTVector<S>::Scalar radius,
+                   std::vector<std::size_t> &offsets, std::vector<std::size_t> &indices) const;
+
+private:
+ // Nodes are stored depth first, so a node's left child directly follows it.
+ // right is the index of the right child, or 0 for a leaf.
+ struct Node
+ {
+  std::size_t begin;
+  std::size_t end;
+  std::size_t right;
+  int axis;
+  S split;
+ };
+
+ typedef std::vector<std::pair<S, std::size_t> > Heap;
+
+ std::size_t buildNode(const BasicTVector<S> *input, std::size_t begin, std::size_t end);
+ void searchNearest(std::size_t node, const BasicTVector<S> &q, std::size_t &best, S &bestDistance) const;
+ void searchNearest(std::size_t node, const BasicTVector<S> &q, std::size_t k, Heap &heap) const;
+ void searchRadius(std::size_t node, const BasicTVector<S> &q, S radiusSquared, std::vector<std::size_t> &indices) const;
+
+ // the points in tree order, and the index each had in the input
+ std::vector<BasicTVector<S> > points;
+ std::vector<std::size_t> order;
+ std::vector<Node> nodes;
+};
+
+// instantiated for float and double in PTVectorKDTree.cpp
+typedef BasicTVectorKDTree<VectorPrecision> TVectorKDTree;
+typedef BasicTVectorKDTree<double> TVectorKDTreeD;
+
+#endif // PTVECTORKDTREE_H_INCLUDED
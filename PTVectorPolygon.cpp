@@ -0,0 +1,369 @@
+/******************************************************************************
+*
+*     PTVectorPolygon.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorPolygon.h"
+#include "PTVectorSIMD.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// An edge as the crossing test sees it: u at its lower end, the v range it
+// covers and du/dv
+template <typename S>
+struct PolygonEdge
+{
+ S u, vMin, vMax, slope;
+};
+
+// false for horizontal edges, which never cross
+template <typename S>
+static bool makeEdge(const BasicPVector<S> &a, const BasicPVector<S> &b, PolygonEdge<S> &edge)
+{
+ if (a.v == b.v) return false;
+ const BasicPVector<S> &lower = (a.v < b.v) ? a : b;
+ const BasicPVector<S> &upper = (a.v < b.v) ? b : a;
+ edge = {lower.u, lower.v, upper.v, (upper.u - lower.u)/(upper.v - lower.v)};
+ return true;
+}
+
+template <typename S>
+static std::vector<PolygonEdge<S> > polygonEdges(const BasicPVectorArray<S> &polygon)
+{
+ std::vector<PolygonEdge<S> > edges;
+ edges.reserve(polygon.size());
+ PolygonEdge<S> edge;
+ for (std::size_t i = 0, n = polygon.size(); i < n; ++i)
+  if (makeEdge(polygon[i], polygon[(i + 1 == n) ? 0 : i + 1], edge)) edges.push_back(edge);
+ return edges;
+}
+
+// Whether the line from the point towards +u crosses the edge
+template <typename S>
+static inline bool crosses(S u, S vMin, S vMax, S slope, S pu, S pv)
+{
+ return !(pv < vMin) && pv < vMax && pu < u + (pv - vMin)*slope;
+}
+
+// The same for packs of points or edges, 1 where it crosses and 0 where not
+template <typename S>
+static inline SIMDPack<S> crossingsPack(SIMDPack<S> u, SIMDPack<S> vMin, SIMDPack<S> vMax, SIMDPack<S> slope, SIMDPack<S> pu, SIMDPack<S> pv)
+{
+ typedef SIMDPack<S> Pack;
+ const Pack zero = Pack::broadcast(0), one = Pack::broadcast(1);
+ const Pack c = simdSelect(simdLessThan(pu, u + (pv - vMin)*slope), one, zero);
+ return simdSelect(simdLessThan(pv, vMin), zero, simdSelect(simdLessThan(pv, vMax), c, zero));
+}
+
+// crossings is a whole number of them
+template <typename S>
+static inline bool isOdd(S crossings)
+{
+ return (std::size_t(crossings) & 1) != 0;
+}
+
+template <typename S>
+bool pointInPolygon(const BasicPVectorArray<S> &polygon, const BasicPVector<S> &point)
+{
+ bool inside = false;
+ PolygonEdge<S> e;
+ for (std::size_t i = 0, n = polygon.size(); i < n; ++i)
+  if (makeEdge(polygon[i], polygon[(i + 1 == n) ? 0 : i + 1], e) && crosses(e.u, e.vMin, e.vMax, e.slope, point.u, point.v)) inside = !inside;
+ return inside;
+}
+
+template <typename S>
+void pointsInPolygon(const BasicPVectorArray<S> &polygon, const BasicPVectorArray<S> &points,
+                     std::vector<std::uint8_t> &inside, VectorThreadPool *pool)
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = points.size();
+ inside.resize(n);
+ const std::vector<PolygonEdge<S> > edges = polygonEdges(polygon);
+ forEachBlock(n, polygonBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  std::size_t i = begin;
+  for (; i + Pack::width <= end; i += Pack::width)
+  {
+   const Pack pu = Pack::load(&points.u[i]), pv = Pack::load(&points.v[i]);
+   Pack count = Pack::broadcast(0);
+   for (const PolygonEdge<S> &e : edges)
+    count = count + crossingsPack(Pack::broadcast(e.u), Pack::broadcast(e.vMin), Pack::broadcast(e.vMax), Pack::broadcast(e.slope), pu, pv);
+   S lanes[Pack::width];
+   count.store(lanes);
+   for (std::size_t j = 0; j < Pack::width; ++j) inside[i + j] = isOdd(lanes[j]);
+  }
+  for (; i < end; ++i)
+  {
+   bool odd = false;
+   for (const PolygonEdge<S> &e : edges) odd ^= crosses(e.u, e.vMin, e.vMax, e.slope, points.u[i], points.v[i]);
+   inside[i] = odd;
+  }
+ });
+}
+
+template <typename S>
+BasicPolygonEdgeIndex<S>::BasicPolygonEdgeIndex(const BasicPVectorArray<S> &polygon, std::size_t bands)
+{
+ build(polygon, bands);
+}
+
+// Each band is padded to whole packs with edges that cover no v at all
+template <typename S>
+void BasicPolygonEdgeIndex<S>::build(const BasicPVectorArray<S> &polygon, std::size_t bands)
+{
+ const std::size_t width = SIMDPack<S>::width;
+ const std::vector<PolygonEdge<S> > edges = polygonEdges(polygon);
+ bandStart.clear();
+ edgeU.clear();
+ edgeVMin.clear();
+ edgeVMax.clear();
+ edgeSlope.clear();
+ bottom = top = bandScale = 0;
+ if (edges.empty()) return;
+
+ bottom = edges[0].vMin;
+ top = edges[0].vMax;
+ for (const PolygonEdge<S> &e : edges)
+ {
+  bottom = std::min(bottom, e.vMin);
+  top = std::max(top, e.vMax);
+ }
+ const std::size_t count = bands ? bands : std::max<std::size_t>(1, edges.size()/2);
+ bandScale = S(count)/(top - bottom);
+ auto bandOf = [&](S v) { return std::min(count - 1, std::size_t((v - bottom)*bandScale)); };
+
+ // count the edges in each band, then lay the bands out end to end
+ std::vector<std::size_t> filled(count, 0);
+ for (const PolygonEdge<S> &e : edges)
+  for (std::size_t b = bandOf(e.vMin), last = bandOf(e.vMax); b <= last; ++b) ++filled[b];
+ bandStart.resize(count + 1);
+ bandStart[0] = 0;
+ for (std::size_t b = 0; b < count; ++b) bandStart[b + 1] = bandStart[b] + (filled[b] + width - 1)/width*width;
+
+ const S never = std::numeric_limits<S>::infinity();
+ edgeU.assign(bandStart[count], 0);
+ edgeVMin.assign(bandStart[count], never);
+ edgeVMax.assign(bandStart[count], never);
+ edgeSlope.assign(bandStart[count], 0);
+ std::fill(filled.begin(), filled.end(), 0);
+ for (const PolygonEdge<S> &e : edges)
+ {
+  for (std::size_t b = bandOf(e.vMin), last = bandOf(e.vMax); b <= last; ++b)
+  {
+   const std::size_t k = bandStart[b] + filled[b]++;
+   edgeU[k] = e.u;
+   edgeVMin[k] = e.vMin;
+   edgeVMax[k] = e.vMax;
+   edgeSlope[k] = e.slope;
+  }
+ }
+}
+
+template <typename S>
+bool BasicPolygonEdgeIndex<S>::contains(const BasicPVector<S> &point) const
+{
+ typedef SIMDPack<S> Pack;
+ if (bandStart.empty() || !(bottom <= point.v && point.v < top)) return false;
+
+ const std::size_t band = std::min(bands() - 1, std::size_t((point.v - bottom)*bandScale));
+ const Pack pu = Pack::broadcast(point.u), pv = Pack::broadcast(point.v);
+ Pack count = Pack::broadcast(0);
+ for (std::size_t k = bandStart[band]; k < bandStart[band + 1]; k += Pack::width)
+  count = count + crossingsPack(Pack::load(&edgeU[k]), Pack::load(&edgeVMin[k]), Pack::load(&edgeVMax[k]), Pack::load(&edgeSlope[k]), pu, pv);
+
+ S lanes[Pack::width];
+ count.store(lanes);
+ for (std::size_t half = Pack::width/2; half > 0; half /= 2)
+  for (std::size_t j = 0; j < half; ++j) lanes[j] += lanes[j + half];
+ return isOdd(lanes[0]);
+}
+
+template <typename S>
+void BasicPolygonEdgeIndex<S>::contains(const BasicPVectorArray<S> &points, std::vector<std::uint8_t> &inside, VectorThreadPool *pool) const
+{
+ const std::size_t n = points.size();
+ inside.resize(n);
+ forEachBlock(n, polygonBlockSize, pool, [&](std::size_t begin, std::size_t end)
+ {
+  for (std::size_t i = begin; i < end; ++i) inside[i] = contains(points[i]);
+ });
+}
+
+// Twice the signed area and the sums for the centroid, all about the first
+// vertex to keep them accurate away from the origin. The first and last
+// edges touch that vertex and add nothing.
+template <typename S>
+static void areaSums(const BasicPVectorArray<S> &polygon, S &twiceArea, S &su, S &sv)
+{
+ typedef SIMDPack<S> Pack;
+ twiceArea = su = sv = 0;
+ const std::size_t n = polygon.size();
+ if (n < 3) return;
+
+ const S u0 = polygon.u[0], v0 = polygon.v[0];
+ const Pack pu0 = Pack::broadcast(u0), pv0 = Pack::broadcast(v0);
+ Pack area = Pack::broadcast(0), areaU = area, areaV = area;
+ std::size_t i = 1;
+ for (; i + Pack::width <= n - 1; i += Pack::width)
+ {
+  const Pack au = Pack::load(&polygon.u[i]) - pu0, av = Pack::load(&polygon.v[i]) - pv0;
+  const Pack bu = Pack::load(&polygon.u[i + 1]) - pu0, bv = Pack::load(&polygon.v[i + 1]) - pv0;
+  const Pack cross = au*bv - bu*av;
+  area = area + cross;
+  areaU = areaU + (au + bu)*cross;
+  areaV = areaV + (av + bv)*cross;
+ }
+ S lanes[3][Pack::width];
+ area.store(lanes[0]);
+ areaU.store(lanes[1]);
+ areaV.store(lanes[2]);
+ for (std::size_t j = 0; j < Pack::width; ++j)
+ {
+  twiceArea += lanes[0][j];
+  su += lanes[1][j];
+  sv += lanes[2][j];
+ }
+ for (; i < n - 1; ++i)
+ {
+  const S au = polygon.u[i] - u0, av = polygon.v[i] - v0;
+  const S bu = polygon.u[i + 1] - u0, bv = polygon.v[i + 1] - v0;
+  const S cross = au*bv - bu*av;
+  twiceArea += cross;
+  su += (au + bu)*cross;
+  sv += (av + bv)*cross;
+ }
+}
+
+template <typename S>
+S polygonSignedArea(const BasicPVectorArray<S> &polygon)
+{
+ S twiceArea, su, sv;
+ areaSums(polygon, twiceArea, su, sv);
+ return S(0.5)*twiceArea;
+}
+
+template <typename S>
+BasicPVector<S> polygonCentroid(const BasicPVectorArray<S> &polygon)
+{
+ const std::size_t n = polygon.size();
+ if (n == 0) return {0.0, 0.0};
+
+ S twiceArea, su, sv;
+ areaSums(polygon, twiceArea, su, sv);
+ if (twiceArea != 0.0) return {polygon.u[0] + su/(S(3.0)*twiceArea), polygon.v[0] + sv/(S(3.0)*twiceArea)};
+
+ BasicPVector<S> sum = {0.0, 0.0};
+ for (std::size_t i = 0; i < n; ++i) sum += polygon[i];
+ return sum*(S(1.0)/S(n));
+}
+
+// Positive if o, a, b turn anticlockwise
+template <typename S>
+static S turn(const BasicPVector<S> &o, const BasicPVector<S> &a, const BasicPVector<S> &b)
+{
+ return (a.u - o.u)*(b.v - o.v) - (a.v - o.v)*(b.u - o.u);
+}
+
+template <typename S>
+void convexHull(const BasicPVectorArray<S> &points, BasicPVectorArray<S> &hull)
+{
+ std::vector<BasicPVector<S> > sorted(points.size());
+ points.copyTo(sorted.data());
+ std::sort(sorted.begin(), sorted.end(), [](const BasicPVector<S> &a, const BasicPVector<S> &b)
+ {
+  return a.u < b.u || (a.u == b.u && a.v < b.v);
+ });
+ sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+ if (sorted.size() < 3)
+ {
+  hull = BasicPVectorArray<S>(sorted);
+  return;
+ }
+
+ // the lower chain left to right, then the upper chain back again
+ std::vector<BasicPVector<S> > chain(2*sorted.size());
+ std::size_t k = 0;
+ for (std::size_t i = 0; i < sorted.size(); ++i)
+ {
+  while (k >= 2 && turn(chain[k - 2], chain[k - 1], sorted[i]) <= 0.0) --k;
+  chain[k++] = sorted[i];
+ }
+ for (std::size_t i = sorted.size() - 1, lower = k + 1; i-- > 0;)
+ {
+  while (k >= lower && turn(chain[k - 2], chain[k - 1], sorted[i]) <= 0.0) --k;
+  chain[k++] = sorted[i];
+ }
+ hull = BasicPVectorArray<S>(chain.data(), k - 1);
+}
+
+template <typename S>
+void offsetPolygon(const BasicPVectorArray<S> &polygon, S distance, BasicPVectorArray<S> &result, S miterLimit)
+{
+ std::vector<BasicPVector<S> > corners;
+ corners.reserve(polygon.size());
+ for (std::size_t i = 0; i < polygon.size(); ++i)
+  if (corners.empty() || polygon[i] != corners.back()) corners.push_back(polygon[i]);
+ while (corners.size() > 1 && corners.back() == corners.front()) corners.pop_back();
+ const std::size_t n = corners.size();
+ if (n < 3)
+ {
+  result = BasicPVectorArray<S>(corners);
+  return;
+ }
+
+ // outward is to the right of each edge going anticlockwise
+ const S side = (polygonSignedArea(BasicPVectorArray<S>(corners)) < 0.0) ? -1.0 : 1.0;
+ BasicPVectorArray<S> offset;
+ offset.reserve(n);
+ for (std::size_t i = 0; i < n; ++i)
+ {
+  const BasicPVector<S> &previous = corners[(i == 0) ? n - 1 : i - 1], &corner = corners[i], &next = corners[(i + 1 == n) ? 0 : i + 1];
+  const BasicPVector<S> normal0 = normalize(rotatePVectorRight(corner - previous))*side;
+  const BasicPVector<S> normal1 = normalize(rotatePVectorRight(next - corner))*side;
+  // the mitre is (normal0 + normal1)/(1 + cos) long, sqrt(2/(1 + cos)) times distance
+  const S onePlusCos = S(1.0) + normal0*normal1;
+  const bool outer = turn(previous, corner, next)*side*distance > 0.0;
+  if (onePlusCos <= 0.0 || (outer && onePlusCos*miterLimit*miterLimit < 2.0))
+  {
+   offset.push_back(corner + normal0*distance);
+   offset.push_back(corner + normal1*distance);
+  }
+  else offset.push_back(corner + (normal0 + normal1)*(distance/onePlusCos));
+ }
+ result = offset;
+}
+
+#define PTVECTORPOLYGON_INSTANTIATE(S) \
+ template S polygonSignedArea(const BasicPVectorArray<S>&); \
+ template BasicPVector<S> polygonCentroid(const BasicPVectorArray<S>&); \
+ template bool pointInPolygon(const BasicPVectorArray<S>&, const BasicPVector<S>&); \
+ template void pointsInPolygon(const BasicPVectorArray<S>&, const BasicPVectorArray<S>&, std::vector<std::uint8_t>&, VectorThreadPool*); \
+ template class BasicPolygonEdgeIndex<S>; \
+ template void convexHull(const BasicPVectorArray<S>&, BasicPVectorArray<S>&); \
+ template void offsetPolygon(const BasicPVectorArray<S>&, S, BasicPVectorArray<S>&, S);
+
+PTVECTORPOLYGON_INSTANTIATE(float)
+PTVECTORPOLYGON_INSTANTIATE(double)
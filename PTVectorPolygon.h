@@ -0,0 +1,122 @@
+/******************************************************************************
+*
+*     PTVectorPolygon.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#ifndef PTVECTORPOLYGON_H_INCLUDED
+#define PTVECTORPOLYGON_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTVectorThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Polygons in the plane, held as a PVectorArray of their vertices in order.
+// The last vertex joins back to the first, which shouldn't be repeated.
+// Counter-clockwise polygons have positive area.
+//
+// Containment uses the even-odd rule, so a self-intersecting polygon has
+// holes where it overlaps itself. Each edge counts the points from its lower
+// end up to, but not including, its upper end, so a point on a vertex or
+// edge shared between two polygons that tile the plane is in exactly one.
+//
+// pointsInPolygon(zone, positions, inside, &pool);   // inside[i] is 1 or 0
+// PolygonEdgeIndex index(zone);                      // for big polygons
+// index.contains(positions, inside);
+// convexHull(points, hull);
+// offsetPolygon(zone, 5.0f, margin);                 // 5 out all round
+//
+// The batch tests work through the points in blocks of polygonBlockSize,
+// spread across a VectorThreadPool when one is given.
+
+static const std::size_t polygonBlockSize = 4096;
+
+template <typename S>
+S polygonSignedArea(const BasicPVectorArray<S> &polygon);
+
+// The centre of area, or the mean of the vertices if the area is zero
+template <typename S>
+BasicPVector<S> polygonCentroid(const BasicPVectorArray<S> &polygon);
+
+template <typename S>
+bool pointInPolygon(const BasicPVectorArray<S> &polygon, const BasicPVector<S> &point);
+
+// Tests every point against every edge, a pack of points at a time. Best for
+// polygons of up to a few dozen edges.
+template <typename S>
+void pointsInPolygon(const BasicPVectorArray<S> &polygon, const BasicPVectorArray<S> &points,
+                     std::vector<std::uint8_t> &inside, VectorThreadPool *pool = nullptr);
+
+// The edges of a polygon sorted into horizontal bands, so a point is only
+// tested against the edges level with it, a pack of edges at a time. It
+// gives the same answers as pointInPolygon and keeps its own copy of the
+// edges. bands = 0 picks one band for every two edges.
+template <typename S>
+class BasicPolygonEdgeIndex
+{
+public:
+ typedef S Scalar;
+
+ BasicPolygonEdgeIndex() = default;
+ explicit BasicPolygonEdgeIndex(const BasicPVectorArray<S> &polygon, std::size_t bands = 0);
+
+ void build(const BasicPVectorArray<S> &polygon, std::size_t bands = 0);
+
+ bool contains(const BasicPVector<S> &point) const;
+ void contains(const BasicPVectorArray<S> &points, std::vector<std::uint8_t> &inside, VectorThreadPool *pool = nullptr) const;
+
+ std::size_t bands() const
+ {
+  return bandStart.empty() ? 0 : bandStart.size() - 1;
+ }
+
+private:
+ S bottom = 0, top = 0, bandScale = 0;
+ // the edges of band b are [bandStart[b], bandStart[b + 1]). Each is kept as
+ // u at its lower end, the v range it covers and du/dv.
+ std::vector<std::size_t> bandStart;
+ BasicScalarArray<S> edgeU, edgeVMin, edgeVMax, edgeSlope;
+};
+
+typedef BasicPolygonEdgeIndex<VectorPrecision> PolygonEdgeIndex;
+typedef BasicPolygonEdgeIndex<double> PolygonEdgeIndexD;
+
+// Andrew's monotone chain, O(n log n). The hull is counter-clockwise from the
+// vertex with the lowest u (then v), without collinear points. Fewer than
+// three distinct points come back as they are, without duplicates.
+template <typename S>
+void convexHull(const BasicPVectorArray<S> &points, BasicPVectorArray<S> &hull);
+
+// Moves every edge out by distance, or in if it is negative, joining them at
+// mitred corners. Corners that would stick out more than miterLimit times
+// distance are bevelled instead. Edges shorter than the offset can fold the
+// result over, so shrinking only works down to the narrowest part of the
+// polygon. Repeated vertices are dropped, and fewer than three are left as
+// they are. result may be polygon.
+template <typename S>
+void offsetPolygon(const BasicPVectorArray<S> &polygon, S distance, BasicPVectorArray<S> &result, S miterLimit = 2.0);
+
+#endif // PTVECTORPOLYGON_H_INCLUDED
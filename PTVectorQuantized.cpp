@@ -0,0 +1,248 @@
+/******************************************************************************
+*
+*     PTVectorQuantized.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorQuantized.h"
+#include <algorithm>
+#include <cmath>
+
+static const double quantizedSteps = 65535.0;
+
+// the step for a component spanning extent, never zero
+template <typename S>
+static S quantizedStep(S extent, S tolerance)
+{
+ const S step = std::max(S(2.0)*tolerance, S(extent/quantizedSteps));
+ return (step > S(0.0)) ? step : S(1.0);
+}
+
+template <typename S>
+static std::uint16_t quantize(S value, S origin, S inverseStep)
+{
+ const double q = std::floor(double(value - origin)*double(inverseStep) + 0.5);
+ return std::uint16_t(std::min(std::max(q, 0.0), quantizedSteps));
+}
+
+// zigzag then varint code the wrapped difference of two quantised values
+static void putDelta(std::vector<std::uint8_t> &codes, std::uint16_t from, std::uint16_t to)
+{
+ const std::int16_t delta = std::int16_t(std::uint16_t(to - from));
+ std::uint32_t zigzag = (delta < 0) ? std::uint32_t(-2*std::int32_t(delta) - 1) : std::uint32_t(2*delta);
+ while (zigzag >= 0x80)
+ {
+  codes.push_back(std::uint8_t(zigzag | 0x80));
+  zigzag >>= 7;
+ }
+ codes.push_back(std::uint8_t(zigzag));
+}
+
+static std::uint16_t takeDelta(const std::uint8_t *&p, std::uint16_t from)
+{
+ std::uint32_t zigzag = *p & 0x7f;
+ for (unsigned shift = 7; *p++ & 0x80; shift += 7) zigzag |= std::uint32_t(*p & 0x7f) << shift;
+ const std::int32_t delta = (zigzag & 1) ? -std::int32_t(zigzag >> 1) - 1 : std::int32_t(zigzag >> 1);
+ return std::uint16_t(from + delta);
+}
+
+// origin + q*step for each of n quantised values
+template <typename S>
+static void dequantize(const std::uint16_t *q, std::size_t n, S origin, S step, S *out)
+{
+ typedef SIMDPack<S> Pack;
+ const Pack packOrigin = Pack::broadcast(origin);
+ const Pack packStep = Pack::broadcast(step);
+ const std::size_t packed = n - n%Pack::width;
+ for (std::size_t i = 0; i < packed; i += Pack::width) (packOrigin + Pack::loadUInt16(q + i)*packStep).store(out + i);
+ for (std::size_t i = packed; i < n; ++i) out[i] = origin + S(q[i])*step;
+}
+
+template <typename S>
+BasicQuantizedTVectorArray<S>::BasicQuantizedTVectorArray(S tolerance, QuantizedEncoding encoding) :
+ requestedTolerance(tolerance), coding(encoding)
+{
+}
+
+template <typename S>
+void BasicQuantizedTVectorArray<S>::push_back(const BasicTVector<S> &v)
+{
+ tail.push_back(v);
+ if (tail.size() == quantizedBlockSize)
+ {
+  encodeBlock(tail.xEast.data(), tail.yNorth.data(), tail.zUp.data());
+  tail.clear();
+ }
+}
+
+template <typename S>
+void BasicQuantizedTVectorArray<S>::append(const BasicTVectorArray<S> &a)
+{
+ std::size_t i = 0;
+ for (; i < a.size() && tail.size() != 0; ++i) push_back(a[i]);
+ // whole blocks are encoded straight from the array
+ for (; i + quantizedBlockSize <= a.size(); i += quantizedBlockSize) encodeBlock(&a.xEast[i], &a.yNorth[i], &a.zUp[i]);
+ for (; i < a.size(); ++i) push_back(a[i]);
+}
+
+template <typename S>
+void BasicQuantizedTVectorArray<S>::clear()
+{
+ blocks.clear();
+ words.clear();
+ codes.clear();
+ tail.clear();
+}
+
+template <typename S>
+void BasicQuantizedTVectorArray<S>::encodeBlock(const S *x, const S *y, const S *z)
+{
+ const S *lanes[3] = {x, y, z};
+ S origin[3], step[3];
+ for (int k = 0; k < 3; ++k)
+ {
+  const auto bounds = std::minmax_element(lanes[k], lanes[k] + quantizedBlockSize);
+  origin[k] = *bounds.first;
+  step[k] = quantizedStep(S(*bounds.second - *bounds.first), requestedTolerance);
+ }
+ const Block block = {{origin[0], origin[1], origin[2]}, {step[0], step[1], step[2]},
+                      (coding == QuantizedEncoding::fixed) ? words.size() : codes.size()};
+ blocks.push_back(block);
+
+ const S inverseStep[3] = {S(1.0)/step[0], S(1.0)/step[1], S(1.0)/step[2]};
+ if (coding == QuantizedEncoding::fixed)
+ {
+  // a lane of each component, so decoding is three straight SIMD passes
+  for (int k = 0; k < 3; ++k)
+  {
+   for (std::size_t i = 0; i < quantizedBlockSize; ++i) words.push_back(quantize(lanes[k][i], origin[k], inverseStep[k]));
+  }
+ }
+ else
+ {
+  std::uint16_t previous[3] = {0, 0, 0};
+  for (std::size_t i = 0; i < quantizedBlockSize; ++i)
+  {
+   for (int k = 0; k < 3; ++k)
+   {
+    const std::uint16_t q = quantize(lanes[k][i], origin[k], inverseStep[k]);
+    putDelta(codes, previous[k], q);
+    previous[k] = q;
+   }
+  }
+ }
+}
+
+template <typename S>
+void BasicQuantizedTVectorArray<S>::decodeBlockInto(std::size_t b, S *x, S *y, S *z) const
+{
+ S *lanes[3] = {x, y, z};
+ if (b == blocks.size())
+ {
+  std::copy(tail.xEast.begin(), tail.xEast.end(), x);
+  std::copy(tail.yNorth.begin(), tail.yNorth.end(), y);
+  std::copy(tail.zUp.begin(), tail.zUp.end(), z);
+  return;
+ }
+
+ const Block &block = blocks[b];
+ const S origin[3] = {block.origin.xEast, block.origin.yNorth, block.origin.zUp};
+ const S step[3] = {block.step.xEast, block.step.yNorth, block.step.zUp};
+ if (coding == QuantizedEncoding::fixed)
+ {
+  for (int k = 0; k < 3; ++k) dequantize(&words[block.offset + k*quantizedBlockSize], quantizedBlockSize, origin[k], step[k], lanes[k]);
+  return;
+ }
+
+ // undo the deltas into lanes of quantised values, then dequantise those
+ std::uint16_t q[3*quantizedBlockSize];
+ const std::uint8_t *p = &codes[block.offset];
+ std::uint16_t previous[3] = {0, 0, 0};
+ for (std::size_t i = 0; i < quantizedBlockSize; ++i)
+ {
+  for (int k = 0; k < 3; ++k) q[k*quantizedBlockSize + i] = previous[k] = takeDelta(p, previous[k]);
+ }
+ for (int k = 0; k < 3; ++k) dequantize(q + k*quantizedBlockSize, quantizedBlockSize, origin[k], step[k], lanes[k]);
+}
+
+template <typename S>
+void BasicQuantizedTVectorArray<S>::decodeBlock(std::size_t b, BasicTVectorArray<S> &out) const
+{
+ out.resize((b == blocks.size()) ? tail.size() : quantizedBlockSize);
+ decodeBlockInto(b, out.xEast.data(), out.yNorth.data(), out.zUp.data());
+}
+
+template <typename S>
+void BasicQuantizedTVectorArray<S>::decode(BasicTVectorArray<S> &out) const
+{
+ out.resize(size());
+ for (std::size_t b = 0; b < blockCount(); ++b)
+ {
+  const std::size_t i = b*quantizedBlockSize;
+  decodeBlockInto(b, &out.xEast[i], &out.yNorth[i], &out.zUp[i]);
+ }
+}
+
+template <typename S>
+BasicTVector<S> BasicQuantizedTVectorArray<S>::operator[](std::size_t i) const
+{
+ const std::size_t b = i/quantizedBlockSize, j = i%quantizedBlockSize;
+ if (b == blocks.size()) return tail[j];
+
+ const Block &block = blocks[b];
+ std::uint16_t q[3];
+ if (coding == QuantizedEncoding::fixed)
+ {
+  for (int k = 0; k < 3; ++k) q[k] = words[block.offset + k*quantizedBlockSize + j];
+ }
+ else
+ {
+  const std::uint8_t *p = &codes[block.offset];
+  std::uint16_t previous[3] = {0, 0, 0};
+  for (std::size_t n = 0; n <= j; ++n)
+  {
+   for (int k = 0; k < 3; ++k) previous[k] = takeDelta(p, previous[k]);
+  }
+  for (int k = 0; k < 3; ++k) q[k] = previous[k];
+ }
+ return {block.origin.xEast + S(q[0])*block.step.xEast,
+         block.origin.yNorth + S(q[1])*block.step.yNorth,
+         block.origin.zUp + S(q[2])*block.step.zUp};
+}
+
+template <typename S>
+S BasicQuantizedTVectorArray<S>::maximumError() const
+{
+ S largest = 0.0;
+ for (const Block &block : blocks) largest = std::max(largest, S(0.5)*std::max(block.step.xEast, std::max(block.step.yNorth, block.step.zUp)));
+ return largest;
+}
+
+template <typename S>
+std::size_t BasicQuantizedTVectorArray<S>::bytes() const
+{
+ return blocks.size()*sizeof(Block) + words.size()*sizeof(std::uint16_t) + codes.size() + tail.size()*3*sizeof(S);
+}
+
+template class BasicQuantizedTVectorArray<float>;
+template class BasicQuantizedTVectorArray<double>;
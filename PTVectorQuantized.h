@@ -0,0 +1,138 @@
+/******************************************************************************
+*
+*     PTVectorQuantized.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#ifndef PTVECTORQUANTIZED_H_INCLUDED
+#define PTVECTORQUANTIZED_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compressed storage for long histories of TVectors, such as recorded
+// positions, that can stand a known loss of precision.
+// Vectors are stored in blocks of quantizedBlockSize. Each block keeps an
+// origin (the minimum of each component over the block) and a step for each
+// component, and every vector in it as three 16 bit multiples of the step
+// from the origin. The step is twice the tolerance, unless the block spans
+// more than 65535 steps, when it grows to fit; so every component comes back
+// within max(tolerance, blockExtent/131070) of what went in, plus the
+// rounding of S, and maximumError() gives the worst of these over the store.
+//
+//  fixed   6 bytes a vector, any vector can be read directly
+//  delta   the difference from the previous vector in the block, zigzag and
+//          varint coded, so 3 bytes a vector for smooth trajectories that
+//          move less than 64 steps per sample. Reading one vector decodes
+//          the block up to it.
+//
+// The last, partly filled, block is held uncompressed until it fills.
+// Components must be finite.
+//
+// QuantizedTVectorArray history(0.001f, QuantizedEncoding::delta);   // to the millimetre
+// history.append(positions);
+// history.decodeBlock(b, block);       // one block, SIMD decoded
+static const std::size_t quantizedBlockSize = 1024;
+
+enum class QuantizedEncoding
+{
+ fixed,
+ delta
+};
+
+template <typename S>
+class BasicQuantizedTVectorArray
+{
+public:
+ typedef S Scalar;
+
+ explicit BasicQuantizedTVectorArray(S tolerance, QuantizedEncoding encoding = QuantizedEncoding::fixed);
+
+ std::size_t size() const
+ {
+  return blocks.size()*quantizedBlockSize + tail.size();
+ }
+
+ // the number of blocks, counting the last partly filled one
+ std::size_t blockCount() const
+ {
+  return (size() + quantizedBlockSize - 1)/quantizedBlockSize;
+ }
+
+ S tolerance() const
+ {
+  return requestedTolerance;
+ }
+
+ QuantizedEncoding encoding() const
+ {
+  return coding;
+ }
+
+ void push_back(const BasicTVector<S> &v);
+ void append(const BasicTVectorArray<S> &a);
+ void clear();
+
+ // the vector at i, decoded on its own
+ BasicTVector<S> operator[](std::size_t i) const;
+
+ // Decodes block b into out, resizing it to the block's length; vector i of
+ // the store is element i % quantizedBlockSize of block i/quantizedBlockSize
+ void decodeBlock(std::size_t b, BasicTVectorArray<S> &out) const;
+
+ // decodes the whole store into out
+ void decode(BasicTVectorArray<S> &out) const;
+
+ // the largest error the quantisation allows in any component so far
+ S maximumError() const;
+
+ // the memory the store uses, in bytes, the uncompressed tail included
+ std::size_t bytes() const;
+
+private:
+ struct Block
+ {
+  BasicTVector<S> origin;
+  BasicTVector<S> step;
+  std::size_t offset;      // into words for fixed, codes for delta
+ };
+
+ void encodeBlock(const S *x, const S *y, const S *z);
+ void decodeBlockInto(std::size_t b, S *x, S *y, S *z) const;
+
+ S requestedTolerance;
+ QuantizedEncoding coding;
+ std::vector<Block> blocks;
+ std::vector<std::uint16_t> words;
+ std::vector<std::uint8_t> codes;
+ BasicTVectorArray<S> tail;
+};
+
+// instantiated for float and double in PTVectorQuantized.cpp
+typedef BasicQuantizedTVectorArray<VectorPrecision> QuantizedTVectorArray;
+typedef BasicQuantizedTVectorArray<double> QuantizedTVectorArrayD;
+
+#endif // PTVECTORQUANTIZED_H_INCLUDED
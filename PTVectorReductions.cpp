@@ -0,0 +1,344 @@
+/******************************************************************************
+*
+*     PTVectorReductions.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorReductions.h"
+#include "PTVectorSIMD.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+// vectors summed in S before the partial moves to the accumulator
+static const std::size_t chunkSize = 64;
+
+// Reduces [begin, end) in runs of chunkSize, joining the runs pairwise. The
+// splits fall on chunk boundaries so they depend only on the indices.
+template <typename T, typename Partial, typename Combine>
+static T pairwiseReduce(std::size_t begin, std::size_t end, const Partial &partial, const Combine &combine)
+{
+ if (end - begin <= chunkSize) return partial(begin, end);
+ const std::size_t half = ((end - begin)/chunkSize + 1)/2*chunkSize;
+ return combine(pairwiseReduce<T>(begin, begin + half, partial, combine), pairwiseReduce<T>(begin + half, end, partial, combine));
+}
+
+// Reduces each block on the pool, then joins the block results pairwise.
+// n must be at least 1.
+template <typename T, typename Partial, typename Combine>
+static T reduceBlocks(std::size_t n, VectorThreadPool *pool, const Partial &partial, const Combine &combine)
+{
+ const std::size_t blocks = (n + reductionBlockSize - 1)/reductionBlockSize;
+ std::vector<T> results(blocks);
+ const std::function<void(std::size_t)> task = [&](std::size_t b)
+ {
+  results[b] = pairwiseReduce<T>(b*reductionBlockSize, std::min(n, (b + 1)*reductionBlockSize), partial, combine);
+ };
+
+ if (pool) pool->parallelFor(blocks, task);
+ else for (std::size_t b = 0; b < blocks; ++b) task(b);
+
+ for (std::size_t step = 1; step < blocks; step *= 2)
+  for (std::size_t i = 0; i + step < blocks; i += 2*step) results[i] = combine(results[i], results[i + step]);
+ return results[0];
+}
+
+template <typename S>
+static inline S horizontalMin(SIMDPack<S> pack)
+{
+ S lanes[SIMDPack<S>::width];
+ pack.store(lanes);
+ S min = lanes[0];
+ for (std::size_t j = 1; j < SIMDPack<S>::width; ++j) min = (lanes[j] < min) ? lanes[j] : min;
+ return min;
+}
+
+template <typename S>
+static inline S horizontalMax(SIMDPack<S> pack)
+{
+ S lanes[SIMDPack<S>::width];
+ pack.store(lanes);
+ S max = lanes[0];
+ for (std::size_t j = 1; j < SIMDPack<S>::width; ++j) max = (max < lanes[j]) ? lanes[j] : max;
+ return max;
+}
+
+template <typename A, typename S>
+static inline A horizontalSum(SIMDPack<S> pack)
+{
+ S lanes[SIMDPack<S>::width];
+ pack.store(lanes);
+ A sum = 0;
+ for (std::size_t j = 0; j < SIMDPack<S>::width; ++j) sum += A(lanes[j]);
+ return sum;
+}
+
+template <typename A, typename S>
+static BasicTVector<A> sumChunk(const BasicTVectorArray<S> &p, std::size_t begin, std::size_t end)
+{
+ typedef SIMDPack<S> Pack;
+ Pack x = Pack::broadcast(0), y = x, z = x;
+ std::size_t i = begin;
+ for (; i + Pack::width <= end; i += Pack::width)
+ {
+  x = x + Pack::load(&p.xEast[i]);
+  y = y + Pack::load(&p.yNorth[i]);
+  z = z + Pack::load(&p.zUp[i]);
+ }
+ BasicTVector<A> sum = {horizontalSum<A>(x), horizontalSum<A>(y), horizontalSum<A>(z)};
+ for (; i < end; ++i)
+ {
+  sum.xEast += A(p.xEast[i]);
+  sum.yNorth += A(p.yNorth[i]);
+  sum.zUp += A(p.zUp[i]);
+ }
+ return sum;
+}
+
+template <typename A, typename S>
+static BasicCovariance<A> covarianceChunk(const BasicTVectorArray<S> &p, const BasicTVector<S> &c, std::size_t begin, std::size_t end)
+{
+ typedef SIMDPack<S> Pack;
+ const Pack cx = Pack::broadcast(c.xEast), cy = Pack::broadcast(c.yNorth), cz = Pack::broadcast(c.zUp);
+ Pack xx = Pack::broadcast(0), xy = xx, xz = xx, yy = xx, yz = xx, zz = xx;
+ std::size_t i = begin;
+ for (; i + Pack::width <= end; i += Pack::width)
+ {
+  Pack dx = Pack::load(&p.xEast[i]) - cx, dy = Pack::load(&p.yNorth[i]) - cy, dz = Pack::load(&p.zUp[i]) - cz;
+  xx = xx + dx*dx;
+  xy = xy + dx*dy;
+  xz = xz + dx*dz;
+  yy = yy + dy*dy;
+  yz = yz + dy*dz;
+  zz = zz + dz*dz;
+ }
+ BasicCovariance<A> sum = {horizontalSum<A>(xx), horizontalSum<A>(xy), horizontalSum<A>(xz),
+                           horizontalSum<A>(yy), horizontalSum<A>(yz), horizontalSum<A>(zz)};
+ for (; i < end; ++i)
+ {
+  S dx = p.xEast[i] - c.xEast, dy = p.yNorth[i] - c.yNorth, dz = p.zUp[i] - c.zUp;
+  sum.xx += A(dx*dx);
+  sum.xy += A(dx*dy);
+  sum.xz += A(dx*dz);
+  sum.yy += A(dy*dy);
+  sum.yz += A(dy*dz);
+  sum.zz += A(dz*dz);
+ }
+ return sum;
+}
+
+template <typename S>
+struct Bounds
+{
+ BasicTVector<S> min, max;
+};
+
+template <typename S>
+static Bounds<S> boundsChunk(const BasicTVectorArray<S> &p, std::size_t begin, std::size_t end)
+{
+ typedef SIMDPack<S> Pack;
+ const S infinity = std::numeric_limits<S>::infinity();
+ Bounds<S> b = {{infinity, infinity, infinity}, {-infinity, -infinity, -infinity}};
+ std::size_t i = begin;
+ if (i + Pack::width <= end)
+ {
+  Pack minX = Pack::load(&p.xEast[i]), minY = Pack::load(&p.yNorth[i]), minZ = Pack::load(&p.zUp[i]);
+  Pack maxX = minX, maxY = minY, maxZ = minZ;
+  for (i += Pack::width; i + Pack::width <= end; i += Pack::width)
+  {
+   Pack x = Pack::load(&p.xEast[i]), y = Pack::load(&p.yNorth[i]), z = Pack::load(&p.zUp[i]);
+   minX = simdMin(minX, x);
+   minY = simdMin(minY, y);
+   minZ = simdMin(minZ, z);
+   maxX = simdMax(maxX, x);
+   maxY = simdMax(maxY, y);
+   maxZ = simdMax(maxZ, z);
+  }
+  b.min = {horizontalMin(minX), horizontalMin(minY), horizontalMin(minZ)};
+  b.max = {horizontalMax(maxX), horizontalMax(maxY), horizontalMax(maxZ)};
+ }
+ for (; i < end; ++i)
+ {
+  b.min = {std::min(b.min.xEast, p.xEast[i]), std::min(b.min.yNorth, p.yNorth[i]), std::min(b.min.zUp, p.zUp[i])};
+  b.max = {std::max(b.max.xEast, p.xEast[i]), std::max(b.max.yNorth, p.yNorth[i]), std::max(b.max.zUp, p.zUp[i])};
+ }
+ return b;
+}
+
+template <typename S>
+static S farthestChunk(const BasicTVectorArray<S> &p, const BasicTVector<S> &c, std::size_t begin, std::size_t end)
+{
+ typedef SIMDPack<S> Pack;
+ const Pack cx = Pack::broadcast(c.xEast), cy = Pack::broadcast(c.yNorth), cz = Pack::broadcast(c.zUp);
+ Pack farthest = Pack::broadcast(0);
+ std::size_t i = begin;
+ for (; i + Pack::width <= end; i += Pack::width)
+ {
+  Pack dx = Pack::load(&p.xEast[i]) - cx, dy = Pack::load(&p.yNorth[i]) - cy, dz = Pack::load(&p.zUp[i]) - cz;
+  farthest = simdMax(farthest, dx*dx + dy*dy + dz*dz);
+ }
+ S max = horizontalMax(farthest);
+ for (; i < end; ++i) max = std::max(max, lengthSquared(p[i] - c));
+ return max;
+}
+
+template <typename A, typename S>
+BasicTVector<A> reduceCentroid(const BasicTVectorArray<S> &points, VectorThreadPool *pool)
+{
+ const std::size_t n = points.size();
+ if (n == 0) return {0.0, 0.0, 0.0};
+ BasicTVector<A> sum = reduceBlocks<BasicTVector<A> >(n, pool,
+  [&points](std::size_t begin, std::size_t end) { return sumChunk<A>(points, begin, end); },
+  [](const BasicTVector<A> &a, const BasicTVector<A> &b) { return a + b; });
+ const A scale = A(1)/A(n);
+ return {sum.xEast*scale, sum.yNorth*scale, sum.zUp*scale};
+}
+
+template <typename S>
+void reduceBounds(const BasicTVectorArray<S> &points, BasicTVector<S> &min, BasicTVector<S> &max, VectorThreadPool *pool)
+{
+ const S infinity = std::numeric_limits<S>::infinity();
+ min = {infinity, infinity, infinity};
+ max = {-infinity, -infinity, -infinity};
+ if (points.size() == 0) return;
+ Bounds<S> b = reduceBlocks<Bounds<S> >(points.size(), pool,
+  [&points](std::size_t begin, std::size_t end) { return boundsChunk(points, begin, end); },
+  [](const Bounds<S> &l, const Bounds<S> &r) -> Bounds<S>
+  {
+   return {{std::min(l.min.xEast, r.min.xEast), std::min(l.min.yNorth, r.min.yNorth), std::min(l.min.zUp, r.min.zUp)},
+           {std::max(l.max.xEast, r.max.xEast), std::max(l.max.yNorth, r.max.yNorth), std::max(l.max.zUp, r.max.zUp)}};
+  });
+ min = b.min;
+ max = b.max;
+}
+
+// The squared distances are rounded in S, so the radius is grown by a few
+// ulps to keep the farthest point inside
+template <typename A, typename S>
+BasicBoundingSphere<A> reduceBoundingSphere(const BasicTVectorArray<S> &points, VectorThreadPool *pool)
+{
+ if (points.size() == 0) return {{0.0, 0.0, 0.0}, 0};
+ BasicTVector<S> min, max;
+ reduceBounds(points, min, max, pool);
+ const BasicTVector<S> centre = {min.xEast + (max.xEast - min.xEast)/2, min.yNorth + (max.yNorth - min.yNorth)/2, min.zUp + (max.zUp - min.zUp)/2};
+ const S farthest = reduceBlocks<S>(points.size(), pool,
+  [&points, &centre](std::size_t begin, std::size_t end) { return farthestChunk(points, centre, begin, end); },
+  [](S a, S b) { return std::max(a, b); });
+ const A radius = std::sqrt(A(farthest))*(1 + 4*A(std::numeric_limits<S>::epsilon()));
+ return {{A(centre.xEast), A(centre.yNorth), A(centre.zUp)}, radius};
+}
+
+template <typename A, typename S>
+BasicCovariance<A> reduceCovariance(const BasicTVectorArray<S> &points, const BasicTVector<A> &centroid, VectorThreadPool *pool)
+{
+ const std::size_t n = points.size();
+ if (n == 0) return {0, 0, 0, 0, 0, 0};
+ const BasicTVector<S> c = {S(centroid.xEast), S(centroid.yNorth), S(centroid.zUp)};
+ BasicCovariance<A> sum = reduceBlocks<BasicCovariance<A> >(n, pool,
+  [&points, &c](std::size_t begin, std::size_t end) { return covarianceChunk<A>(points, c, begin, end); },
+  [](const BasicCovariance<A> &a, const BasicCovariance<A> &b) -> BasicCovariance<A>
+  {
+   return {a.xx + b.xx, a.xy + b.xy, a.xz + b.xz, a.yy + b.yy, a.yz + b.yz, a.zz + b.zz};
+  });
+ const A scale = A(1)/A(n);
+ return {sum.xx*scale, sum.xy*scale, sum.xz*scale, sum.yy*scale, sum.yz*scale, sum.zz*scale};
+}
+
+template <typename A, typename S>
+BasicCovariance<A> reduceCovariance(const BasicTVectorArray<S> &points, VectorThreadPool *pool)
+{
+ return reduceCovariance<A>(points, reduceCentroid<A>(points, pool), pool);
+}
+
+// Cyclic Jacobi: each rotation zeroes one off-diagonal element of a, and v
+// gathers the rotations so its columns end up as the eigenvectors
+template <typename S>
+void principalAxes(const BasicCovariance<S> &covariance, BasicTVector<S> axes[3], S variances[3])
+{
+ S a[3][3] = {{covariance.xx, covariance.xy, covariance.xz},
+              {covariance.xy, covariance.yy, covariance.yz},
+              {covariance.xz, covariance.yz, covariance.zz}};
+ S v[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+ const S epsilon = std::numeric_limits<S>::epsilon();
+
+ for (int sweep = 0; sweep < 32; ++sweep)
+ {
+  const S off = a[0][1]*a[0][1] + a[0][2]*a[0][2] + a[1][2]*a[1][2];
+  const S diagonal = a[0][0]*a[0][0] + a[1][1]*a[1][1] + a[2][2]*a[2][2];
+  if (off <= epsilon*epsilon*diagonal) break;
+
+  for (int p = 0; p < 2; ++p)
+   for (int q = p + 1; q < 3; ++q)
+   {
+    if (a[p][q] == 0) continue;
+    const S theta = (a[q][q] - a[p][p])/(2*a[p][q]);
+    const S t = ((theta < 0) ? -1 : 1)/(std::abs(theta) + std::sqrt(theta*theta + 1));
+    const S c = 1/std::sqrt(t*t + 1), s = t*c;
+    for (int k = 0; k < 3; ++k)
+    {
+     const S kp = a[k][p], kq = a[k][q];
+     a[k][p] = c*kp - s*kq;
+     a[k][q] = s*kp + c*kq;
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+     const S pk = a[p][k], qk = a[q][k];
+     a[p][k] = c*pk - s*qk;
+     a[q][k] = s*pk + c*qk;
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+     const S kp = v[k][p], kq = v[k][q];
+     v[k][p] = c*kp - s*kq;
+     v[k][q] = s*kp + c*kq;
+    }
+   }
+ }
+
+ int order[3] = {0, 1, 2};
+ std::sort(order, order + 3, [&a](int l, int r) { return a[l][l] > a[r][r]; });
+ for (int i = 0; i < 3; ++i)
+ {
+  variances[i] = a[order[i]][order[i]];
+  axes[i] = {v[0][order[i]], v[1][order[i]], v[2][order[i]]};
+ }
+ axes[2] = axes[0] / axes[1];
+}
+
+#define PTVECTORREDUCTIONS_INSTANTIATE(A, S) \
+ template BasicTVector<A> reduceCentroid<A, S>(const BasicTVectorArray<S>&, VectorThreadPool*); \
+ template BasicBoundingSphere<A> reduceBoundingSphere<A, S>(const BasicTVectorArray<S>&, VectorThreadPool*); \
+ template BasicCovariance<A> reduceCovariance<A, S>(const BasicTVectorArray<S>&, VectorThreadPool*); \
+ template BasicCovariance<A> reduceCovariance<A, S>(const BasicTVectorArray<S>&, const BasicTVector<A>&, VectorThreadPool*);
+
+PTVECTORREDUCTIONS_INSTANTIATE(float, float)
+PTVECTORREDUCTIONS_INSTANTIATE(double, float)
+PTVECTORREDUCTIONS_INSTANTIATE(float, double)
+PTVECTORREDUCTIONS_INSTANTIATE(double, double)
+
+template void reduceBounds(const BasicTVectorArray<float>&, BasicTVector<float>&, BasicTVector<float>&, VectorThreadPool*);
+template void reduceBounds(const BasicTVectorArray<double>&, BasicTVector<double>&, BasicTVector<double>&, VectorThreadPool*);
+template void principalAxes(const BasicCovariance<float>&, BasicTVector<float>[3], float[3]);
+template void principalAxes(const BasicCovariance<double>&, BasicTVector<double>[3], double[3]);
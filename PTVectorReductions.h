@@ -0,0 +1,104 @@
+/******************************************************************************
+*
+*     PTVectorReductions.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTORREDUCTIONS_H_INCLUDED
+#define PTVECTORREDUCTIONS_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTVectorThreadPool.h"
+#include <cstddef>
+
+// Whole-array statistics over large TVectorArrays, split across a
+// VectorThreadPool.
+// The array is cut into blocks of reductionBlockSize vectors whatever the
+// number of threads, each block is reduced with the SIMD kernels, and the
+// block results are combined pairwise in a fixed order, so the result is
+// bit-identical for any pool size, or none. Sums are pairwise throughout:
+// runs of 64 vectors are summed in S, everything above that in the
+// accumulator type A, which is given first and may be float or double.
+//
+// VectorThreadPool pool;
+// TVectorD centre = reduceCentroid<double>(points, &pool);
+// CovarianceD c = reduceCovariance<double>(points, &pool);
+// principalAxes(c, axes, variances);              // PCA orientation
+
+static const std::size_t reductionBlockSize = 4096;
+
+template <typename S>
+struct BasicBoundingSphere
+{
+ BasicTVector<S> centre;
+ S radius;
+};
+
+typedef BasicBoundingSphere<VectorPrecision> BoundingSphere;
+typedef BasicBoundingSphere<double> BoundingSphereD;
+
+// The upper triangle of a symmetric 3x3 covariance matrix
+template <typename S>
+struct BasicCovariance
+{
+ S xx, xy, xz;
+ S yy, yz;
+ S zz;
+};
+
+typedef BasicCovariance<VectorPrecision> Covariance;
+typedef BasicCovariance<double> CovarianceD;
+
+// Reductions are instantiated for float and double data with float and double
+// accumulators in PTVectorReductions.cpp
+
+// The mean of the points, zero if there are none
+template <typename A, typename S>
+BasicTVector<A> reduceCentroid(const BasicTVectorArray<S> &points, VectorThreadPool *pool = nullptr);
+
+// The component-wise minimum and maximum, as boundsVectorArray()
+template <typename S>
+void reduceBounds(const BasicTVectorArray<S> &points, BasicTVector<S> &min, BasicTVector<S> &max, VectorThreadPool *pool = nullptr);
+
+// A sphere about the centre of the bounds that contains every point. It is
+// not the minimal sphere but is never more than sqrt(3) times its radius.
+// An empty array gives a zero sphere at the origin.
+template <typename A, typename S>
+BasicBoundingSphere<A> reduceBoundingSphere(const BasicTVectorArray<S> &points, VectorThreadPool *pool = nullptr);
+
+// The population covariance of the points about their centroid, zero if
+// there are none. The centroid is found first unless it is passed in, then
+// the products are taken about it, which keeps the result accurate for
+// points far from the origin.
+template <typename A, typename S>
+BasicCovariance<A> reduceCovariance(const BasicTVectorArray<S> &points, VectorThreadPool *pool = nullptr);
+template <typename A, typename S>
+BasicCovariance<A> reduceCovariance(const BasicTVectorArray<S> &points, const BasicTVector<A> &centroid, VectorThreadPool *pool = nullptr);
+
+// The eigenvectors of a covariance matrix by Jacobi rotation, largest variance
+// first. The axes are unit length and form a right handed frame, axes[2] being
+// axes[0] / axes[1].
+template <typename S>
+void principalAxes(const BasicCovariance<S> &covariance, BasicTVector<S> axes[3], S variances[3]);
+
+#endif // PTVECTORREDUCTIONS_H_INCLUDED
@@ -0,0 +1,83 @@
+/******************************************************************************
+*
+*     PTVectorRotation.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorRotation.h"
+
+// R = cI + s[axis]x + (1 - c)(axis axis^T), where [axis]x v == axis/v
+template <typename S>
+BasicTVectorRotation<S>::BasicTVectorRotation(const BasicTVector<S> &axis, S angleRadians)
+{
+ const S c = cos(angleRadians);
+ const S s = sin(angleRadians);
+ const S t = 1.0 - c;
+ const S x = axis.xEast, y = axis.yNorth, z = axis.zUp;
+
+ xRow = {c + t*x*x,   t*x*y - s*z, t*x*z + s*y};
+ yRow = {t*x*y + s*z, c + t*y*y,   t*y*z - s*x};
+ zRow = {t*x*z - s*y, t*y*z + s*x, c + t*z*z};
+ translation = {0.0, 0.0, 0.0};
+}
+
+template <typename S>
+BasicTVectorRotation<S>::BasicTVectorRotation(const BasicTVector<S> &origin, const BasicTVector<S> &axis, S angleRadians)
+ : BasicTVectorRotation(axis, angleRadians)
+{
+ translation = origin - apply(origin);
+}
+
+template <typename S>
+void BasicTVectorRotation<S>::apply(const BasicTVectorArray<S> &in, BasicTVectorArray<S> &out) const
+{
+ typedef SIMDPack<S> Pack;
+ const std::size_t n = in.size();
+ out.resize(n);
+
+ const Pack m00 = Pack::broadcast(xRow.xEast), m01 = Pack::broadcast(xRow.yNorth), m02 = Pack::broadcast(xRow.zUp);
+ const Pack m10 = Pack::broadcast(yRow.xEast), m11 = Pack::broadcast(yRow.yNorth), m12 = Pack::broadcast(yRow.zUp);
+ const Pack m20 = Pack::broadcast(zRow.xEast), m21 = Pack::broadcast(zRow.yNorth), m22 = Pack::broadcast(zRow.zUp);
+ const Pack tx = Pack::broadcast(translation.xEast);
+ const Pack ty = Pack::broadcast(translation.yNorth);
+ const Pack tz = Pack::broadcast(translation.zUp);
+
+ std::size_t i = 0;
+ for (; i + Pack::width <= n; i += Pack::width)
+ {
+  Pack x = Pack::load(&in.xEast[i]), y = Pack::load(&in.yNorth[i]), z = Pack::load(&in.zUp[i]);
+  (m00*x + m01*y + m02*z + tx).store(&out.xEast[i]);
+  (m10*x + m11*y + m12*z + ty).store(&out.yNorth[i]);
+  (m20*x + m21*y + m22*z + tz).store(&out.zUp[i]);
+ }
+ for (; i < n; ++i) out.set(i, apply(in[i]));
+}
+
+template <typename S>
+void BasicTVectorRotation<S>::apply(const BasicTVector<S> *in, BasicTVector<S> *out, std::size_t n) const
+{
+ for (std::size_t i = 0; i < n; ++i) out[i] = apply(in[i]);
+}
+
+template struct BasicTVectorRotation<float>;
+template struct BasicTVectorRotation<double>;
@@ -0,0 +1,74 @@
+/******************************************************************************
+*
+*     PTVectorRotation.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTORROTATION_H_INCLUDED
+#define PTVECTORROTATION_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include <cstddef>
+
+// A fixed rotation about an axis, built once and applied to as many vectors as needed.
+// Holds the Rodrigues matrix for rotateTVectorAboutAxis, so applying it costs
+// nine multiplies and no trig. Like rotateTVectorAboutAxis, the axis is
+// expected to be a UNIT VECTOR and the rotation follows the right hand rule.
+//
+// TVectorRotation r(1_z, degreesToRadians(90));
+// TVector v = r.apply(1_x);                        // same as rotateTVectorAboutAxis(1_x, 1_z, ...)
+// TVectorRotation p(origin, axis, angleRadians);   // same as rotateTVectorAboutPointAxis
+template <typename S>
+struct BasicTVectorRotation
+{
+ // rows of the rotation matrix
+ BasicTVector<S> xRow;
+ BasicTVector<S> yRow;
+ BasicTVector<S> zRow;
+ // origin - R*origin, zero for rotations about an axis through the origin
+ BasicTVector<S> translation;
+
+ BasicTVectorRotation(const BasicTVector<S> &axis, S angleRadians);
+ BasicTVectorRotation(const BasicTVector<S> &origin, const BasicTVector<S> &axis, S angleRadians);
+
+ // from the rows of a rotation matrix that has already been worked out
+ constexpr BasicTVectorRotation(const BasicTVector<S> &x, const BasicTVector<S> &y, const BasicTVector<S> &z)
+  : xRow(x), yRow(y), zRow(z), translation{0.0, 0.0, 0.0}
+ {
+ }
+
+ constexpr BasicTVector<S> apply(const BasicTVector<S> &v) const
+ {
+  return BasicTVector<S>{xRow*v, yRow*v, zRow*v} + translation;
+ }
+
+ // batch versions, out may alias in
+ void apply(const BasicTVectorArray<S> &in, BasicTVectorArray<S> &out) const;
+ void apply(const BasicTVector<S> *in, BasicTVector<S> *out, std::size_t n) const;
+};
+
+// instantiated for float and double in PTVectorRotation.cpp
+typedef BasicTVectorRotation<VectorPrecision> TVectorRotation;
+typedef BasicTVectorRotation<double> TVectorRotationD;
+
+#endif // PTVECTORROTATION_H_INCLUDED
@@ -0,0 +1,364 @@
+/******************************************************************************
+*
+*     PTVectorSIMD.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTORSIMD_H_INCLUDED
+#define PTVECTORSIMD_H_INCLUDED
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PTVECTORS_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PTVECTORS_SSE2 1
+#endif
+
+// Allocator that hands out memory aligned for the widest SIMD register we use.
+// Used by the batch containers so that every lane starts on a register boundary.
+template <typename T, std::size_t Alignment = 32>
+struct AlignedAllocator
+{
+ typedef T value_type;
+
+ template <typename U>
+ struct rebind
+ {
+  typedef AlignedAllocator<U, Alignment> other;
+ };
+
+ AlignedAllocator() = default;
+
+ template <typename U>
+ AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+ T* allocate(std::size_t n)
+ {
+  // over-allocate, align, and stash the original pointer just before the block
+  void *raw = std::malloc(n*sizeof(T) + Alignment + sizeof(void*));
+  if (raw == nullptr) throw std::bad_alloc();
+  std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+  std::uintptr_t aligned = (start + Alignment - 1) & ~static_cast<std::uintptr_t>(Alignment - 1);
+  reinterpret_cast<void**>(aligned)[-1] = raw;
+  return reinterpret_cast<T*>(aligned);
+ }
+
+ void deallocate(T *p, std::size_t)
+ {
+  if (p != nullptr) std::free(reinterpret_cast<void**>(p)[-1]);
+ }
+};
+
+template <typename T, typename U, std::size_t A>
+bool operator==(const AlignedAllocator<T, A>&, const AlignedAllocator<U, A>&)
+{
+ return true;
+}
+
+template <typename T, typename U, std::size_t A>
+bool operator!=(const AlignedAllocator<T, A>&, const AlignedAllocator<U, A>&)
+{
+ return false;
+}
+
+// SIMDPack<T> holds one register's worth of lanes of T.
+// The generic version is a single scalar lane, so every kernel written against
+// SIMDPack still compiles (and stays correct) on targets without SSE/AVX.
+// Loads and stores are unaligned so kernels may run on any buffer.
+// loadUInt16 widens width unsigned 16 bit integers into the lanes.
+template <typename T>
+struct SIMDPack
+{
+ static constexpr std::size_t width = 1;
+ typedef bool Mask;
+
+ T value;
+
+ static SIMDPack load(const T *p) { return {*p}; }
+ static SIMDPack loadUInt16(const std::uint16_t *p) { return {T(*p)}; }
+ static SIMDPack broadcast(T x) { return {x}; }
+ void store(T *p) const { *p = value; }
+};
+
+template <typename T>
+inline SIMDPack<T> operator+(SIMDPack<T> a, SIMDPack<T> b) { return {a.value + b.value}; }
+template <typename T>
+inline SIMDPack<T> operator-(SIMDPack<T> a, SIMDPack<T> b) { return {a.value - b.value}; }
+template <typename T>
+inline SIMDPack<T> operator*(SIMDPack<T> a, SIMDPack<T> b) { return {a.value * b.value}; }
+template <typename T>
+inline SIMDPack<T> operator/(SIMDPack<T> a, SIMDPack<T> b) { return {a.value / b.value}; }
+template <typename T>
+inline SIMDPack<T> simdSqrt(SIMDPack<T> a) { return {T(sqrt(a.value))}; }
+template <typename T>
+inline SIMDPack<T> simdRecipSqrt(SIMDPack<T> a) { return {T(1.0 / sqrt(a.value))}; }
+// like the SSE and AVX instructions, simdMin and simdMax give b if either is NaN
+template <typename T>
+inline SIMDPack<T> simdMin(SIMDPack<T> a, SIMDPack<T> b) { return {(a.value < b.value) ? a.value : b.value}; }
+template <typename T>
+inline SIMDPack<T> simdMax(SIMDPack<T> a, SIMDPack<T> b) { return {(a.value > b.value) ? a.value : b.value}; }
+template <typename T>
+inline bool simdIsZero(SIMDPack<T> a) { return a.value == T(0); }
+template <typename T>
+inline bool simdLessThan(SIMDPack<T> a, SIMDPack<T> b) { return a.value < b.value; }
+template <typename T>
+inline SIMDPack<T> simdSelect(bool mask, SIMDPack<T> ifTrue, SIMDPack<T> ifFalse) { return mask ? ifTrue : ifFalse; }
+inline bool simdOr(bool a, bool b) { return a || b; }
+// true if any lane of the mask is set
+inline bool simdAny(bool mask) { return mask; }
+
+#if defined(PTVECTORS_AVX)
+
+template <>
+struct SIMDPack<float>
+{
+ static constexpr std::size_t width = 8;
+ typedef __m256 Mask;
+
+ __m256 value;
+
+ static SIMDPack load(const float *p) { return {_mm256_loadu_ps(p)}; }
+ static SIMDPack loadUInt16(const std::uint16_t *p)
+ {
+  // AVX has no 256 bit integer unpack, so widen each half with SSE2
+  __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  __m128i low = _mm_unpacklo_epi16(w, _mm_setzero_si128());
+  __m128i high = _mm_unpackhi_epi16(w, _mm_setzero_si128());
+  return {_mm256_cvtepi32_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(low), high, 1))};
+ }
+ static SIMDPack broadcast(float x) { return {_mm256_set1_ps(x)}; }
+ void store(float *p) const { _mm256_storeu_ps(p, value); }
+};
+
+inline SIMDPack<float> operator+(SIMDPack<float> a, SIMDPack<float> b) { return {_mm256_add_ps(a.value, b.value)}; }
+inline SIMDPack<float> operator-(SIMDPack<float> a, SIMDPack<float> b) { return {_mm256_sub_ps(a.value, b.value)}; }
+inline SIMDPack<float> operator*(SIMDPack<float> a, SIMDPack<float> b) { return {_mm256_mul_ps(a.value, b.value)}; }
+inline SIMDPack<float> operator/(SIMDPack<float> a, SIMDPack<float> b) { return {_mm256_div_ps(a.value, b.value)}; }
+inline SIMDPack<float> simdSqrt(SIMDPack<float> a) { return {_mm256_sqrt_ps(a.value)}; }
+inline SIMDPack<float> simdMin(SIMDPack<float> a, SIMDPack<float> b) { return {_mm256_min_ps(a.value, b.value)}; }
+inline SIMDPack<float> simdMax(SIMDPack<float> a, SIMDPack<float> b) { return {_mm256_max_ps(a.value, b.value)}; }
+inline __m256 simdIsZero(SIMDPack<float> a) { return _mm256_cmp_ps(a.value, _mm256_setzero_ps(), _CMP_EQ_OQ); }
+inline __m256 simdLessThan(SIMDPack<float> a, SIMDPack<float> b) { return _mm256_cmp_ps(a.value, b.value, _CMP_LT_OQ); }
+inline SIMDPack<float> simdSelect(__m256 mask, SIMDPack<float> ifTrue, SIMDPack<float> ifFalse)
+{
+ return {_mm256_or_ps(_mm256_and_ps(mask, ifTrue.value), _mm256_andnot_ps(mask, ifFalse.value))};
+}
+inline __m256 simdOr(__m256 a, __m256 b) { return _mm256_or_ps(a, b); }
+inline bool simdAny(__m256 mask) { return _mm256_movemask_ps(mask) != 0; }
+
+// rsqrt estimate refined with one Newton-Raphson step (~22 bits)
+inline SIMDPack<float> simdRecipSqrt(SIMDPack<float> a)
+{
+ __m256 y = _mm256_rsqrt_ps(a.value);
+ __m256 halfA = _mm256_mul_ps(a.value, _mm256_set1_ps(0.5f));
+ __m256 t = _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(halfA, _mm256_mul_ps(y, y)));
+ return {_mm256_mul_ps(y, t)};
+}
+
+template <>
+struct SIMDPack<double>
+{
+ static constexpr std::size_t width = 4;
+ typedef __m256d Mask;
+
+ __m256d value;
+
+ static SIMDPack load(const double *p) { return {_mm256_loadu_pd(p)}; }
+ static SIMDPack loadUInt16(const std::uint16_t *p)
+ {
+  __m128i w = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  return {_mm256_cvtepi32_pd(_mm_unpacklo_epi16(w, _mm_setzero_si128()))};
+ }
+ static SIMDPack broadcast(double x) { return {_mm256_set1_pd(x)}; }
+ void store(double *p) const { _mm256_storeu_pd(p, value); }
+};
+
+inline SIMDPack<double> operator+(SIMDPack<double> a, SIMDPack<double> b) { return {_mm256_add_pd(a.value, b.value)}; }
+inline SIMDPack<double> operator-(SIMDPack<double> a, SIMDPack<double> b) { return {_mm256_sub_pd(a.value, b.value)}; }
+inline SIMDPack<double> operator*(SIMDPack<double> a, SIMDPack<double> b) { return {_mm256_mul_pd(a.value, b.value)}; }
+inline SIMDPack<double> operator/(SIMDPack<double> a, SIMDPack<double> b) { return {_mm256_div_pd(a.value, b.value)}; }
+inline SIMDPack<double> simdSqrt(SIMDPack<double> a) { return {_mm256_sqrt_pd(a.value)}; }
+inline SIMDPack<double> simdRecipSqrt(SIMDPack<double> a)
+{
+ return {_mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(a.value))};
+}
+inline SIMDPack<double> simdMin(SIMDPack<double> a, SIMDPack<double> b) { return {_mm256_min_pd(a.value, b.value)}; }
+inline SIMDPack<double> simdMax(SIMDPack<double> a, SIMDPack<double> b) { return {_mm256_max_pd(a.value, b.value)}; }
+inline __m256d simdIsZero(SIMDPack<double> a) { return _mm256_cmp_pd(a.value, _mm256_setzero_pd(), _CMP_EQ_OQ); }
+inline __m256d simdLessThan(SIMDPack<double> a, SIMDPack<double> b) { return _mm256_cmp_pd(a.value, b.value, _CMP_LT_OQ); }
+inline SIMDPack<double> simdSelect(__m256d mask, SIMDPack<double> ifTrue, SIMDPack<double> ifFalse)
+{
+ return {_mm256_or_pd(_mm256_and_pd(mask, ifTrue.value), _mm256_andnot_pd(mask, ifFalse.value))};
+}
+inline __m256d simdOr(__m256d a, __m256d b) { return _mm256_or_pd(a, b); }
+inline bool simdAny(__m256d mask) { return _mm256_movemask_pd(mask) != 0; }
+
+#elif defined(PTVECTORS_SSE2)
+
+template <>
+struct SIMDPack<float>
+{
+ static constexpr std::size_t width = 4;
+ typedef __m128 Mask;
+
+ __m128 value;
+
+ static SIMDPack load(const float *p) { return {_mm_loadu_ps(p)}; }
+ static SIMDPack loadUInt16(const std::uint16_t *p)
+ {
+  __m128i w = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  return {_mm_cvtepi32_ps(_mm_unpacklo_epi16(w, _mm_setzero_si128()))};
+ }
+ static SIMDPack broadcast(float x) { return {_mm_set1_ps(x)}; }
+ void store(float *p) const { _mm_storeu_ps(p, value); }
+};
+
+inline SIMDPack<float> operator+(SIMDPack<float> a, SIMDPack<float> b) { return {_mm_add_ps(a.value, b.value)}; }
+inline SIMDPack<float> operator-(SIMDPack<float> a, SIMDPack<float> b) { return {_mm_sub_ps(a.value, b.value)}; }
+inline SIMDPack<float> operator*(SIMDPack<float> a, SIMDPack<float> b) { return {_mm_mul_ps(a.value, b.value)}; }
+inline SIMDPack<float> operator/(SIMDPack<float> a, SIMDPack<float> b) { return {_mm_div_ps(a.value, b.value)}; }
+inline SIMDPack<float> simdSqrt(SIMDPack<float> a) { return {_mm_sqrt_ps(a.value)}; }
+inline SIMDPack<float> simdMin(SIMDPack<float> a, SIMDPack<float> b) { return {_mm_min_ps(a.value, b.value)}; }
+inline SIMDPack<float> simdMax(SIMDPack<float> a, SIMDPack<float> b) { return {_mm_max_ps(a.value, b.value)}; }
+inline __m128 simdIsZero(SIMDPack<float> a) { return _mm_cmpeq_ps(a.value, _mm_setzero_ps()); }
+inline __m128 simdLessThan(SIMDPack<float> a, SIMDPack<float> b) { return _mm_cmplt_ps(a.value, b.value); }
+inline SIMDPack<float> simdSelect(__m128 mask, SIMDPack<float> ifTrue, SIMDPack<float> ifFalse)
+{
+ return {_mm_or_ps(_mm_and_ps(mask, ifTrue.value), _mm_andnot_ps(mask, ifFalse.value))};
+}
+inline __m128 simdOr(__m128 a, __m128 b) { return _mm_or_ps(a, b); }
+inline bool simdAny(__m128 mask) { return _mm_movemask_ps(mask) != 0; }
+
+// rsqrt estimate refined with one Newton-Raphson step (~22 bits)
+inline SIMDPack<float> simdRecipSqrt(SIMDPack<float> a)
+{
+ __m128 y = _mm_rsqrt_ps(a.value);
+ __m128 halfA = _mm_mul_ps(a.value, _mm_set1_ps(0.5f));
+ __m128 t = _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfA, _mm_mul_ps(y, y)));
+ return {_mm_mul_ps(y, t)};
+}
+
+template <>
+struct SIMDPack<double>
+{
+ static constexpr std::size_t width = 2;
+ typedef __m128d Mask;
+
+ __m128d value;
+
+ static SIMDPack load(const double *p) { return {_mm_loadu_pd(p)}; }
+ static SIMDPack loadUInt16(const std::uint16_t *p)
+ {
+  __m128i w = _mm_cvtsi32_si128(int(p[0] | (std::uint32_t(p[1]) << 16)));
+  return {_mm_cvtepi32_pd(_mm_unpacklo_epi16(w, _mm_setzero_si128()))};
+ }
+ static SIMDPack broadcast(double x) { return {_mm_set1_pd(x)}; }
+ void store(double *p) const { _mm_storeu_pd(p, value); }
+};
+
+inline SIMDPack<double> operator+(SIMDPack<double> a, SIMDPack<double> b) { return {_mm_add_pd(a.value, b.value)}; }
+inline SIMDPack<double> operator-(SIMDPack<double> a, SIMDPack<double> b) { return {_mm_sub_pd(a.value, b.value)}; }
+inline SIMDPack<double> operator*(SIMDPack<double> a, SIMDPack<double> b) { return {_mm_mul_pd(a.value, b.value)}; }
+inline SIMDPack<double> operator/(SIMDPack<double> a, SIMDPack<double> b) { return {_mm_div_pd(a.value, b.value)}; }
+inline SIMDPack<double> simdSqrt(SIMDPack<double> a) { return {_mm_sqrt_pd(a.value)}; }
+inline SIMDPack<double> simdRecipSqrt(SIMDPack<double> a)
+{
+ return {_mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(a.value))};
+}
+inline SIMDPack<double> simdMin(SIMDPack<double> a, SIMDPack<double> b) { return {_mm_min_pd(a.value, b.value)}; }
+inline SIMDPack<double> simdMax(SIMDPack<double> a, SIMDPack<double> b) { return {_mm_max_pd(a.value, b.value)}; }
+inline __m128d simdIsZero(SIMDPack<double> a) { return _mm_cmpeq_pd(a.value, _mm_setzero_pd()); }
+inline __m128d simdLessThan(SIMDPack<double> a, SIMDPack<double> b) { return _mm_cmplt_pd(a.value, b.value); }
+inline SIMDPack<double> simdSelect(__m128d mask, SIMDPack<double> ifTrue, SIMDPack<double> ifFalse)
+{
+ return {_mm_or_pd(_mm_and_pd(mask, ifTrue.value), _mm_andnot_pd(mask, ifFalse.value))};
+}
+inline __m128d simdOr(__m128d a, __m128d b) { return _mm_or_pd(a, b); }
+inline bool simdAny(__m128d mask) { return _mm_movemask_pd(mask) != 0; }
+
+#endif
+
+// Vectorised sin and cos built only on the pack arithmetic above, so they
+// work for every SIMDPack. The argument is reduced to [-pi/2, pi/2] by
+// multiples of pi, then a Taylor polynomial is used (through r^11 for float,
+// r^21 for double). Absolute error is within a few ULP of the libm functions
+// for |x| < 1e4; the reduction breaks down past |x| ~ 1e6 for float.
+
+// sin(x + halfTurns*pi), halfTurns being 0 for sin or 0.5 for cos
+template <typename T>
+inline SIMDPack<T> simdSinOffset(SIMDPack<T> x, T halfTurns)
+{
+ typedef SIMDPack<T> P;
+ const bool isDouble = sizeof(T) > sizeof(float);
+ // adding and subtracting 1.5*2^mantissa rounds to the nearest integer
+ const P roundMagic = P::broadcast(isDouble ? T(6755399441055744.0) : T(12582912.0));
+
+ // k = round(x/pi + halfTurns), r = x - k*pi + halfTurns*pi
+ // pi is split in two (Cody-Waite) so that x - k*pi stays exact
+ P k = (x*P::broadcast(T(0.31830988618379067)) + P::broadcast(halfTurns) + roundMagic) - roundMagic;
+ P r = (x - k*P::broadcast(T(3.140625))) - k*P::broadcast(T(9.676535897932384626e-4));
+ r = r + P::broadcast(T(halfTurns*3.14159265358979323846));
+
+ // sin(x) = (-1)^k sin(r)
+ P halfK = (k*P::broadcast(T(0.5)) + roundMagic) - roundMagic;
+ P parity = k - halfK - halfK;
+ P sign = P::broadcast(T(1)) - P::broadcast(T(2))*parity*parity;
+
+ P r2 = r*r;
+ P poly = P::broadcast(T(-2.5052108385441720e-08));
+ if (isDouble)
+ {
+  poly = P::broadcast(T(1.9572941063391263e-20));
+  poly = poly*r2 - P::broadcast(T(8.2206352466243297e-18));
+  poly = poly*r2 + P::broadcast(T(2.8114572543455206e-15));
+  poly = poly*r2 - P::broadcast(T(7.6471637318198165e-13));
+  poly = poly*r2 + P::broadcast(T(1.6059043836821613e-10));
+  poly = poly*r2 - P::broadcast(T(2.5052108385441720e-08));
+ }
+ poly = poly*r2 + P::broadcast(T(2.7557319223985888e-06));
+ poly = poly*r2 - P::broadcast(T(1.9841269841269841e-04));
+ poly = poly*r2 + P::broadcast(T(8.3333333333333333e-03));
+ poly = poly*r2 - P::broadcast(T(1.6666666666666667e-01));
+ poly = poly*r2 + P::broadcast(T(1));
+ return sign*(r*poly);
+}
+
+template <typename T>
+inline SIMDPack<T> simdSin(SIMDPack<T> x)
+{
+ return simdSinOffset(x, T(0));
+}
+
+template <typename T>
+inline SIMDPack<T> simdCos(SIMDPack<T> x)
+{
+ return simdSinOffset(x, T(0.5));
+}
+
+#endif // PTVECTORSIMD_H_INCLUDED
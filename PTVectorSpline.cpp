@@ -0,0 +1,310 @@
+/******************************************************************************
+*
+*     PTVectorSpline.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorSpline.h"
+#include <algorithm>
+
+// samples are evaluated this many at a time, grouped into runs on the same segment
+static const std::size_t splineChunkSize = 256;
+
+// three and five point Gauss-Legendre nodes and weights on [-1, 1]
+static const double gaussNodes[3][5] = {{0.0, -0.7745966692414834, 0.7745966692414834},
+                                        {},
+                                        {0.0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640}};
+static const double gaussWeights[3][5] = {{0.8888888888888889, 0.5555555555555556, 0.5555555555555556},
+                                          {},
+                                          {0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891}};
+
+template <typename A>
+BasicSpline<A>::BasicSpline(const A &controlPoints, SplineType type) : splineType(type), segmentCount(0)
+{
+ typedef typename A::Vector V;
+ const std::size_t n = controlPoints.size();
+ std::vector<V> c[4];
+
+ if (type == SplineType::bezier)
+ {
+  segmentCount = (n >= 4) ? (n - 1)/3 : 0;
+  for (std::size_t i = 0; i < segmentCount; ++i)
+  {
+   const V b0 = controlPoints[3*i], b1 = controlPoints[3*i + 1], b2 = controlPoints[3*i + 2], b3 = controlPoints[3*i + 3];
+   c[0].push_back(b0);
+   c[1].push_back(Scalar(3.0)*(b1 - b0));
+   c[2].push_back(Scalar(3.0)*(b0 - Scalar(2.0)*b1 + b2));
+   c[3].push_back(b3 - b0 + Scalar(3.0)*(b1 - b2));
+  }
+ }
+ else if (n >= 2)
+ {
+  // reflect the end points so the first and last segments have neighbours
+  std::vector<V> p(n + 2);
+  for (std::size_t i = 0; i < n; ++i) p[i + 1] = controlPoints[i];
+  p[0] = Scalar(2.0)*p[1] - p[2];
+  p[n + 1] = Scalar(2.0)*p[n] - p[n - 1];
+
+  // knot spacing, 1 for uniform and the root of the chord for centripetal
+  std::vector<Scalar> spacing(n + 1, Scalar(1.0));
+  if (type == SplineType::centripetalCatmullRom)
+  {
+   for (std::size_t i = 0; i <= n; ++i) spacing[i] = std::sqrt(::length(p[i + 1] - p[i]));
+  }
+
+  // Repeated points give a zero spacing. The chord it divides is zero too and
+  // shrinks faster than its root, so those terms drop out of the tangents
+  // rather than being divided by zero
+  const auto inverse = [](Scalar d) { return (d > Scalar(0.0)) ? Scalar(1.0)/d : Scalar(0.0); };
+
+  segmentCount = n - 1;
+  for (std::size_t i = 0; i < segmentCount; ++i)
+  {
+   const V &p0 = p[i], &p1 = p[i + 1], &p2 = p[i + 2], &p3 = p[i + 3];
+   const Scalar d0 = spacing[i], d1 = spacing[i + 1], d2 = spacing[i + 2];
+   // the Catmull-Rom tangents for these knots, scaled to the segment, which
+   // leaves a segment between repeated points constant
+   const V m1 = d1*(inverse(d0)*(p1 - p0) - inverse(d0 + d1)*(p2 - p0) + inverse(d1)*(p2 - p1));
+   const V m2 = d1*(inverse(d1)*(p2 - p1) - inverse(d1 + d2)*(p3 - p1) + inverse(d2)*(p3 - p2));
+   c[0].push_back(p1);
+   c[1].push_back(m1);
+   c[2].push_back(Scalar(3.0)*(p2 - p1) - Scalar(2.0)*m1 - m2);
+   c[3].push_back(Scalar(2.0)*(p1 - p2) + m1 + m2);
+  }
+ }
+
+ // a single constant segment stands in when there are too few points
+ if (segmentCount == 0)
+ {
+  const V zero = V();
+  c[0].assign(1, (n > 0) ? controlPoints[0] : zero);
+  for (int k = 1; k < 4; ++k) c[k].assign(1, zero);
+ }
+ for (int k = 0; k < 4; ++k) coefficients[k] = A(c[k]);
+
+ const std::size_t pieces = c[0].size();
+ arcLengths.assign(1, Scalar(0.0));
+ for (std::size_t i = 0; i < pieces; ++i)
+ {
+  for (std::size_t j = 0; j < arcTableResolution; ++j)
+  {
+   const Scalar from = Scalar(j)/arcTableResolution, to = Scalar(j + 1)/arcTableResolution;
+   arcLengths.push_back(arcLengths.back() + segmentArcLength(i, from, to, 5));
+  }
+ }
+}
+
+template <typename A>
+void BasicSpline<A>::segmentAt(Scalar t, std::size_t &segment, Scalar &local) const
+{
+ const std::size_t pieces = coefficients[0].size();
+ const Scalar x = std::min(std::max(t, Scalar(0.0)), Scalar(1.0))*Scalar(pieces);
+ segment = std::min(std::size_t(x), pieces - 1);
+ local = x - Scalar(segment);
+}
+
+template <typename A>
+typename BasicSpline<A>::Vector BasicSpline<A>::evaluate(std::size_t segment, Scalar local) const
+{
+ return ((coefficients[3][segment]*local + coefficients[2][segment])*local + coefficients[1][segment])*local + coefficients[0][segment];
+}
+
+// the derivative with respect to the segment's local parameter
+template <typename A>
+typename BasicSpline<A>::Vector BasicSpline<A>::derivative(std::size_t segment, Scalar local) const
+{
+ return (Scalar(3.0)*local*coefficients[3][segment] + Scalar(2.0)*coefficients[2][segment])*local + coefficients[1][segment];
+}
+
+template <typename A>
+typename BasicSpline<A>::Scalar BasicSpline<A>::speed(std::size_t segment, Scalar local) const
+{
+ return ::length(derivative(segment, local));
+}
+
+// Gauss-Legendre with the first points nodes; 3 is plenty within a table interval
+template <typename A>
+typename BasicSpline<A>::Scalar BasicSpline<A>::segmentArcLength(std::size_t segment, Scalar from, Scalar to, int points) const
+{
+ const double half = 0.5*(double(to) - double(from)), middle = 0.5*(double(to) + double(from));
+ double sum = 0.0;
+ for (int k = 0; k < points; ++k) sum += gaussWeights[points - 3][k]*double(speed(segment, Scalar(middle + half*gaussNodes[points - 3][k])));
+ return Scalar(sum*half);
+}
+
+template <typename A>
+typename BasicSpline<A>::Vector BasicSpline<A>::at(Scalar t) const
+{
+ std::size_t segment;
+ Scalar local;
+ segmentAt(t, segment, local);
+ return evaluate(segment, local);
+}
+
+template <typename A>
+typename BasicSpline<A>::Vector BasicSpline<A>::tangent(Scalar t) const
+{
+ std::size_t segment;
+ Scalar local;
+ segmentAt(t, segment, local);
+ return Scalar(coefficients[0].size())*derivative(segment, local);
+}
+
+template <typename A>
+typename BasicSpline<A>::Scalar BasicSpline<A>::parameterAtDistance(Scalar s) const
+{
+ if (!(s > Scalar(0.0))) return Scalar(0.0);
+ if (!(s < length())) return Scalar(1.0);
+
+ // the table interval holding s, then two Newton steps from a linear guess
+ const std::size_t k = std::size_t(std::upper_bound(arcLengths.begin(), arcLengths.end(), s) - arcLengths.begin()) - 1;
+ const std::size_t segment = k/arcTableResolution;
+ const Scalar from = Scalar(k%arcTableResolution)/arcTableResolution;
+ const Scalar to = from + Scalar(1.0)/arcTableResolution;
+ const Scalar span = arcLengths[k + 1] - arcLengths[k];
+ Scalar local = (span > Scalar(0.0)) ? from + (s - arcLengths[k])/span*(to - from) : from;
+ for (int step = 0; step < 2; ++step)
+ {
+  const Scalar v = speed(segment, local);
+  if (!(v > Scalar(0.0))) break;
+  local -= (arcLengths[k] + segmentArcLength(segment, from, local, 3) - s)/v;
+  local = std::min(std::max(local, from), to);
+ }
+ return (Scalar(segment) + local)/Scalar(coefficients[0].size());
+}
+
+template <typename A>
+typename BasicSpline<A>::Vector BasicSpline<A>::atDistance(Scalar s) const
+{
+ return at(parameterAtDistance(s));
+}
+
+template <typename A>
+void BasicSpline<A>::evaluateArray(const Scalar *t, std::size_t n, A &points, A *tangents) const
+{
+ typedef SIMDPack<Scalar> Pack;
+ points.resize(n);
+ if (tangents != nullptr) tangents->resize(n);
+ const Scalar tangentScale = Scalar(coefficients[0].size());
+
+ std::size_t segments[splineChunkSize];
+ Scalar locals[splineChunkSize];
+ for (std::size_t chunk = 0; chunk < n; chunk += splineChunkSize)
+ {
+  const std::size_t count = std::min(splineChunkSize, n - chunk);
+  for (std::size_t i = 0; i < count; ++i) segmentAt(t[chunk + i], segments[i], locals[i]);
+
+  // each run of samples on one segment shares its coefficients
+  for (std::size_t first = 0, last; first < count; first = last)
+  {
+   const std::size_t segment = segments[first];
+   for (last = first + 1; last < count && segments[last] == segment; ++last) {}
+
+   for (unsigned k = 0; k < A::dimension; ++k)
+   {
+    const Scalar c0 = coefficients[0].lane(k)[segment], c1 = coefficients[1].lane(k)[segment];
+    const Scalar c2 = coefficients[2].lane(k)[segment], c3 = coefficients[3].lane(k)[segment];
+    const Pack p0 = Pack::broadcast(c0), p1 = Pack::broadcast(c1), p2 = Pack::broadcast(c2), p3 = Pack::broadcast(c3);
+    const Pack d1 = Pack::broadcast(c1*tangentScale), d2 = Pack::broadcast(Scalar(2.0)*c2*tangentScale), d3 = Pack::broadcast(Scalar(3.0)*c3*tangentScale);
+    Scalar *out = &points.lane(k)[chunk];
+    Scalar *outTangent = (tangents != nullptr) ? &tangents->lane(k)[chunk] : nullptr;
+
+    std::size_t i = first;
+    for (; i + Pack::width <= last; i += Pack::width)
+    {
+     const Pack l = Pack::load(&locals[i]);
+     (((p3*l + p2)*l + p1)*l + p0).store(out + i);
+     if (outTangent != nullptr) ((d3*l + d2)*l + d1).store(outTangent + i);
+    }
+    for (; i < last; ++i)
+    {
+     const Scalar l = locals[i];
+     out[i] = ((c3*l + c2)*l + c1)*l + c0;
+     if (outTangent != nullptr) outTangent[i] = ((Scalar(3.0)*c3*l + Scalar(2.0)*c2)*l + c1)*tangentScale;
+    }
+   }
+  }
+ }
+}
+
+// evenly spaced values from 0 to 1 inclusive
+template <typename S>
+static void evenSteps(std::size_t samples, BasicScalarArray<S> &t)
+{
+ t.resize(samples);
+ const S step = (samples > 1) ? S(1.0)/S(samples - 1) : S(0.0);
+ for (std::size_t i = 0; i < samples; ++i) t[i] = S(i)*step;
+ if (samples > 1) t[samples - 1] = S(1.0);
+}
+
+template <typename A>
+void BasicSpline<A>::sample(std::size_t samples, A &points) const
+{
+ BasicScalarArray<Scalar> t;
+ evenSteps(samples, t);
+ evaluateArray(t.data(), samples, points, nullptr);
+}
+
+template <typename A>
+void BasicSpline<A>::sample(std::size_t samples, A &points, A &tangents) const
+{
+ BasicScalarArray<Scalar> t;
+ evenSteps(samples, t);
+ evaluateArray(t.data(), samples, points, &tangents);
+}
+
+template <typename A>
+void BasicSpline<A>::sample(const BasicScalarArray<Scalar> &t, A &points) const
+{
+ evaluateArray(t.data(), t.size(), points, nullptr);
+}
+
+template <typename A>
+void BasicSpline<A>::sample(const BasicScalarArray<Scalar> &t, A &points, A &tangents) const
+{
+ evaluateArray(t.data(), t.size(), points, &tangents);
+}
+
+template <typename A>
+void BasicSpline<A>::sampleByDistance(std::size_t samples, A &points) const
+{
+ BasicScalarArray<Scalar> t;
+ evenSteps(samples, t);
+ for (Scalar &x : t) x = parameterAtDistance(x*length());
+ evaluateArray(t.data(), samples, points, nullptr);
+}
+
+template <typename A>
+void BasicSpline<A>::sampleByDistance(std::size_t samples, A &points, A &tangents) const
+{
+ BasicScalarArray<Scalar> t;
+ evenSteps(samples, t);
+ for (Scalar &x : t) x = parameterAtDistance(x*length());
+ evaluateArray(t.data(), samples, points, &tangents);
+ normalizeVectorArray(tangents, tangents);
+}
+
+template class BasicSpline<BasicTVectorArray<float> >;
+template class BasicSpline<BasicTVectorArray<double> >;
+template class BasicSpline<BasicPVectorArray<float> >;
+template class BasicSpline<BasicPVectorArray<double> >;
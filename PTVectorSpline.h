@@ -0,0 +1,138 @@
+/******************************************************************************
+*
+*     PTVectorSpline.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#ifndef PTVECTORSPLINE_H_INCLUDED
+#define PTVECTORSPLINE_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include <cstddef>
+#include <vector>
+
+// Smooth paths through, or guided by, an array of control points, sampled a
+// whole path at a time. A is a TVectorArray or PVectorArray (or their D
+// versions) and the spline keeps its own copy of the control points as one
+// cubic polynomial per segment.
+//
+//  catmullRom              passes through every point, with n - 1 segments.
+//                          The ends carry on in the direction of the first
+//                          and last segments.
+//  centripetalCatmullRom   the same, but with knots spaced by the square root
+//                          of the distance between points, so it doesn't
+//                          overshoot or loop where the points bunch up.
+//                          A repeated point gives a constant segment.
+//  bezier                  piecewise cubic Bezier: points 0 to 3 make the
+//                          first segment, 3 to 6 the next and so on. Points
+//                          after the last whole segment are ignored.
+//
+// The spline parameter t runs from 0 at the start to 1 at the end, each
+// segment taking an equal share; tangents are derivatives with respect to
+// t. A table of arc lengths at arcTableResolution points per segment is
+// built with the spline, so points can also be placed by distance along the
+// curve, where the tangent is the unit direction of travel.
+//
+// TVectorSpline path(waypoints, SplineType::centripetalCatmullRom);
+// path.sample(256, points, tangents);             // even steps of t
+// path.sampleByDistance(256, points, tangents);   // even steps along the curve
+
+static const std::size_t arcTableResolution = 16;
+
+enum class SplineType
+{
+ catmullRom,
+ centripetalCatmullRom,
+ bezier
+};
+
+template <typename A>
+class BasicSpline
+{
+public:
+ typedef typename A::Scalar Scalar;
+ typedef typename A::Vector Vector;
+
+ BasicSpline(const A &controlPoints, SplineType type);
+
+ SplineType type() const
+ {
+  return splineType;
+ }
+
+ // the number of cubic segments, 0 if there were too few points for one
+ std::size_t segments() const
+ {
+  return segmentCount;
+ }
+
+ // the arc length of the whole curve
+ Scalar length() const
+ {
+  return arcLengths.back();
+ }
+
+ // t is clamped to [0, 1]
+ Vector at(Scalar t) const;
+ Vector tangent(Scalar t) const;
+
+ // the parameter and the point at distance s along the curve, clamped to [0, length()]
+ Scalar parameterAtDistance(Scalar s) const;
+ Vector atDistance(Scalar s) const;
+
+ // samples points evenly spaced in t, from the start to the end inclusive
+ void sample(std::size_t samples, A &points) const;
+ void sample(std::size_t samples, A &points, A &tangents) const;
+
+ // the points and tangents at each t, fastest when t is in order
+ void sample(const BasicScalarArray<Scalar> &t, A &points) const;
+ void sample(const BasicScalarArray<Scalar> &t, A &points, A &tangents) const;
+
+ // samples points evenly spaced along the curve, with unit tangents
+ void sampleByDistance(std::size_t samples, A &points) const;
+ void sampleByDistance(std::size_t samples, A &points, A &tangents) const;
+
+private:
+ void segmentAt(Scalar t, std::size_t &segment, Scalar &local) const;
+ Vector evaluate(std::size_t segment, Scalar local) const;
+ Vector derivative(std::size_t segment, Scalar local) const;
+ Scalar speed(std::size_t segment, Scalar local) const;
+ Scalar segmentArcLength(std::size_t segment, Scalar from, Scalar to, int points) const;
+ void evaluateArray(const Scalar *t, std::size_t n, A &points, A *tangents) const;
+
+ SplineType splineType;
+ std::size_t segmentCount;
+ // the point on segment i at local parameter l is c0[i] + c1[i]*l + c2[i]*l^2 + c3[i]*l^3
+ A coefficients[4];
+ // the arc length from the start to each table point, arcTableResolution per segment
+ std::vector<Scalar> arcLengths;
+};
+
+// instantiated for float and double in PTVectorSpline.cpp
+typedef BasicSpline<TVectorArray> TVectorSpline;
+typedef BasicSpline<TVectorArrayD> TVectorSplineD;
+typedef BasicSpline<PVectorArray> PVectorSpline;
+typedef BasicSpline<PVectorArrayD> PVectorSplineD;
+
+#endif // PTVECTORSPLINE_H_INCLUDED
@@ -0,0 +1,94 @@
+/******************************************************************************
+*
+*     PTVectorThreadPool.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorThreadPool.h"
+
+VectorThreadPool::VectorThreadPool(unsigned threads)
+ : task(nullptr), taskCount(0), nextTask(0), busyWorkers(0), generation(0), stopping(false)
+{
+ if (threads == 0) threads = std::thread::hardware_concurrency();
+ for (unsigned i = 1; i < threads; ++i) workers.emplace_back(&VectorThreadPool::workerLoop, this);
+}
+
+VectorThreadPool::~VectorThreadPool()
+{
+ {
+  std::lock_guard<std::mutex> lock(mutex);
+  stopping = true;
+ }
+ wake.notify_all();
+ for (std::thread &worker : workers) worker.join();
+}
+
+void VectorThreadPool::runTasks()
+{
+ for (std::size_t i = nextTask++; i < taskCount; i = nextTask++) (*task)(i);
+}
+
+void VectorThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &f)
+{
+ if (workers.empty() || count < 2)
+ {
+  for (std::size_t i = 0; i < count; ++i) f(i);
+  return;
+ }
+
+ {
+  std::lock_guard<std::mutex> lock(mutex);
+  task = &f;
+  taskCount = count;
+  nextTask = 0;
+  busyWorkers = workers.size();
+  ++generation;
+ }
+ wake.notify_all();
+
+ runTasks();
+
+ std::unique_lock<std::mutex> lock(mutex);
+ finished.wait(lock, [this] { return busyWorkers == 0; });
+ task = nullptr;
+}
+
+// Each worker waits for a new generation of work, takes tasks until there are
+// none left, then reports back
+void VectorThreadPool::workerLoop()
+{
+ std::uint64_t seen = 0;
+ std::unique_lock<std::mutex> lock(mutex);
+ for (;;)
+ {
+  wake.wait(lock, [this, &seen] { return stopping || generation != seen; });
+  if (stopping) return;
+  seen = generation;
+
+  lock.unlock();
+  runTasks();
+  lock.lock();
+
+  if (--busyWorkers == 0) finished.notify_one();
+ }
+}
@@ -0,0 +1,99 @@
+/******************************************************************************
+*
+*     PTVectorThreadPool.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTORTHREADPOOL_H_INCLUDED
+#define PTVECTORTHREADPOOL_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for splitting array work across cores.
+// The functions that accept a pool run on the calling thread alone when
+// given nullptr. Build with -pthread.
+//
+// VectorThreadPool pool;                 // one thread per core
+// pool.parallelFor(blocks, [&](std::size_t b) { ... });
+class VectorThreadPool
+{
+public:
+ // threads counts the calling thread, 0 means one per hardware thread
+ explicit VectorThreadPool(unsigned threads = 0);
+ ~VectorThreadPool();
+
+ VectorThreadPool(const VectorThreadPool&) = delete;
+ VectorThreadPool& operator=(const VectorThreadPool&) = delete;
+
+ // the number of threads parallelFor uses, including the caller
+ unsigned size() const
+ {
+  return unsigned(workers.size()) + 1;
+ }
+
+ // Runs task(i) for every i in [0, count) across the pool and the calling
+ // thread, returning once all are done. Tasks are handed out in no fixed
+ // order, must not throw, and parallelFor must not be called from more than
+ // one thread at a time.
+ void parallelFor(std::size_t count, const std::function<void(std::size_t)> &task);
+
+private:
+ void workerLoop();
+ void runTasks();
+
+ std::vector<std::thread> workers;
+ std::mutex mutex;
+ std::condition_variable wake;
+ std::condition_variable finished;
+ const std::function<void(std::size_t)> *task;
+ std::size_t taskCount;
+ std::atomic<std::size_t> nextTask;
+ std::size_t busyWorkers;
+ std::uint64_t generation;
+ bool stopping;
+};
+
+// Runs kernel(begin, end) over [0, n) in blocks of blockSize, across the pool
+// if there is one. The batch functions size their outputs first, so each
+// block only writes its own range.
+template <typename Kernel>
+inline void forEachBlock(std::size_t n, std::size_t blockSize, VectorThreadPool *pool, const Kernel &kernel)
+{
+ const std::size_t blocks = (n + blockSize - 1)/blockSize;
+ const std::function<void(std::size_t)> task = [&](std::size_t b)
+ {
+  kernel(b*blockSize, std::min(n, (b + 1)*blockSize));
+ };
+
+ if (pool) pool->parallelFor(blocks, task);
+ else for (std::size_t b = 0; b < blocks; ++b) task(b);
+}
+
+#endif // PTVECTORTHREADPOOL_H_INCLUDED
@@ -0,0 +1,388 @@
+/******************************************************************************
+*
+*     PTVectorTrajectory.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+
+#include "PTVectorTrajectory.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PTVECTORTRAJECTORY_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char trajectoryMagic[8] = {'P', 'T', 'V', 'T', 'R', 'A', 'J', '\0'};
+
+static std::string scratchPath(const std::string &path, unsigned k)
+{
+ return path + ".scratch" + char('0' + k);
+}
+
+bool readTrajectoryHeader(const std::string &path, TrajectoryHeader &header)
+{
+ std::FILE *file = std::fopen(path.c_str(), "rb");
+ if (file == nullptr) return false;
+ const bool read = std::fread(&header, sizeof(header), 1, file) == 1;
+ std::fclose(file);
+ return read && std::memcmp(header.magic, trajectoryMagic, sizeof(trajectoryMagic)) == 0 &&
+        header.version == trajectoryVersion && header.byteOrder == trajectoryByteOrder;
+}
+
+template <typename V>
+void BasicVectorArrayView<V>::copyTo(Array &out, std::size_t first, std::size_t n) const
+{
+ out.resize(n);
+ if (stride == 1)
+ {
+  for (unsigned k = 0; k < Traits::dimension; ++k) std::copy(component[k] + first, component[k] + first + n, Traits::lane(out, k));
+ }
+ else
+ {
+  for (std::size_t i = 0; i < n; ++i) out.set(i, (*this)[first + i]);
+ }
+}
+
+template <typename V>
+BasicTrajectoryWriter<V>::BasicTrajectoryWriter(const std::string &path, TrajectoryLayout layout, bool timestamps)
+{
+ open(path, layout, timestamps);
+}
+
+template <typename V>
+BasicTrajectoryWriter<V>::~BasicTrajectoryWriter()
+{
+ if (file != nullptr) close();
+}
+
+template <typename V>
+bool BasicTrajectoryWriter<V>::open(const std::string &path, TrajectoryLayout layout, bool timestamps)
+{
+ if (file != nullptr) close();
+ this->path = path;
+ this->layout = layout;
+ timestamped = timestamps;
+ failed = false;
+ written = 0;
+ staged.clear();
+ stagedTimes.clear();
+
+ file = std::fopen(path.c_str(), "wb");
+ bool opened = file != nullptr;
+ if (layout == TrajectoryLayout::soa)
+ {
+  for (unsigned k = 1; k < Traits::dimension; ++k)
+  {
+   scratch[k - 1] = std::fopen(scratchPath(path, k - 1).c_str(), "wb+");
+   opened = opened && scratch[k - 1] != nullptr;
+  }
+ }
+ if (timestamped)
+ {
+  scratch[2] = std::fopen(scratchPath(path, 2).c_str(), "wb+");
+  opened = opened && scratch[2] != nullptr;
+ }
+
+ // the header stays zero, and so invalid, until close()
+ const TrajectoryHeader blank = {};
+ if (!opened || !writeRun(file, &blank, sizeof(blank)))
+ {
+  closeFiles();
+  return false;
+ }
+ staged.reserve(trajectoryBlockSize);
+ if (timestamped) stagedTimes.reserve(trajectoryBlockSize);
+ return true;
+}
+
+template <typename V>
+void BasicTrajectoryWriter<V>::push_back(const V &v, double time)
+{
+ // with nowhere to write them, vectors would only pile up in staged
+ if (file == nullptr) return;
+ staged.push_back(v);
+ if (timestamped) stagedTimes.push_back(time);
+ if (staged.size() == trajectoryBlockSize) flush();
+}
+
+template <typename V>
+void BasicTrajectoryWriter<V>::append(const Array &a)
+{
+ for (std::size_t i = 0; i < a.size(); ++i) push_back(a[i]);
+}
+
+template <typename V>
+void BasicTrajectoryWriter<V>::append(const Array &a, const ScalarArrayD &times)
+{
+ for (std::size_t i = 0; i < a.size(); ++i) push_back(a[i], times[i]);
+}
+
+template <typename V>
+void BasicTrajectoryWriter<V>::flush()
+{
+ const std::size_t n = staged.size();
+ if (file == nullptr)
+ {
+  staged.clear();
+  stagedTimes.clear();
+  return;
+ }
+ if (n == 0) return;
+
+ if (layout == TrajectoryLayout::aos)
+ {
+  std::vector<V> records(n);
+  for (std::size_t i = 0; i < n; ++i) records[i] = staged[i];
+  writeRun(file, records.data(), n*sizeof(V));
+ }
+ else
+ {
+  writeRun(file, Traits::lane(staged, 0), n*sizeof(Scalar));
+  for (unsigned k = 1; k < Traits::dimension; ++k) writeRun(scratch[k - 1], Traits::lane(staged, k), n*sizeof(Scalar));
+ }
+ if (timestamped) writeRun(scratch[2], stagedTimes.data(), n*sizeof(double));
+
+ written += n;
+ staged.clear();
+ stagedTimes.clear();
+}
+
+template <typename V>
+bool BasicTrajectoryWriter<V>::writeRun(std::FILE *to, const void *data, std::size_t bytes)
+{
+ if (!failed && std::fwrite(data, 1, bytes, to) != bytes) failed = true;
+ return !failed;
+}
+
+// appends the first bytes of a scratch file to the output
+template <typename V>
+bool BasicTrajectoryWriter<V>::copyRun(std::FILE *from, std::uint64_t bytes, std::uint64_t &position)
+{
+ if (!failed && (std::fflush(from) != 0 || std::fseek(from, 0, SEEK_SET) != 0)) failed = true;
+ std::vector<unsigned char> chunk(1 << 20);
+ for (std::uint64_t left = bytes; left > 0 && !failed;)
+ {
+  const std::size_t n = std::size_t(std::min<std::uint64_t>(left, chunk.size()));
+  if (std::fread(chunk.data(), 1, n, from) != n) failed = true;
+  writeRun(file, chunk.data(), n);
+  left -= n;
+ }
+ position += bytes;
+ return !failed;
+}
+
+// zeros up to the next trajectoryAlignment boundary
+template <typename V>
+bool BasicTrajectoryWriter<V>::pad(std::uint64_t &position)
+{
+ static const unsigned char zeros[trajectoryAlignment] = {};
+ const std::size_t n = std::size_t((trajectoryAlignment - position%trajectoryAlignment)%trajectoryAlignment);
+ position += n;
+ return writeRun(file, zeros, n);
+}
+
+template <typename V>
+bool BasicTrajectoryWriter<V>::close()
+{
+ if (file == nullptr) return false;
+ flush();
+
+ TrajectoryHeader header = {};
+ std::memcpy(header.magic, trajectoryMagic, sizeof(trajectoryMagic));
+ header.version = trajectoryVersion;
+ header.byteOrder = trajectoryByteOrder;
+ header.scalarSize = sizeof(Scalar);
+ header.dimension = Traits::dimension;
+ header.layout = std::uint8_t(layout);
+ header.flags = timestamped ? trajectoryHasTimestamps : 0;
+ header.count = written;
+
+ std::uint64_t position = sizeof(header);
+ const std::uint64_t laneBytes = std::uint64_t(written)*sizeof(Scalar);
+ if (layout == TrajectoryLayout::aos)
+ {
+  for (unsigned k = 0; k < Traits::dimension; ++k) header.componentOffset[k] = position + k*sizeof(Scalar);
+  position += laneBytes*Traits::dimension;
+ }
+ else
+ {
+  header.componentOffset[0] = position;
+  position += laneBytes;
+  for (unsigned k = 1; k < Traits::dimension; ++k)
+  {
+   pad(position);
+   header.componentOffset[k] = position;
+   copyRun(scratch[k - 1], laneBytes, position);
+  }
+ }
+ if (timestamped)
+ {
+  pad(position);
+  header.timestampOffset = position;
+  copyRun(scratch[2], std::uint64_t(written)*sizeof(double), position);
+ }
+
+ if (!failed && (std::fflush(file) != 0 || std::fseek(file, 0, SEEK_SET) != 0)) failed = true;
+ writeRun(file, &header, sizeof(header));
+ closeFiles();
+ return !failed;
+}
+
+template <typename V>
+void BasicTrajectoryWriter<V>::closeFiles()
+{
+ if (file != nullptr && std::fclose(file) != 0) failed = true;
+ file = nullptr;
+ for (unsigned k = 0; k < 3; ++k)
+ {
+  if (scratch[k] == nullptr) continue;
+  std::fclose(scratch[k]);
+  std::remove(scratchPath(path, k).c_str());
+  scratch[k] = nullptr;
+ }
+ staged.clear();
+ stagedTimes.clear();
+}
+
+// whether count elements from offset lie within the file, aligned for scalars of scalarBytes
+static bool runFits(std::uint64_t offset, std::uint64_t count, std::size_t elementBytes, std::size_t scalarBytes, std::uint64_t fileBytes)
+{
+ return offset >= sizeof(TrajectoryHeader) && offset%scalarBytes == 0 && offset <= fileBytes &&
+        count <= (fileBytes - offset)/elementBytes;
+}
+
+template <typename V>
+BasicTrajectoryReader<V>::BasicTrajectoryReader(const std::string &path)
+{
+ open(path);
+}
+
+template <typename V>
+BasicTrajectoryReader<V>::~BasicTrajectoryReader()
+{
+ close();
+}
+
+template <typename V>
+bool BasicTrajectoryReader<V>::open(const std::string &path)
+{
+ close();
+
+#ifdef PTVECTORTRAJECTORY_MMAP
+ const int fd = ::open(path.c_str(), O_RDONLY);
+ if (fd < 0) return false;
+ struct stat status;
+ if (::fstat(fd, &status) != 0 || std::uint64_t(status.st_size) < sizeof(TrajectoryHeader))
+ {
+  ::close(fd);
+  return false;
+ }
+ mappedBytes = std::size_t(status.st_size);
+ void *mapped = ::mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+ ::close(fd);
+ if (mapped == MAP_FAILED)
+ {
+  mappedBytes = 0;
+  return false;
+ }
+ base = static_cast<const unsigned char*>(mapped);
+#else
+ std::FILE *file = std::fopen(path.c_str(), "rb");
+ if (file == nullptr) return false;
+ std::fseek(file, 0, SEEK_END);
+ const long length = std::ftell(file);
+ std::fseek(file, 0, SEEK_SET);
+ if (length < long(sizeof(TrajectoryHeader)))
+ {
+  std::fclose(file);
+  return false;
+ }
+ mappedBytes = std::size_t(length);
+ buffer.resize((mappedBytes + sizeof(std::uint64_t) - 1)/sizeof(std::uint64_t));
+ const bool read = std::fread(buffer.data(), 1, mappedBytes, file) == mappedBytes;
+ std::fclose(file);
+ base = reinterpret_cast<const unsigned char*>(buffer.data());
+ if (!read)
+ {
+  close();
+  return false;
+ }
+#endif
+
+ std::memcpy(&header, base, sizeof(header));
+ const std::uint64_t count = header.count;
+ bool valid = std::memcmp(header.magic, trajectoryMagic, sizeof(trajectoryMagic)) == 0 &&
+              header.version == trajectoryVersion && header.byteOrder == trajectoryByteOrder &&
+              header.scalarSize == sizeof(Scalar) && header.dimension == Traits::dimension &&
+              header.layout <= std::uint8_t(TrajectoryLayout::soa) && (header.flags & ~trajectoryHasTimestamps) == 0;
+ if (valid && layout() == TrajectoryLayout::aos)
+ {
+  valid = runFits(header.componentOffset[0], count, sizeof(V), sizeof(Scalar), mappedBytes);
+  for (unsigned k = 1; k < Traits::dimension; ++k) valid = valid && header.componentOffset[k] == header.componentOffset[0] + k*sizeof(Scalar);
+ }
+ else
+ {
+  for (unsigned k = 0; k < Traits::dimension; ++k) valid = valid && runFits(header.componentOffset[k], count, sizeof(Scalar), sizeof(Scalar), mappedBytes);
+ }
+ if (valid && (header.flags & trajectoryHasTimestamps)) valid = runFits(header.timestampOffset, count, sizeof(double), sizeof(double), mappedBytes);
+ if (!valid)
+ {
+  close();
+  return false;
+ }
+
+ for (unsigned k = 0; k < Traits::dimension; ++k) view.component[k] = reinterpret_cast<const Scalar*>(base + header.componentOffset[k]);
+ view.stride = (layout() == TrajectoryLayout::aos) ? Traits::dimension : 1;
+ view.count = std::size_t(count);
+ if (header.flags & trajectoryHasTimestamps) times = reinterpret_cast<const double*>(base + header.timestampOffset);
+ return true;
+}
+
+template <typename V>
+void BasicTrajectoryReader<V>::close()
+{
+#ifdef PTVECTORTRAJECTORY_MMAP
+ if (base != nullptr) ::munmap(const_cast<unsigned char*>(base), mappedBytes);
+#endif
+ buffer.clear();
+ base = nullptr;
+ mappedBytes = 0;
+ header = TrajectoryHeader();
+ view = BasicVectorArrayView<V>();
+ times = nullptr;
+}
+
+#define PTVECTORTRAJECTORY_INSTANTIATE(V) \
+ static_assert(sizeof(V) == TrajectoryVectorTraits<V>::dimension*sizeof(TrajectoryVectorTraits<V>::Scalar), "vectors must be packed"); \
+ template struct BasicVectorArrayView<V>; \
+ template class BasicTrajectoryWriter<V>; \
+ template class BasicTrajectoryReader<V>;
+
+PTVECTORTRAJECTORY_INSTANTIATE(BasicTVector<float>)
+PTVECTORTRAJECTORY_INSTANTIATE(BasicTVector<double>)
+PTVECTORTRAJECTORY_INSTANTIATE(BasicPVector<float>)
+PTVECTORTRAJECTORY_INSTANTIATE(BasicPVector<double>)
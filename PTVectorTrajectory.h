@@ -0,0 +1,317 @@
+/******************************************************************************
+*
+*     PTVectorTrajectory.h
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef PTVECTORTRAJECTORY_H_INCLUDED
+#define PTVECTORTRAJECTORY_H_INCLUDED
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A binary container for recorded streams of TVectors or PVectors, written a
+// vector at a time and read back by mapping the file into memory, so opening
+// even a very large recording costs next to nothing and the pages are read in
+// as they are touched.
+//
+// TVectorTrajectoryWriter out("run.ptvt", TrajectoryLayout::soa, true);
+// out.push_back(position, time);
+// out.close();
+//
+// TVectorTrajectoryReader in("run.ptvt");
+// for (std::size_t i = 0; i < in.size(); ++i) use(in.vectors()[i], in.timestamps()[i]);
+//
+// The file is a 64 byte TrajectoryHeader followed by the vectors, either as
+// whole records (AoS) or as one run per component (SoA), and then the
+// timestamps as doubles if there are any. Every run starts on a 64 byte
+// boundary. Values are stored in the byte order of the machine that wrote
+// them, and readers refuse files written in the other order.
+
+enum class TrajectoryLayout : std::uint8_t
+{
+ aos = 0,
+ soa = 1
+};
+
+static const std::uint32_t trajectoryVersion = 1;
+static const std::uint32_t trajectoryByteOrder = 0x01020304;
+static const std::uint8_t trajectoryHasTimestamps = 1;
+static const std::size_t trajectoryAlignment = 64;
+static const std::size_t trajectoryBlockSize = 65536;
+
+struct TrajectoryHeader
+{
+ char magic[8];                       // "PTVTRAJ" and a zero, written last
+ std::uint32_t version;
+ std::uint32_t byteOrder;             // trajectoryByteOrder as the writer saw it
+ std::uint8_t scalarSize;             // 4 for float, 8 for double
+ std::uint8_t dimension;              // 3 for TVectors, 2 for PVectors
+ std::uint8_t layout;                 // a TrajectoryLayout
+ std::uint8_t flags;                  // trajectoryHasTimestamps
+ std::uint32_t reserved;
+ std::uint64_t count;                 // the number of vectors
+ std::uint64_t componentOffset[3];    // the byte offset of each component of the first vector
+ std::uint64_t timestampOffset;       // 0 without timestamps
+};
+
+static_assert(sizeof(TrajectoryHeader) == trajectoryAlignment, "TrajectoryHeader must be 64 bytes");
+
+// Reads the header of a trajectory file, to find out what sort of reader it
+// needs. False if the file can't be read or isn't a complete trajectory.
+bool readTrajectoryHeader(const std::string &path, TrajectoryHeader &header);
+
+// What the trajectory classes need to know about each vector type
+template <typename V>
+struct TrajectoryVectorTraits;
+
+template <typename S>
+struct TrajectoryVectorTraits<BasicTVector<S> >
+{
+ typedef S Scalar;
+ typedef BasicTVectorArray<S> Array;
+ static const unsigned dimension = 3;
+
+ static BasicTVector<S> make(const S *const component[3], std::size_t j)
+ {
+  return {component[0][j], component[1][j], component[2][j]};
+ }
+
+ static const S* lane(const Array &a, unsigned k)
+ {
+  return (k == 0) ? a.xEast.data() : (k == 1) ? a.yNorth.data() : a.zUp.data();
+ }
+
+ static S* lane(Array &a, unsigned k)
+ {
+  return (k == 0) ? a.xEast.data() : (k == 1) ? a.yNorth.data() : a.zUp.data();
+ }
+};
+
+template <typename S>
+struct TrajectoryVectorTraits<BasicPVector<S> >
+{
+ typedef S Scalar;
+ typedef BasicPVectorArray<S> Array;
+ static const unsigned dimension = 2;
+
+ static BasicPVector<S> make(const S *const component[3], std::size_t j)
+ {
+  return {component[0][j], component[1][j]};
+ }
+
+ static const S* lane(const Array &a, unsigned k)
+ {
+  return (k == 0) ? a.u.data() : a.v.data();
+ }
+
+ static S* lane(Array &a, unsigned k)
+ {
+  return (k == 0) ? a.u.data() : a.v.data();
+ }
+};
+
+// A read only view of vectors held elsewhere, in either layout. Component k of
+// vector i is component[k][i*stride], with a stride of 1 for SoA and the
+// dimension for AoS.
+template <typename V>
+struct BasicVectorArrayView
+{
+ typedef TrajectoryVectorTraits<V> Traits;
+ typedef typename Traits::Scalar Scalar;
+ typedef typename Traits::Array Array;
+
+ const Scalar *component[3] = {nullptr, nullptr, nullptr};
+ std::size_t stride = 1;
+ std::size_t count = 0;
+
+ std::size_t size() const
+ {
+  return count;
+ }
+
+ V operator[](std::size_t i) const
+ {
+  return Traits::make(component, i*stride);
+ }
+
+ // the vectors themselves for an AoS view, nullptr for SoA
+ const V* data() const
+ {
+  return (stride == Traits::dimension) ? reinterpret_cast<const V*>(component[0]) : nullptr;
+ }
+
+ // each component as a contiguous lane for an SoA view, nullptr for AoS
+ const Scalar* lane(unsigned k) const
+ {
+  return (stride == 1) ? component[k] : nullptr;
+ }
+
+ // Copies n vectors from first into out, resizing it, so a view too large
+ // for memory can go through the batch kernels a block at a time
+ void copyTo(Array &out, std::size_t first, std::size_t n) const;
+
+ void copyTo(Array &out) const
+ {
+  copyTo(out, 0, count);
+ }
+};
+
+// Writes a trajectory a vector or an array at a time. Vectors are staged in
+// blocks of trajectoryBlockSize; for SoA and timestamps the later runs go to
+// scratch files beside the output until close() puts the file together.
+// Nothing is a valid trajectory until close() has returned true, and the
+// destructor closes an open writer.
+template <typename V>
+class BasicTrajectoryWriter
+{
+public:
+ typedef TrajectoryVectorTraits<V> Traits;
+ typedef typename Traits::Scalar Scalar;
+ typedef typename Traits::Array Array;
+
+ BasicTrajectoryWriter() = default;
+ BasicTrajectoryWriter(const std::string &path, TrajectoryLayout layout, bool timestamps = false);
+ ~BasicTrajectoryWriter();
+
+ BasicTrajectoryWriter(const BasicTrajectoryWriter&) = delete;
+ BasicTrajectoryWriter& operator=(const BasicTrajectoryWriter&) = delete;
+
+ // false if the output or a scratch file can't be created
+ bool open(const std::string &path, TrajectoryLayout layout, bool timestamps = false);
+
+ // Writes the header and closes the file, false if anything went wrong
+ // since open()
+ bool close();
+
+ bool isOpen() const
+ {
+  return file != nullptr;
+ }
+
+ bool hasTimestamps() const
+ {
+  return timestamped;
+ }
+
+ // the number of vectors written so far
+ std::size_t size() const
+ {
+  return written + staged.size();
+ }
+
+ // Timestamps are 0 when the trajectory has them but none are given, and
+ // ignored when it doesn't. Vectors are dropped while the writer isn't open.
+ void push_back(const V &v, double time = 0.0);
+ void append(const Array &a);
+ void append(const Array &a, const ScalarArrayD &times);
+
+private:
+ void flush();
+ bool writeRun(std::FILE *to, const void *data, std::size_t bytes);
+ bool copyRun(std::FILE *from, std::uint64_t bytes, std::uint64_t &position);
+ bool pad(std::uint64_t &position);
+ void closeFiles();
+
+ std::string path;
+ std::FILE *file = nullptr;
+ std::FILE *scratch[3] = {nullptr, nullptr, nullptr};   // SoA components 1 and 2, then timestamps
+ TrajectoryLayout layout = TrajectoryLayout::aos;
+ bool timestamped = false;
+ bool failed = false;
+ std::size_t written = 0;
+ Array staged;
+ ScalarArrayD stagedTimes;
+};
+
+// Maps a trajectory file read only and presents its contents in place. open()
+// fails if the file isn't a complete trajectory of V. Where mmap isn't
+// available the file is read into memory instead.
+template <typename V>
+class BasicTrajectoryReader
+{
+public:
+ typedef TrajectoryVectorTraits<V> Traits;
+ typedef typename Traits::Scalar Scalar;
+
+ BasicTrajectoryReader() = default;
+ explicit BasicTrajectoryReader(const std::string &path);
+ ~BasicTrajectoryReader();
+
+ BasicTrajectoryReader(const BasicTrajectoryReader&) = delete;
+ BasicTrajectoryReader& operator=(const BasicTrajectoryReader&) = delete;
+
+ bool open(const std::string &path);
+ void close();
+
+ bool isOpen() const
+ {
+  return base != nullptr;
+ }
+
+ std::size_t size() const
+ {
+  return view.count;
+ }
+
+ TrajectoryLayout layout() const
+ {
+  return TrajectoryLayout(header.layout);
+ }
+
+ // valid until close()
+ const BasicVectorArrayView<V>& vectors() const
+ {
+  return view;
+ }
+
+ // size() timestamps, or nullptr if the trajectory has none
+ const double* timestamps() const
+ {
+  return times;
+ }
+
+private:
+ const unsigned char *base = nullptr;
+ std::size_t mappedBytes = 0;
+ std::vector<std::uint64_t> buffer;   // only where the file can't be mapped
+ TrajectoryHeader header = {};
+ BasicVectorArrayView<V> view;
+ const double *times = nullptr;
+};
+
+// instantiated for float and double in PTVectorTrajectory.cpp
+typedef BasicTrajectoryWriter<TVector> TVectorTrajectoryWriter;
+typedef BasicTrajectoryWriter<TVectorD> TVectorTrajectoryWriterD;
+typedef BasicTrajectoryWriter<PVector> PVectorTrajectoryWriter;
+typedef BasicTrajectoryWriter<PVectorD> PVectorTrajectoryWriterD;
+typedef BasicTrajectoryReader<TVector> TVectorTrajectoryReader;
+typedef BasicTrajectoryReader<TVectorD> TVectorTrajectoryReaderD;
+typedef BasicTrajectoryReader<PVector> PVectorTrajectoryReader;
+typedef BasicTrajectoryReader<PVectorD> PVectorTrajectoryReaderD;
+
+#endif // PTVECTORTRAJECTORY_H_INCLUDED
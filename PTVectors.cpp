@@ -26,41 +26,77 @@
 
 #include "PTVectors.h"
 
-void TVector::calculateUpAndRight(TVector &up, TVector &right) const
+template <typename S>
+void BasicTVector<S>::calculateUpAndRight(BasicTVector &up, BasicTVector &right) const
 {
  if (xEast == 0.0 && yNorth == 0.0)
  {
   if (zUp == 0.0)
   {
-   up = 0_y;
-   right = 0_x;
+   up = {0.0, 0.0, 0.0};
+   right = {0.0, 0.0, 0.0};
   }
   else if (zUp > 0.0)
   {
-   up = 1_y;
-   right = 1_x;
+   up = {0.0, 1.0, 0.0};
+   right = {1.0, 0.0, 0.0};
   }
   else
   {
-   up = -1_y;
-   right = -1_x;
+   up = {0.0, -1.0, 0.0};
+   right = {-1.0, 0.0, 0.0};
   }
  }
  else
  {
-  right = unitVector(*this/1_z);
+  right = unitVector(*this/BasicTVector{0.0, 0.0, 1.0});
   up = unitVector(right/(*this));
  }
 }
 
-TVector TVectorSLERP(const TVector &unitStart, const TVector &unitFinish, VectorPrecision slerp)
+template <typename S>
+BasicTVector<S> TVectorSLERP(const BasicTVector<S> &unitStart,
+                             const BasicTVector<S> &unitFinish,
+                             typename BasicTVector<S>::Scalar slerp)
 {
  if (unitStart == unitFinish) return unitStart;
+ return BasicTVectorSLERPPath<S>(unitStart, unitFinish).at(slerp);
+}
+
+template <typename S>
+BasicTVectorSLERPPath<S>::BasicTVectorSLERPPath(const BasicTVector<S> &unitStart, const BasicTVector<S> &unitFinish)
+ : start(unitStart), finish(unitFinish), ortho{0.0, 0.0, 0.0}, omega(0.0), linear(true)
+{
+ // clamp so rounding can't push acos out of its domain
+ S cosOmega = unitStart*unitFinish;
+ if (cosOmega > 1.0) cosOmega = 1.0;
+ if (cosOmega < -1.0) cosOmega = -1.0;
+ omega = acos(cosOmega);
+ if (omega < minimumAngle) return;
 
- VectorPrecision t1 = unitStart*unitFinish;
- VectorPrecision recipSinOmega = 1.0 / sqrt(1.0 - t1*t1);
- VectorPrecision omega = acos(t1);
- t1 = sin(omega*(1.0 - slerp))*recipSinOmega;
- VectorPrecision t2 = sin(omega*slerp)*recipSinOmega;
- return t1*unitStart + t2*unitFinish;
+ linear = false;
+ BasicTVector<S> perpendicular = unitFinish - unitStart*cosOmega;
+ S sinOmega = length(perpendicular);
+ if (sinOmega < minimumAngle)
+ {
+  BasicTVector<S> up;
+  unitStart.calculateUpAndRight(up, perpendicular);
+  omega = M_PI;
+  sinOmega = 1.0;
+ }
+ ortho = perpendicular*(1.0 / sinOmega);
 }
+
+template <typename S>
+BasicTVector<S> BasicTVectorSLERPPath<S>::at(S slerp) const
+{
+ if (linear) return LERP(start, finish, slerp);
+ return start*S(cos(omega*slerp)) + ortho*S(sin(omega*slerp));
+}
+
+template struct BasicTVector<float>;
+template struct BasicTVector<double>;
+template struct BasicTVectorSLERPPath<float>;
+template struct BasicTVectorSLERPPath<double>;
+template TVector TVectorSLERP(const TVector&, const TVector&, float);
+template TVectorD TVectorSLERP(const TVectorD&, const TVectorD&, double);
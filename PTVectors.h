@@ -26,9 +26,18 @@
 #ifndef PTVECTORS_H_INCLUDED
 #define PTVECTORS_H_INCLUDED
 
+#include "PTConstexprMath.h"
 #include <cmath>
+#include <type_traits>
 #include <utility>
 
+#ifdef PTVECTORS_FAST_TRIG
+#include "PTFastTrig.h"
+#endif
+
+// The default precision, used by TVector, PVector and the vector literals.
+// Every vector type is a template on its scalar type, so float and double
+// vectors can be used side by side; see TVectorD and PVectorD below.
 typedef float VectorPrecision;
 
 constexpr VectorPrecision radiansToDegrees(VectorPrecision radians)
@@ -41,14 +50,32 @@ constexpr VectorPrecision degreesToRadians(VectorPrecision degrees)
  return degrees/180.0*M_PI;
 }
 
+// double and long double arguments keep their precision
+template <typename S>
+constexpr typename std::enable_if<std::is_floating_point<S>::value && (sizeof(S) > sizeof(VectorPrecision)), S>::type
+radiansToDegrees(S radians)
+{
+ return radians/S(M_PI)*S(180.0);
+}
+
+template <typename S>
+constexpr typename std::enable_if<std::is_floating_point<S>::value && (sizeof(S) > sizeof(VectorPrecision)), S>::type
+degreesToRadians(S degrees)
+{
+ return degrees/S(180.0)*S(M_PI);
+}
+
 // Define TVector
-struct TVector
+template <typename S>
+struct BasicTVector
 {
- VectorPrecision xEast;
- VectorPrecision yNorth;
- VectorPrecision zUp;
+ typedef S Scalar;
 
- TVector& operator+=(const TVector &x)
+ S xEast;
+ S yNorth;
+ S zUp;
+
+ BasicTVector& operator+=(const BasicTVector &x)
  {
   xEast += x.xEast;
   yNorth += x.yNorth;
@@ -56,7 +83,7 @@ struct TVector
   return *this;
  }
 
- TVector& operator-=(const TVector &x)
+ BasicTVector& operator-=(const BasicTVector &x)
  {
   xEast -= x.xEast;
   yNorth -= x.yNorth;
@@ -64,7 +91,7 @@ struct TVector
   return *this;
  }
 
- TVector& operator*=(VectorPrecision x)
+ BasicTVector& operator*=(S x)
  {
   xEast *= x;
   yNorth *= x;
@@ -72,9 +99,21 @@ struct TVector
   return *this;
  }
 
- void calculateUpAndRight(TVector &up, TVector &right) const;
+ // Narrowing and widening between precisions is always explicit
+ // TVectorD precise = static_cast<TVectorD>(1_x);
+ template <typename U>
+ constexpr explicit operator BasicTVector<U>() const
+ {
+  return {U(xEast), U(yNorth), U(zUp)};
+ }
+
+ // instantiated for float and double in PTVectors.cpp
+ void calculateUpAndRight(BasicTVector &up, BasicTVector &right) const;
 };
 
+typedef BasicTVector<VectorPrecision> TVector;
+typedef BasicTVector<double> TVectorD;
+
 // Define some number literal types. specifying a vector constant in code has never been easier
 // TVector zAxis = 1_z;
 // TVector pythagoreanPoint = 3_x + 4_y;
@@ -172,24 +211,30 @@ constexpr TVector operator"" _mDown(long long unsigned int m)
 }
 
 // Operators for TVector
-constexpr TVector operator+(const TVector &x)
+// The scalar argument of each function is taken as Vector::Scalar, so it is
+// never used to deduce the precision and any arithmetic type converts to it
+template <typename S>
+constexpr BasicTVector<S> operator+(const BasicTVector<S> &x)
 {
  return x;
 }
 
-constexpr TVector operator-(const TVector &x)
+template <typename S>
+constexpr BasicTVector<S> operator-(const BasicTVector<S> &x)
 {
  return {-x.xEast, -x.yNorth, -x.zUp};
 }
 
-constexpr TVector operator+(const TVector &lhs, const TVector &rhs)
+template <typename S>
+constexpr BasicTVector<S> operator+(const BasicTVector<S> &lhs, const BasicTVector<S> &rhs)
 {
  return {lhs.xEast + rhs.xEast,
          lhs.yNorth + rhs.yNorth,
          lhs.zUp + rhs.zUp};
 }
 
-constexpr TVector operator-(const TVector &lhs, const TVector &rhs)
+template <typename S>
+constexpr BasicTVector<S> operator-(const BasicTVector<S> &lhs, const BasicTVector<S> &rhs)
 {
  return {lhs.xEast - rhs.xEast,
          lhs.yNorth - rhs.yNorth,
@@ -199,83 +244,163 @@ constexpr TVector operator-(const TVector &lhs, const TVector &rhs)
 // operator/ will compute the cross product
 // operator* will compute the dot product or scale the vector
 
-constexpr TVector operator/(const TVector &lhs, const TVector &rhs)
+template <typename S>
+constexpr BasicTVector<S> operator/(const BasicTVector<S> &lhs, const BasicTVector<S> &rhs)
 {
  return {lhs.yNorth*rhs.zUp - lhs.zUp*rhs.yNorth,
          lhs.zUp*rhs.xEast - lhs.xEast*rhs.zUp,
          lhs.xEast*rhs.yNorth - lhs.yNorth*rhs.xEast};
 }
 
-constexpr VectorPrecision operator*(const TVector &lhs, const TVector &rhs)
+template <typename S>
+constexpr S operator*(const BasicTVector<S> &lhs, const BasicTVector<S> &rhs)
 {
  return lhs.xEast*rhs.xEast + lhs.yNorth*rhs.yNorth + lhs.zUp*rhs.zUp;
 }
 
-constexpr TVector operator*(VectorPrecision lhs, const TVector &rhs)
+template <typename S>
+constexpr BasicTVector<S> operator*(typename BasicTVector<S>::Scalar lhs, const BasicTVector<S> &rhs)
 {
  return {lhs*rhs.xEast, lhs*rhs.yNorth, lhs*rhs.zUp};
 }
 
-constexpr TVector operator*(const TVector &lhs, VectorPrecision rhs)
+template <typename S>
+constexpr BasicTVector<S> operator*(const BasicTVector<S> &lhs, typename BasicTVector<S>::Scalar rhs)
 {
  return rhs * lhs;
 }
 
-constexpr bool operator==(const TVector &lhs, const TVector &rhs)
+template <typename S>
+constexpr bool operator==(const BasicTVector<S> &lhs, const BasicTVector<S> &rhs)
 {
  return (lhs.xEast == rhs.xEast) && (lhs.yNorth == rhs.yNorth) && (lhs.zUp == rhs.zUp);
 }
 
-constexpr bool operator!=(const TVector &lhs, const TVector &rhs)
+template <typename S>
+constexpr bool operator!=(const BasicTVector<S> &lhs, const BasicTVector<S> &rhs)
 {
  return (lhs.xEast != rhs.xEast) || (lhs.yNorth != rhs.yNorth) || (lhs.zUp != rhs.zUp);
 }
 
-TVector TVectorSLERP(const TVector &unitStart, const TVector &unitFinish, VectorPrecision slerp);
+// instantiated for float and double in PTVectors.cpp
+template <typename S>
+BasicTVector<S> TVectorSLERP(const BasicTVector<S> &unitStart,
+                             const BasicTVector<S> &unitFinish,
+                             typename BasicTVector<S>::Scalar slerp);
 
-constexpr TVector rotateTVectorAboutAxis(const TVector &v, const TVector &axis, VectorPrecision angleRadians)
+// A SLERP between two fixed unit vectors, set up once so that sampling many points
+// along the same arc doesn't repeat the acos, sqrt and 1/sin(omega) each time.
+// The arc is stored as start*cos(omega*t) + ortho*sin(omega*t), where ortho is
+// (unitFinish - unitStart*cos(omega))/sin(omega): the unit vector perpendicular
+// to start, in the plane of the arc.
+// Endpoints closer than minimumAngle are LERPed instead. Antiparallel endpoints
+// have no unique arc, so one through a perpendicular from calculateUpAndRight is used.
+template <typename S>
+struct BasicTVectorSLERPPath
 {
- return v*cos(angleRadians) + (axis/v)*sin(angleRadians) + axis*(1.0 - cos(angleRadians))*(axis*v);
+ static constexpr S minimumAngle = 1.0e-3;
+
+ BasicTVector<S> start;
+ BasicTVector<S> finish;
+ BasicTVector<S> ortho;
+ S omega;
+ bool linear;
+
+ BasicTVectorSLERPPath(const BasicTVector<S> &unitStart, const BasicTVector<S> &unitFinish);
+
+ // the point on the arc at slerp, from 0 at unitStart to 1 at unitFinish
+ BasicTVector<S> at(S slerp) const;
+};
+
+typedef BasicTVectorSLERPPath<VectorPrecision> TVectorSLERPPath;
+typedef BasicTVectorSLERPPath<double> TVectorSLERPPathD;
+
+template <typename S>
+constexpr BasicTVector<S> rotateTVectorAboutAxis(const BasicTVector<S> &v,
+                                                 const BasicTVector<S> &axis,
+                                                 typename BasicTVector<S>::Scalar angleRadians)
+{
+ return v*vectorCos(angleRadians) + (axis/v)*vectorSin(angleRadians) + axis*(1.0 - vectorCos(angleRadians))*(axis*v);
 }
 
-constexpr TVector rotateTVectorAboutPointAxis(const TVector &v,
-                                                  const TVector &origin,
-                                                  const TVector &axis,
-                                                  VectorPrecision angleRadians)
+template <typename S>
+constexpr BasicTVector<S> rotateTVectorAboutPointAxis(const BasicTVector<S> &v,
+                                                      const BasicTVector<S> &origin,
+                                                      const BasicTVector<S> &axis,
+                                                      typename BasicTVector<S>::Scalar angleRadians)
 {
  return rotateTVectorAboutAxis(v - origin, axis, angleRadians) + origin;
 }
 
-struct PVector
+template <typename S>
+struct BasicPVector
 {
- VectorPrecision u;
- VectorPrecision v;
+ typedef S Scalar;
+
+ S u;
+ S v;
 
- PVector& operator+=(const PVector &x)
+ BasicPVector& operator+=(const BasicPVector &x)
  {
   u += x.u;
   v += x.v;
   return *this;
  }
 
- PVector& operator-=(const PVector &x)
+ BasicPVector& operator-=(const BasicPVector &x)
  {
   u -= x.u;
   v -= x.v;
   return *this;
  }
 
- PVector& operator*=(VectorPrecision x)
+ BasicPVector& operator*=(S x)
  {
   u *= x;
   v *= x;
   return *this;
  }
+
+ template <typename U>
+ constexpr explicit operator BasicPVector<U>() const
+ {
+  return {U(u), U(v)};
+ }
 };
 
-constexpr PVector unitVectorAtAngle(VectorPrecision theta)
+typedef BasicPVector<VectorPrecision> PVector;
+typedef BasicPVector<double> PVectorD;
+
+// the precision can't be deduced from theta, so it defaults to VectorPrecision
+// PVectorD precise = unitVectorAtAngle<double>(theta);
+#ifdef PTVECTORS_FAST_TRIG
+// The polynomial versions from PTFastTrig.h, used at runtime in fast trig mode
+template <typename S>
+inline BasicPVector<S> fastUnitVectorAtAngle(S theta)
+{
+ BasicPVector<S> v;
+ fastSinCos(theta, v.v, v.u);
+ return v;
+}
+
+template <typename S>
+inline BasicPVector<S> fastRotatePVectorAboutOrigin(const BasicPVector<S> &v, S angleRadians)
+{
+ S sine, cosine;
+ fastSinCos(angleRadians, sine, cosine);
+ return {v.u*cosine - v.v*sine, v.u*sine + v.v*cosine};
+}
+#endif
+
+template <typename S = VectorPrecision>
+constexpr BasicPVector<S> unitVectorAtAngle(typename BasicPVector<S>::Scalar theta)
 {
- return {VectorPrecision(cos(theta)), VectorPrecision(sin(theta))};
+#ifdef PTVECTORS_FAST_TRIG
+ return PTVECTORS_CONSTANT_EVALUATED() ? BasicPVector<S>{S(vectorCos(theta)), S(vectorSin(theta))}
+        : fastUnitVectorAtAngle<S>(theta);
+#else
+ return {S(vectorCos(theta)), S(vectorSin(theta))};
+#endif
 }
 
 // Literal types for plane vector
@@ -314,109 +439,199 @@ constexpr PVector operator"" _deg(long long unsigned int deg)
 }
 
 // Operators for plane vector
-constexpr PVector operator+(const PVector &v)
+template <typename S>
+constexpr BasicPVector<S> operator+(const BasicPVector<S> &v)
 {
  return v;
 }
 
-constexpr PVector operator-(const PVector &v)
+template <typename S>
+constexpr BasicPVector<S> operator-(const BasicPVector<S> &v)
 {
  return {-v.u, -v.v};
 }
 
 // ~ will calculate the conjugate vector (mirrored about the x-axis)
-constexpr PVector operator~(const PVector &v)
+template <typename S>
+constexpr BasicPVector<S> operator~(const BasicPVector<S> &v)
 {
  return {v.u, -v.v};
 }
 
-constexpr PVector operator+(const PVector &lhs, const PVector &rhs)
+template <typename S>
+constexpr BasicPVector<S> operator+(const BasicPVector<S> &lhs, const BasicPVector<S> &rhs)
 {
  return {lhs.u + rhs.u, lhs.v + rhs.v};
 }
 
-constexpr PVector operator-(const PVector &lhs, const PVector &rhs)
+template <typename S>
+constexpr BasicPVector<S> operator-(const BasicPVector<S> &lhs, const BasicPVector<S> &rhs)
 {
  return {lhs.u - rhs.u, lhs.v - rhs.v};
 }
 
-constexpr VectorPrecision operator*(const PVector &lhs, const PVector &rhs)
+template <typename S>
+constexpr S operator*(const BasicPVector<S> &lhs, const BasicPVector<S> &rhs)
 {
  return lhs.u*rhs.u + lhs.v*rhs.v;
 }
 
-constexpr PVector operator*(const PVector &lhs, VectorPrecision rhs)
+template <typename S>
+constexpr BasicPVector<S> operator*(const BasicPVector<S> &lhs, typename BasicPVector<S>::Scalar rhs)
 {
  return {lhs.u*rhs, lhs.v*rhs};
 }
 
-constexpr PVector operator*(VectorPrecision lhs, const PVector &rhs)
+template <typename S>
+constexpr BasicPVector<S> operator*(typename BasicPVector<S>::Scalar lhs, const BasicPVector<S> &rhs)
 {
  return rhs * lhs;
 }
 
-constexpr bool operator==(const PVector &lhs, const PVector &rhs)
+template <typename S>
+constexpr bool operator==(const BasicPVector<S> &lhs, const BasicPVector<S> &rhs)
 {
  return (lhs.u == rhs.u) && (lhs.v == rhs.v);
 }
 
-constexpr bool operator!=(const PVector &lhs, const PVector &rhs)
+template <typename S>
+constexpr bool operator!=(const BasicPVector<S> &lhs, const BasicPVector<S> &rhs)
 {
  return (lhs.u != rhs.u) || (lhs.v != rhs.v);
 }
 
-constexpr PVector rotatePVectorAboutOrigin(const PVector &v, VectorPrecision angleRadians)
+template <typename S>
+constexpr BasicPVector<S> rotatePVectorAboutOrigin(const BasicPVector<S> &v, typename BasicPVector<S>::Scalar angleRadians)
 {
- return {VectorPrecision(v.u*cos(angleRadians) - v.v*sin(angleRadians)),
-         VectorPrecision(v.u*sin(angleRadians) + v.v*cos(angleRadians))};
+#ifdef PTVECTORS_FAST_TRIG
+ return PTVECTORS_CONSTANT_EVALUATED() ? BasicPVector<S>{S(v.u*vectorCos(angleRadians) - v.v*vectorSin(angleRadians)),
+                                                         S(v.u*vectorSin(angleRadians) + v.v*vectorCos(angleRadians))}
+        : fastRotatePVectorAboutOrigin(v, angleRadians);
+#else
+ return {S(v.u*vectorCos(angleRadians) - v.v*vectorSin(angleRadians)),
+         S(v.u*vectorSin(angleRadians) + v.v*vectorCos(angleRadians))};
+#endif
 }
 
-constexpr PVector rotatePVectorAboutPoint(const PVector &v, const PVector &point, VectorPrecision angleRadians)
+template <typename S>
+constexpr BasicPVector<S> rotatePVectorAboutPoint(const BasicPVector<S> &v,
+                                                  const BasicPVector<S> &point,
+                                                  typename BasicPVector<S>::Scalar angleRadians)
 {
  return rotatePVectorAboutOrigin(v - point, angleRadians) + point;
 }
 
-constexpr PVector rotatePVectorLeft(const PVector &v)
+template <typename S>
+constexpr BasicPVector<S> rotatePVectorLeft(const BasicPVector<S> &v)
 {
  return {-v.v, v.u};
 }
 
-constexpr PVector rotatePVectorRight(const PVector &v)
+template <typename S>
+constexpr BasicPVector<S> rotatePVectorRight(const BasicPVector<S> &v)
 {
  return {v.v, -v.u};
 }
 
-constexpr VectorPrecision planeVectorAngle(const PVector &v)
+template <typename S>
+constexpr S planeVectorAngle(const BasicPVector<S> &v)
 {
- return atan2(v.v, v.u);
+#ifdef PTVECTORS_FAST_TRIG
+ return PTVECTORS_CONSTANT_EVALUATED() ? S(vectorAtan2(v.v, v.u)) : fastAtan2(v.v, v.u);
+#else
+ return vectorAtan2(v.v, v.u);
+#endif
 }
 
 // Absolute value functions
-constexpr VectorPrecision abs(const PVector &v)
+// abs() uses hypot, so it is overflow-safe but slow. Prefer length() or
+// lengthSquared() below in hot loops.
+template <typename S>
+constexpr S abs(const BasicPVector<S> &v)
+{
+ return vectorHypot(v.u, v.v);
+}
+
+template <typename S>
+constexpr S abs(const BasicTVector<S> &v)
 {
- return hypot(v.u, v.v);
+ return vectorHypot(vectorHypot(v.xEast, v.yNorth), v.zUp);
 }
 
-constexpr VectorPrecision abs(const TVector &v)
+// lengthSquared() needs no sqrt at all, for comparing against a squared distance
+template <typename S>
+constexpr S lengthSquared(const BasicPVector<S> &v)
 {
- return hypot(hypot(v.xEast, v.yNorth), v.zUp);
+ return v*v;
+}
+
+template <typename S>
+constexpr S lengthSquared(const BasicTVector<S> &v)
+{
+ return v*v;
+}
+
+// length() is a single sqrt. Unlike abs() it overflows once the squared
+// components do (beyond ~1e19 in float), so define PTVECTORS_SAFE_LENGTH
+// to make it use hypot like abs()
+template <typename S>
+constexpr S length(const BasicPVector<S> &v)
+{
+#ifdef PTVECTORS_SAFE_LENGTH
+ return abs(v);
+#else
+ return vectorSqrt(lengthSquared(v));
+#endif
+}
+
+template <typename S>
+constexpr S length(const BasicTVector<S> &v)
+{
+#ifdef PTVECTORS_SAFE_LENGTH
+ return abs(v);
+#else
+ return vectorSqrt(lengthSquared(v));
+#endif
+}
+
+// Template operators that work on both types, and on any precision
+
+// v scaled by 1/vLength, leaving zero vectors as they are
+template <typename T>
+constexpr T unitVectorOfLength(const T &v, typename T::Scalar vLength)
+{
+ return (vLength == 0.0) ? v : v * (1.0 / vLength);
 }
 
-// Template operators that work on both types
 template <typename T>
 constexpr T unitVector(const T &v)
 {
- return (abs(v) == 0.0) ? v : v * (1.0 / abs(v));
+ return unitVectorOfLength(v, abs(v));
 }
 
+// normalize() is the fast unitVector(), with one sqrt and one reciprocal
 template <typename T>
-constexpr VectorPrecision angleBetweenVectors(const T &a, const T &b)
+constexpr T normalize(const T &v)
+{
+ return unitVectorOfLength(v, length(v));
+}
+
+// atan2 of the cross and dot products needs no normalisation, and stays
+// accurate for nearly parallel and antiparallel vectors where acos doesn't
+template <typename S>
+constexpr S angleBetweenVectors(const BasicTVector<S> &a, const BasicTVector<S> &b)
+{
+ return vectorAtan2(length(a/b), a*b);
+}
+
+template <typename S>
+constexpr S angleBetweenVectors(const BasicPVector<S> &a, const BasicPVector<S> &b)
 {
- return acos(unitVector(a)*unitVector(b));
+ return vectorAtan2(vectorFabs(a.u*b.v - a.v*b.u), a*b);
 }
 
 template <typename T>
-constexpr T LERP(const T &start, const T &finish, VectorPrecision lerp)
+constexpr T LERP(const T &start, const T &finish, typename T::Scalar lerp)
 {
  return (start*(1.0 - lerp)) + (finish*lerp);
 }
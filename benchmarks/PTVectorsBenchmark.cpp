@@ -0,0 +1,411 @@
+/******************************************************************************
+*
+*     PTVectorsBenchmark.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+// Benchmarks for the scalar operations, the batch kernels and LuaVectorLib.
+//
+// Build from the repository root:
+//  g++ -std=c++11 -O2 -I. -o ptvbench benchmarks/PTVectorsBenchmark.cpp
+//      PTVectors.cpp PTVectorArrays.cpp PTVectorRotation.cpp PTQuaternion.cpp PTMatrix.cpp
+//      PTVectorFrames.cpp PTVectorSpline.cpp PTVectorIntersection.cpp PTVectorPolygon.cpp
+//      PTVectorThreadPool.cpp -pthread
+// add -mavx (or -march=native) to benchmark the AVX kernels, and
+//  -DPTVECTORS_BENCHMARK_LUA LuaVectorLib.cpp -llua5.3
+// to include the LuaVectorLib benchmarks.
+//
+// Usage: ptvbench [filter]
+// Only benchmarks whose group/name contains filter are run. Results are
+// written to stdout as CSV, one line per benchmark:
+//  group,name,n,ns_per_op,mops_per_s
+// where n is the number of vectors per call for the batch and Lua array
+// benchmarks (1 otherwise), and an op is one vector. Each figure is the best
+// of several timed runs of at least 50ms.
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTVectorExpressions.h"
+#include "PTFastTrig.h"
+#include "PTVectorRotation.h"
+#include "PTQuaternion.h"
+#include "PTMatrix.h"
+#include "PTVectorFrames.h"
+#include "PTVectorSpline.h"
+#include "PTVectorIntersection.h"
+#include "PTVectorPolygon.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef PTVECTORS_BENCHMARK_LUA
+#include "LuaVectorLib.h"
+#endif
+
+// Stops the compiler from discarding a result that is otherwise unused
+template <typename T>
+inline void benchmarkKeep(const T &value)
+{
+#if defined(__GNUC__)
+ asm volatile("" : : "r"(&value) : "memory");
+#else
+ static volatile const void *sink;
+ sink = &value;
+#endif
+}
+
+static const char *benchmarkFilter = nullptr;
+
+// f(iterations) performs iterations*opsPerCall ops
+typedef std::function<void(std::size_t)> BenchmarkBody;
+
+static double secondsFor(const BenchmarkBody &f, std::size_t iterations)
+{
+ std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+ f(iterations);
+ std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+ return elapsed.count();
+}
+
+static void benchmark(const char *group, const char *name, std::size_t opsPerCall, const BenchmarkBody &f)
+{
+ std::string fullName = std::string(group) + "/" + name;
+ if (benchmarkFilter && fullName.find(benchmarkFilter) == std::string::npos) return;
+
+ const double minimumTime = 0.05;
+ std::size_t iterations = 1;
+ double seconds = secondsFor(f, iterations);
+ while (seconds < minimumTime / 10)
+ {
+  iterations *= 2;
+  seconds = secondsFor(f, iterations);
+ }
+ iterations = std::size_t(iterations * minimumTime / seconds) + 1;
+
+ double best = 1e30;
+ for (int run = 0; run < 5; ++run)
+ {
+  double t = secondsFor(f, iterations);
+  if (t < best) best = t;
+ }
+ double ns = best * 1e9 / (double(iterations) * opsPerCall);
+ printf("%s,%s,%zu,%.3f,%.3f\n", group, name, opsPerCall, ns, 1e3 / ns);
+ fflush(stdout);
+}
+
+// Inputs cycle through a small table so nothing can be constant folded
+static const std::size_t inputCount = 1024;
+static std::vector<TVector> tInputs, tUnitInputs;
+static std::vector<PVector> pInputs;
+static std::vector<VectorPrecision> scalarInputs;
+
+static VectorPrecision randomScalar()
+{
+ return VectorPrecision(rand()) / RAND_MAX * 200.0 - 100.0;
+}
+
+static TVector randomTVector()
+{
+ return {randomScalar(), randomScalar(), randomScalar()};
+}
+
+static void makeInputs()
+{
+ srand(1);
+ for (std::size_t i = 0; i < inputCount; ++i)
+ {
+  tInputs.push_back(randomTVector());
+  tUnitInputs.push_back(unitVector(randomTVector()));
+  pInputs.push_back({randomScalar(), randomScalar()});
+  scalarInputs.push_back(randomScalar() / 100.0);
+ }
+}
+
+#define SCALAR_BENCHMARK(name, expression) \
+ benchmark("scalar", name, 1, [](std::size_t iterations) \
+ { \
+  for (std::size_t n = 0; n < iterations; ++n) \
+  { \
+   const std::size_t i = n & (inputCount - 1), j = (n + 1) & (inputCount - 1); \
+   (void)i; (void)j; \
+   auto result = expression; \
+   benchmarkKeep(result); \
+  } \
+ })
+
+static void scalarBenchmarks()
+{
+ static const TVectorRotation rotation(unitVector(TVector{1.0, 2.0, 3.0}), 0.5);
+ static const Quaternion q1 = quaternionFromAxisAngle(tUnitInputs[0], 0.5);
+ static const Quaternion q2 = quaternionFromAxisAngle(tUnitInputs[1], 1.5);
+ static const TVectorSLERPPath path(tUnitInputs[0], tUnitInputs[1]);
+
+ SCALAR_BENCHMARK("TVector operator+", tInputs[i] + tInputs[j]);
+ SCALAR_BENCHMARK("TVector operator* dot", tInputs[i] * tInputs[j]);
+ SCALAR_BENCHMARK("TVector operator* scale", tInputs[i] * scalarInputs[j]);
+ SCALAR_BENCHMARK("TVector operator/ cross", tInputs[i] / tInputs[j]);
+ SCALAR_BENCHMARK("TVector abs", abs(tInputs[i]));
+ SCALAR_BENCHMARK("TVector length", length(tInputs[i]));
+ SCALAR_BENCHMARK("TVector lengthSquared", lengthSquared(tInputs[i]));
+ SCALAR_BENCHMARK("TVector unitVector", unitVector(tInputs[i]));
+ SCALAR_BENCHMARK("TVector normalize", normalize(tInputs[i]));
+ SCALAR_BENCHMARK("TVector angleBetweenVectors", angleBetweenVectors(tInputs[i], tInputs[j]));
+ SCALAR_BENCHMARK("rotateTVectorAboutAxis", rotateTVectorAboutAxis(tInputs[i], tUnitInputs[j], scalarInputs[j]));
+ SCALAR_BENCHMARK("TVectorRotation apply", rotation.apply(tInputs[i]));
+ SCALAR_BENCHMARK("TVectorSLERP", TVectorSLERP(tUnitInputs[i], tUnitInputs[j], scalarInputs[j]*0.5 + 0.5));
+ SCALAR_BENCHMARK("TVectorSLERPPath at", path.at(scalarInputs[i]*0.5 + 0.5));
+ SCALAR_BENCHMARK("TVector LERP", LERP(tInputs[i], tInputs[j], scalarInputs[j]));
+ SCALAR_BENCHMARK("calculateUpAndRight", ([i]() { TVector up, right; tUnitInputs[i].calculateUpAndRight(up, right); return up + right; }()));
+ SCALAR_BENCHMARK("PVector operator+", pInputs[i] + pInputs[j]);
+ SCALAR_BENCHMARK("PVector operator* dot", pInputs[i] * pInputs[j]);
+ SCALAR_BENCHMARK("PVector abs", abs(pInputs[i]));
+ SCALAR_BENCHMARK("PVector unitVector", unitVector(pInputs[i]));
+ SCALAR_BENCHMARK("rotatePVectorAboutOrigin", rotatePVectorAboutOrigin(pInputs[i], scalarInputs[j]));
+ SCALAR_BENCHMARK("sin and cos", std::sin(pInputs[i].u) + std::cos(pInputs[i].u));
+ SCALAR_BENCHMARK("fastSinCos", ([i]() { VectorPrecision s, c; fastSinCos(pInputs[i].u, s, c); return s + c; }()));
+ SCALAR_BENCHMARK("atan2", std::atan2(pInputs[i].v, pInputs[i].u));
+ SCALAR_BENCHMARK("fastAtan2", fastAtan2(pInputs[i].v, pInputs[i].u));
+ SCALAR_BENCHMARK("Quaternion operator* compose", q1 * quaternionFromAxisAngle(tUnitInputs[i], scalarInputs[j]));
+ SCALAR_BENCHMARK("rotateTVectorByQuaternion", rotateTVectorByQuaternion(tInputs[i], q1));
+ SCALAR_BENCHMARK("quaternionSLERP", quaternionSLERP(q1, q2, scalarInputs[i]*0.5 + 0.5));
+}
+
+// The batch kernels at a size that stays in L1 and one that streams from memory
+static void batchBenchmarks(std::size_t n)
+{
+ TVectorArray a(n), b(n), c(n), result;
+ PVectorArray pa(n), pb(n), pResult;
+ ScalarArray scalars, t(n);
+ for (std::size_t i = 0; i < n; ++i)
+ {
+  a.set(i, tInputs[i & (inputCount - 1)]);
+  b.set(i, tInputs[(i + 1) & (inputCount - 1)]);
+  c.set(i, tInputs[(i + 2) & (inputCount - 1)]);
+  pa.set(i, pInputs[i & (inputCount - 1)]);
+  pb.set(i, pInputs[(i + 1) & (inputCount - 1)]);
+  t[i] = VectorPrecision(i) / n;
+ }
+ const TVectorRotation rotation(unitVector(TVector{1.0, 2.0, 3.0}), 0.5);
+ const Quaternion q = quaternionFromAxisAngle(unitVector(TVector{3.0, 2.0, 1.0}), 0.5);
+ const TVectorSLERPPath path(tUnitInputs[0], tUnitInputs[1]);
+ const AffineTransform chain = translationTransform(tInputs[0])*rotationToAffine(q)*rotationToAffine(rotation);
+ std::vector<TVector> aos(n), aosResult(n);
+ TVectorArray frameUp, frameRight;
+ std::vector<Matrix3> frames;
+ a.copyTo(aos.data());
+ const TVectorSpline spline(TVectorArray(tInputs.data(), 16), SplineType::centripetalCatmullRom);
+ const Ray ray = {tInputs[0], tInputs[1] - tInputs[0]};
+ const BoundingSphere sphere = {tInputs[2], 0.5};
+ const Box box = {{-0.5, -0.5, -0.5}, {0.5, 0.5, 0.5}};
+ // an eight pointed star, and a wavy circle with 1024 edges
+ PVectorArray star(16), wavy(1024);
+ for (std::size_t i = 0; i < star.size(); ++i)
+ {
+  const VectorPrecision angle = 2.0*M_PI*i/star.size(), radius = (i & 1) ? 0.5 : 1.0;
+  star.set(i, {radius*std::cos(angle), radius*std::sin(angle)});
+ }
+ for (std::size_t i = 0; i < wavy.size(); ++i)
+ {
+  const VectorPrecision angle = 2.0*M_PI*i/wavy.size(), radius = 0.8 + 0.2*std::sin(32.0*angle);
+  wavy.set(i, {radius*std::cos(angle), radius*std::sin(angle)});
+ }
+ const PolygonEdgeIndex wavyIndex(wavy);
+ std::vector<std::uint8_t> inside;
+
+#define BATCH_BENCHMARK(name, statement) \
+ benchmark("batch", name, n, [&](std::size_t iterations) \
+ { \
+  for (std::size_t k = 0; k < iterations; ++k) \
+  { \
+   statement; \
+   benchmarkKeep(k); \
+  } \
+ })
+
+ BATCH_BENCHMARK("addVectorArrays", addVectorArrays(a, b, result));
+ BATCH_BENCHMARK("scaleVectorArray", scaleVectorArray(a, VectorPrecision(1.5), result));
+ BATCH_BENCHMARK("dotVectorArrays", dotVectorArrays(a, b, scalars));
+ BATCH_BENCHMARK("crossVectorArrays", crossVectorArrays(a, b, result));
+ BATCH_BENCHMARK("lengthVectorArray", lengthVectorArray(a, scalars));
+ BATCH_BENCHMARK("normalizeVectorArray", normalizeVectorArray(a, result));
+ BATCH_BENCHMARK("angleBetweenVectorArrays", angleBetweenVectorArrays(a, b, scalars));
+ BATCH_BENCHMARK("lerpVectorArrays", lerpVectorArrays(a, b, VectorPrecision(0.25), result));
+ BATCH_BENCHMARK("a*s + b - a kernels", scaleVectorArray(a, VectorPrecision(1.5), result); addVectorArrays(result, b, result); subtractVectorArrays(result, a, result));
+ BATCH_BENCHMARK("a*s + b - a expression", result = a*VectorPrecision(1.5) + b - a);
+ BATCH_BENCHMARK("boundsVectorArray", TVector min; TVector max; boundsVectorArray(a, min, max); benchmarkKeep(max));
+ BATCH_BENCHMARK("centroidVectorArray", TVector c = centroidVectorArray(a); benchmarkKeep(c));
+ BATCH_BENCHMARK("TVectorRotation apply SoA", rotation.apply(a, result));
+ BATCH_BENCHMARK("TVectorRotation apply AoS", rotation.apply(aos.data(), aosResult.data(), n));
+ BATCH_BENCHMARK("rotateTVectorArrayByQuaternion", rotateTVectorArrayByQuaternion(a, q, result));
+ BATCH_BENCHMARK("frame chain kernels", rotation.apply(a, result); rotateTVectorArrayByQuaternion(result, q, result); addVectorArrays(result, tInputs[0], result));
+ BATCH_BENCHMARK("frame chain transformVectorArray", transformVectorArray(chain, a, result));
+ BATCH_BENCHMARK("calculateFrameArrays", calculateFrameArrays(a, result, frameUp, frameRight));
+ BATCH_BENCHMARK("calculateFrameMatrices", calculateFrameMatrices(a, frames));
+ BATCH_BENCHMARK("slerpVectorArray samples", slerpVectorArray(path, n, result));
+ BATCH_BENCHMARK("slerpVectorArray t", slerpVectorArray(path, t, result));
+ BATCH_BENCHMARK("TVectorSpline sample", spline.sample(n, result, frameUp));
+ BATCH_BENCHMARK("TVectorSpline sampleByDistance", spline.sampleByDistance(n, result, frameUp));
+ BATCH_BENCHMARK("intersectRaysSphere", intersectRaysSphere(a, b, sphere, scalars));
+ BATCH_BENCHMARK("intersectRaysBox", intersectRaysBox(a, b, box, scalars));
+ BATCH_BENCHMARK("intersectRayTriangles", intersectRayTriangles(ray, a, b, c, scalars));
+ BATCH_BENCHMARK("intersectSegments", intersectSegments(pInputs[0], pInputs[1], pa, pb, scalars));
+ BATCH_BENCHMARK("pointsInPolygon star", pointsInPolygon(star, pa, inside));
+ BATCH_BENCHMARK("pointsInPolygon 1024 edges", pointsInPolygon(wavy, pa, inside));
+ BATCH_BENCHMARK("PolygonEdgeIndex contains 1024 edges", wavyIndex.contains(pa, inside));
+ BATCH_BENCHMARK("addVectorArrays PVector", addVectorArrays(pa, pb, pResult));
+ BATCH_BENCHMARK("normalizeVectorArray PVector", normalizeVectorArray(pa, pResult));
+ BATCH_BENCHMARK("fastSinCosArray", fastSinCosArray(pa.u, pResult.u, pResult.v));
+ BATCH_BENCHMARK("fastRotatePVectorArray", fastRotatePVectorArray(pa, pb.u, pResult));
+ BATCH_BENCHMARK("fastPlaneVectorAngleArray", fastPlaneVectorAngleArray(pa, scalars));
+ // the scalar loops the kernels replace, for comparison
+ BATCH_BENCHMARK("reference normalize loop", for (std::size_t i = 0; i < n; ++i) aosResult[i] = unitVector(aos[i]));
+ BATCH_BENCHMARK("reference rotateTVectorAboutAxis loop",
+  const TVector axis = unitVector(TVector{1.0, 2.0, 3.0});
+  for (std::size_t i = 0; i < n; ++i) aosResult[i] = rotateTVectorAboutAxis(aos[i], axis, VectorPrecision(0.5)));
+ BATCH_BENCHMARK("reference calculateUpAndRight loop",
+  TVector up;
+  TVector right;
+  for (std::size_t i = 0; i < n; ++i) { aos[i].calculateUpAndRight(up, right); aosResult[i] = up + right; });
+ BATCH_BENCHMARK("reference rotatePVectorAboutOrigin loop",
+  pResult.resize(n);
+  for (std::size_t i = 0; i < n; ++i) pResult.set(i, rotatePVectorAboutOrigin(pa[i], pb.u[i])));
+ BATCH_BENCHMARK("reference planeVectorAngle loop",
+  scalars.resize(n);
+  for (std::size_t i = 0; i < n; ++i) scalars[i] = planeVectorAngle(pa[i]));
+ BATCH_BENCHMARK("reference spline at and tangent loop",
+  for (std::size_t i = 0; i < n; ++i) aosResult[i] = spline.at(t[i]) + spline.tangent(t[i]));
+ BATCH_BENCHMARK("reference intersectRayTriangle loop",
+  scalars.resize(n);
+  for (std::size_t i = 0; i < n; ++i) { VectorPrecision hit = 0.0; intersectRayTriangle(ray, a[i], b[i], c[i], hit); scalars[i] = hit; });
+ BATCH_BENCHMARK("reference pointInPolygon star loop",
+  inside.resize(n);
+  for (std::size_t i = 0; i < n; ++i) inside[i] = pointInPolygon(star, pa[i]));
+
+#undef BATCH_BENCHMARK
+}
+
+#ifdef PTVECTORS_BENCHMARK_LUA
+
+// Each script returns a function taking the number of iterations to run.
+// opsPerCall is the number of vectors each iteration handles.
+struct LuaBenchmark
+{
+ const char *name;
+ std::size_t opsPerCall;
+ const char *script;
+};
+
+#define LUA_LOOP(setup, body) \
+ "local a, b, p, q = vector.new(1, 2, 3), vector.new(3, 2, 1), vector.new(1, 2), vector.new(2, 1)\n" \
+ "local axis = vector.new(0, 0, 1)\n" \
+ setup "\n" \
+ "return function(n) local r for i = 1, n do " body " end return r end\n"
+
+static const LuaBenchmark luaBenchmarks[] =
+{
+ {"navvector __add", 1, LUA_LOOP("", "r = a + b")},
+ {"navvector __sub", 1, LUA_LOOP("", "r = a - b")},
+ {"navvector __mul dot", 1, LUA_LOOP("", "r = a * b")},
+ {"navvector __mul scale", 1, LUA_LOOP("", "r = a * 2")},
+ {"navvector __mul number first", 1, LUA_LOOP("", "r = 2 * a")},
+ {"navvector __mod cross", 1, LUA_LOOP("", "r = a % b")},
+ {"navvector __unm", 1, LUA_LOOP("", "r = -a")},
+ {"navvector __len", 1, LUA_LOOP("", "r = #a")},
+ {"navvector __bnot unit", 1, LUA_LOOP("", "r = ~a")},
+ {"navvector __tostring", 1, LUA_LOOP("", "r = tostring(a)")},
+ {"navvector rotate", 1, LUA_LOOP("", "r = a:rotate(axis, 0.5)")},
+ {"navvector lerp", 1, LUA_LOOP("", "r = a:lerp(b, 0.5)")},
+ {"navvector slerp", 1, LUA_LOOP("local u, w = a:unit(), b:unit()", "r = u:slerp(w, 0.5)")},
+ {"navvector upAndRight", 1, LUA_LOOP("", "r = a:upAndRight()")},
+ {"navvector x", 1, LUA_LOOP("", "r = a:x()")},
+ {"navvector add dst", 1, LUA_LOOP("local d = vector.new(0, 0, 0)", "r = a:add(b, d)")},
+ {"navvector addInPlace", 1, LUA_LOOP("local d = vector.new(0, 0, 0)", "r = d:addInPlace(b)")},
+ {"navvector chained in place", 1, LUA_LOOP("local d = vector.new(0, 0, 0)", "r = d:copyFrom(a):subInPlace(b):unitInPlace()")},
+ {"planevector __add", 1, LUA_LOOP("", "r = p + q")},
+ {"planevector __sub", 1, LUA_LOOP("", "r = p - q")},
+ {"planevector __mul dot", 1, LUA_LOOP("", "r = p * q")},
+ {"planevector __mul scale", 1, LUA_LOOP("", "r = p * 2")},
+ {"planevector __unm", 1, LUA_LOOP("", "r = -p")},
+ {"planevector __len", 1, LUA_LOOP("", "r = #p")},
+ {"planevector __bnot unit", 1, LUA_LOOP("", "r = ~p")},
+ {"planevector rotate", 1, LUA_LOOP("", "r = p:rotate(0.5)")},
+ {"planevector conj", 1, LUA_LOOP("", "r = p:conj()")},
+ {"vector.new navvector", 1, LUA_LOOP("", "r = vector.new(1, 2, 3)")},
+ {"array rotate", 100000, LUA_LOOP("local arr = vector.array(100000, a)", "r = arr:rotate(axis, 0.5, arr)")},
+ {"array normalize", 100000, LUA_LOOP("local arr = vector.array(100000, a)", "r = arr:normalize(arr)")},
+ {"array centroid", 100000, LUA_LOOP("local arr = vector.array(100000, a)", "r = arr:centroid()")},
+ {"per-vector rotate loop", 100000, LUA_LOOP("local t = {} for i = 1, 100000 do t[i] = a end",
+  "for k = 1, #t do t[k] = t[k]:rotate(axis, 0.5) end")},
+};
+
+#undef LUA_LOOP
+
+static void luaBenchmarkSuite()
+{
+ lua_State *L = luaL_newstate();
+ luaL_openlibs(L);
+ openLuaVectorLibrary(L);
+
+ for (const LuaBenchmark &b : luaBenchmarks)
+ {
+  if (luaL_dostring(L, b.script))
+  {
+   fprintf(stderr, "%s: %s\n", b.name, lua_tostring(L, -1));
+   lua_pop(L, 1);
+   continue;
+  }
+  int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  benchmark("lua", b.name, b.opsPerCall, [L, ref](std::size_t iterations)
+  {
+   lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+   lua_pushinteger(L, iterations);
+   if (lua_pcall(L, 1, 0, 0))
+   {
+    fprintf(stderr, "%s\n", lua_tostring(L, -1));
+    lua_pop(L, 1);
+   }
+  });
+  luaL_unref(L, LUA_REGISTRYINDEX, ref);
+  lua_gc(L, LUA_GCCOLLECT, 0);
+ }
+ lua_close(L);
+}
+
+#endif // PTVECTORS_BENCHMARK_LUA
+
+int main(int argc, char **argv)
+{
+ if (argc > 1) benchmarkFilter = argv[1];
+ makeInputs();
+
+ printf("group,name,n,ns_per_op,mops_per_s\n");
+ scalarBenchmarks();
+ batchBenchmarks(1024);
+ batchBenchmarks(1 << 20);
+#ifdef PTVECTORS_BENCHMARK_LUA
+ luaBenchmarkSuite();
+#endif
+ return 0;
+}
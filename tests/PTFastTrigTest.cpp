@@ -0,0 +1,233 @@
+/******************************************************************************
+*
+*     PTFastTrigTest.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+// Checks PTFastTrig.h and the fast batch kernels in PTVectorArrays.h against
+// libm, to the error bounds documented in PTFastTrig.h.
+//
+// Build and run from the repository root:
+//  g++ -std=c++11 -O2 -I. -o fasttrigtest tests/PTFastTrigTest.cpp
+//      PTVectors.cpp PTVectorArrays.cpp
+//  ./fasttrigtest
+// and again with -mavx (or -march=native) to check the AVX kernels. It prints
+// the largest error found for each function and exits with 1 if any is
+// outside its bound.
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include "PTFastTrig.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static int failures = 0;
+
+static void check(const char *type, const char *name, double maxError, double bound)
+{
+ const bool ok = maxError <= bound;
+ printf("%s %-8s %-30s max error %.3g, bound %.3g\n", ok ? "ok  " : "FAIL", type, name, maxError, bound);
+ if (!ok) ++failures;
+}
+
+static double error(double a, double b)
+{
+ return std::isnan(a) ? 1e30 : std::fabs(a - b);
+}
+
+template <typename S>
+struct Bounds;
+
+template <>
+struct Bounds<float>
+{
+ static const char *name() { return "float"; }
+ static double sinCos() { return 1.2e-7; }
+ static double atan2() { return 6e-7; }
+};
+
+template <>
+struct Bounds<double>
+{
+ static const char *name() { return "double"; }
+ static double sinCos() { return 3e-9; }
+ static double atan2() { return 2.5e-7; }
+};
+
+// Angles across |x| <= 1e4, with a dense run about zero, and an odd count so
+// the batch kernels have a scalar tail
+template <typename S>
+static BasicScalarArray<S> testAngles()
+{
+ BasicScalarArray<S> angles;
+ for (int i = -20000; i <= 20000; ++i) angles.push_back(S(i*0.5e-3));
+ for (int i = 0; i < 200001; ++i) angles.push_back(S((double(rand())/RAND_MAX*2.0 - 1.0)*1e4));
+ return angles;
+}
+
+// Points in every octant, on the axes and at very different scales. atan2(-0, x)
+// is left out, as fastAtan2 gives +pi for x < 0.
+template <typename S>
+static BasicPVectorArray<S> testPoints()
+{
+ BasicPVectorArray<S> points;
+ const S axes[] = {S(0), S(1), S(-1), S(1e-30), S(-1e-30), S(1e30), S(-1e30)};
+ for (S u : axes)
+ {
+  for (S v : axes) points.push_back({u, v});
+ }
+ for (int i = 0; i < 200001; ++i)
+ {
+  const double scale = std::pow(10.0, double(rand())/RAND_MAX*8.0 - 4.0);
+  points.push_back({S((double(rand())/RAND_MAX*2.0 - 1.0)*scale), S((double(rand())/RAND_MAX*2.0 - 1.0)*scale)});
+ }
+ return points;
+}
+
+template <typename S>
+static void testScalar(const BasicScalarArray<S> &angles, const BasicPVectorArray<S> &points)
+{
+ double sinError = 0.0, cosError = 0.0, sinCosError = 0.0, atan2Error = 0.0;
+ for (std::size_t i = 0; i < angles.size(); ++i)
+ {
+  const S x = angles[i];
+  S s, c;
+  fastSinCos(x, s, c);
+  sinError = std::max(sinError, error(fastSin(x), std::sin(x)));
+  cosError = std::max(cosError, error(fastCos(x), std::cos(x)));
+  sinCosError = std::max(sinCosError, std::max(error(s, std::sin(x)), error(c, std::cos(x))));
+ }
+ for (std::size_t i = 0; i < points.size(); ++i)
+  atan2Error = std::max(atan2Error, error(fastAtan2(points.v[i], points.u[i]), std::atan2(points.v[i], points.u[i])));
+
+ check(Bounds<S>::name(), "fastSin", sinError, Bounds<S>::sinCos());
+ check(Bounds<S>::name(), "fastCos", cosError, Bounds<S>::sinCos());
+ check(Bounds<S>::name(), "fastSinCos", sinCosError, Bounds<S>::sinCos());
+ check(Bounds<S>::name(), "fastAtan2", atan2Error, Bounds<S>::atan2());
+}
+
+template <typename S>
+static void testSIMD(const BasicScalarArray<S> &angles, const BasicPVectorArray<S> &points)
+{
+ typedef SIMDPack<S> Pack;
+ double sinCosError = 0.0, atan2Error = 0.0;
+ S sines[Pack::width], cosines[Pack::width], results[Pack::width];
+ for (std::size_t i = 0; i + Pack::width <= angles.size(); i += Pack::width)
+ {
+  Pack s, c;
+  simdFastSinCos(Pack::load(&angles[i]), s, c);
+  s.store(sines);
+  c.store(cosines);
+  for (std::size_t j = 0; j < Pack::width; ++j)
+  {
+   sinCosError = std::max(sinCosError, error(sines[j], std::sin(angles[i + j])));
+   sinCosError = std::max(sinCosError, error(cosines[j], std::cos(angles[i + j])));
+  }
+ }
+ for (std::size_t i = 0; i + Pack::width <= points.size(); i += Pack::width)
+ {
+  simdFastAtan2(Pack::load(&points.v[i]), Pack::load(&points.u[i])).store(results);
+  for (std::size_t j = 0; j < Pack::width; ++j)
+   atan2Error = std::max(atan2Error, error(results[j], std::atan2(points.v[i + j], points.u[i + j])));
+ }
+
+ check(Bounds<S>::name(), "simdFastSinCos", sinCosError, Bounds<S>::sinCos());
+ check(Bounds<S>::name(), "simdFastAtan2", atan2Error, Bounds<S>::atan2());
+}
+
+// Rotations are checked against libm's sin and cos, allowing the angle error
+// scaled by the vector plus rounding of the products
+template <typename S>
+static void testBatch(const BasicScalarArray<S> &angles, const BasicPVectorArray<S> &points)
+{
+ const double epsilon = std::numeric_limits<S>::epsilon();
+ BasicScalarArray<S> sines, cosines, atans;
+ BasicPVectorArray<S> units, vectors(angles.size()), rotated, rotatedByOne;
+ for (std::size_t i = 0; i < angles.size(); ++i) vectors.set(i, {S(std::cos(i*0.1)*3.0), S(std::sin(i*0.1)*3.0)});
+ const S angle = S(2.5);
+
+ fastSinCosArray(angles, sines, cosines);
+ fastUnitVectorsAtAngles(angles, units);
+ fastRotatePVectorArray(vectors, angles, rotated);
+ fastRotatePVectorArray(vectors, angle, rotatedByOne);
+ fastAtan2Array(points.v, points.u, atans);
+ BasicScalarArray<S> planeAngles;
+ fastPlaneVectorAngleArray(points, planeAngles);
+
+ double sinCosError = 0.0, unitError = 0.0, rotateError = 0.0, rotateOneError = 0.0, rotateBound = 0.0, atan2Error = 0.0, angleError = 0.0;
+ for (std::size_t i = 0; i < angles.size(); ++i)
+ {
+  const double s = std::sin(angles[i]), c = std::cos(angles[i]);
+  sinCosError = std::max(sinCosError, std::max(error(sines[i], s), error(cosines[i], c)));
+  unitError = std::max(unitError, std::max(error(units.u[i], c), error(units.v[i], s)));
+  const double u = vectors.u[i], v = vectors.v[i];
+  rotateError = std::max(rotateError, std::max(error(rotated.u[i], u*c - v*s), error(rotated.v[i], u*s + v*c)));
+  const double s1 = std::sin(angle), c1 = std::cos(angle);
+  rotateOneError = std::max(rotateOneError, std::max(error(rotatedByOne.u[i], u*c1 - v*s1), error(rotatedByOne.v[i], u*s1 + v*c1)));
+  rotateBound = std::max(rotateBound, (std::fabs(u) + std::fabs(v))*(Bounds<S>::sinCos() + 2.0*epsilon));
+ }
+ for (std::size_t i = 0; i < points.size(); ++i)
+ {
+  const double exact = std::atan2(points.v[i], points.u[i]);
+  atan2Error = std::max(atan2Error, error(atans[i], exact));
+  angleError = std::max(angleError, error(planeAngles[i], exact));
+ }
+
+ check(Bounds<S>::name(), "fastSinCosArray", sinCosError, Bounds<S>::sinCos());
+ check(Bounds<S>::name(), "fastUnitVectorsAtAngles", unitError, Bounds<S>::sinCos());
+ check(Bounds<S>::name(), "fastRotatePVectorArray", rotateError, rotateBound);
+ check(Bounds<S>::name(), "fastRotatePVectorArray angle", rotateOneError, rotateBound);
+ check(Bounds<S>::name(), "fastAtan2Array", atan2Error, Bounds<S>::atan2());
+ check(Bounds<S>::name(), "fastPlaneVectorAngleArray", angleError, Bounds<S>::atan2());
+
+ // the batch kernels give the same results as the scalar functions
+ double difference = 0.0;
+ for (std::size_t i = 0; i < angles.size(); ++i)
+ {
+  S s, c;
+  fastSinCos(angles[i], s, c);
+  difference = std::max(difference, std::max(error(sines[i], s), error(cosines[i], c)));
+ }
+ for (std::size_t i = 0; i < points.size(); ++i)
+  difference = std::max(difference, error(atans[i], fastAtan2(points.v[i], points.u[i])));
+ check(Bounds<S>::name(), "batch against scalar", difference, 0.0);
+}
+
+template <typename S>
+static void testPrecision()
+{
+ srand(1);
+ const BasicScalarArray<S> angles = testAngles<S>();
+ const BasicPVectorArray<S> points = testPoints<S>();
+ testScalar(angles, points);
+ testSIMD(angles, points);
+ testBatch(angles, points);
+}
+
+int main()
+{
+ testPrecision<float>();
+ testPrecision<double>();
+ if (failures) printf("%d failed\n", failures);
+ return failures ? 1 : 0;
+}
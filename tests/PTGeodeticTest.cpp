@@ -0,0 +1,137 @@
+/******************************************************************************
+*
+*     PTGeodeticTest.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+// Round trips geodetic positions through ECEF and back, scalar and batch,
+// including both poles and points a few millimetres from the polar axis.
+//
+// Build and run from the repository root:
+//  g++ -std=c++11 -O2 -I. -o geodetictest tests/PTGeodeticTest.cpp
+//      PTGeodetic.cpp PTVectors.cpp PTMatrix.cpp PTVectorThreadPool.cpp -pthread
+//  ./geodetictest
+// It prints the largest errors found and exits with 1 if any is outside the
+// bounds documented in PTGeodetic.h.
+
+#include "PTGeodetic.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static int failures = 0;
+
+static void check(const char *name, double maxError, double bound)
+{
+ const bool ok = maxError <= bound;
+ printf("%s %-40s max error %.3g, bound %.3g\n", ok ? "ok  " : "FAIL", name, maxError, bound);
+ if (!ok) ++failures;
+}
+
+static double error(double a, double b)
+{
+ return std::isnan(a) ? 1e30 : std::fabs(a - b);
+}
+
+// Longitude is meaningless on the axis, so it is compared through the
+// horizontal distance it would move the point
+static double longitudeError(const GeodeticPosition &a, const GeodeticPosition &b)
+{
+ if (std::isnan(a.longitude)) return 1e30;
+ const double d = std::remainder(a.longitude - b.longitude, 2.0*M_PI);
+ return std::fabs(d*std::cos(b.latitude)*wgs84Ellipsoid.semiMajorAxis);
+}
+
+int main()
+{
+ const double halfPi = M_PI/2.0;
+ const double latitudes[] = {halfPi, -halfPi, halfPi - 1e-9, -(halfPi - 1e-9), halfPi - 1e-12, halfPi - 1e-6, 1.2, 0.7, 0.0, -0.3, -1.4};
+ const double longitudes[] = {0.0, 1.0, -2.5, M_PI};
+ const double altitudes[] = {-1e4, -100.0, 0.0, 1.0, 1e3, 1e5, 4e7};
+
+ GeodeticArray positions;
+ for (double latitude : latitudes)
+ {
+  for (double longitude : longitudes)
+  {
+   for (double altitude : altitudes)
+   {
+    positions.resize(positions.size() + 1);
+    positions.set(positions.size() - 1, {latitude, longitude, altitude});
+   }
+  }
+ }
+ srand(1);
+ for (int i = 0; i < 100000; ++i)
+ {
+  const double latitude = (double(rand())/RAND_MAX*2.0 - 1.0)*halfPi;
+  const double longitude = (double(rand())/RAND_MAX*2.0 - 1.0)*M_PI;
+  const double altitude = double(rand())/RAND_MAX*2e5 - 1e4;
+  positions.resize(positions.size() + 1);
+  positions.set(positions.size() - 1, {latitude, longitude, altitude});
+ }
+
+ // scalar round trip
+ double latitudeMax = 0.0, longitudeMax = 0.0, altitudeMax = 0.0;
+ for (std::size_t i = 0; i < positions.size(); ++i)
+ {
+  const GeodeticPosition back = ecefToGeodetic(geodeticToECEF(positions[i]));
+  latitudeMax = std::max(latitudeMax, error(back.latitude, positions[i].latitude));
+  longitudeMax = std::max(longitudeMax, longitudeError(back, positions[i]));
+  altitudeMax = std::max(altitudeMax, error(back.altitude, positions[i].altitude));
+ }
+ check("round trip latitude (rad)", latitudeMax, 1e-15);
+ check("round trip longitude (m)", longitudeMax, 1e-7);
+ check("round trip altitude (m)", altitudeMax, 1e-7);
+
+ // batch round trip, spread over a pool
+ VectorThreadPool pool(4);
+ TVectorArrayD ecef;
+ GeodeticArray back;
+ geodeticToECEF(positions, ecef, &pool);
+ ecefToGeodetic(ecef, back, &pool);
+ latitudeMax = longitudeMax = altitudeMax = 0.0;
+ for (std::size_t i = 0; i < positions.size(); ++i)
+ {
+  latitudeMax = std::max(latitudeMax, error(back.latitude[i], positions[i].latitude));
+  longitudeMax = std::max(longitudeMax, longitudeError(back[i], positions[i]));
+  altitudeMax = std::max(altitudeMax, error(back.altitude[i], positions[i].altitude));
+ }
+ check("batch round trip latitude (rad)", latitudeMax, 1e-15);
+ check("batch round trip longitude (m)", longitudeMax, 1e-7);
+ check("batch round trip altitude (m)", altitudeMax, 1e-7);
+
+ // points exactly on the polar axis
+ const double b = wgs84Ellipsoid.semiMajorAxis*(1.0 - wgs84Ellipsoid.flattening);
+ double axisLatitude = 0.0, axisAltitude = 0.0;
+ for (double z : {b, -b, b + 1.0, -(b + 1.0), b + 1e5, -(b + 1e5), b - 1e3, 2e7})
+ {
+  const GeodeticPosition p = ecefToGeodetic(TVectorD{0.0, 0.0, z});
+  axisLatitude = std::max(axisLatitude, error(p.latitude, std::copysign(halfPi, z)));
+  axisAltitude = std::max(axisAltitude, error(p.altitude, std::fabs(z) - b));
+ }
+ check("polar axis latitude (rad)", axisLatitude, 1e-15);
+ check("polar axis altitude (m)", axisAltitude, 1e-7);
+
+ if (failures) printf("%d failed\n", failures);
+ return failures ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+/******************************************************************************
+*
+*     PTVectorArraysTest.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+// Checks the batch kernels in PTVectorArrays.h against the scalar operators
+// they replace, to the tolerances documented there, for float and double and
+// for vectors from subnormal to near overflow.
+//
+// Build and run from the repository root:
+//  g++ -std=c++11 -O2 -I. -o arraystest tests/PTVectorArraysTest.cpp
+//      PTVectors.cpp PTVectorArrays.cpp
+//  ./arraystest
+// and again with -mavx (or -march=native) to check the AVX kernels. It prints
+// the largest difference found for each kernel and exits with 1 if any is
+// outside its tolerance.
+
+#include "PTVectors.h"
+#include "PTVectorArrays.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+static int failures = 0;
+
+static void check(const char *type, const char *name, double maxError, double bound)
+{
+ const bool ok = maxError <= bound;
+ printf("%s %-8s %-36s max difference %.3g, tolerance %.3g\n", ok ? "ok  " : "FAIL", type, name, maxError, bound);
+ if (!ok) ++failures;
+}
+
+// 0 if a and b are the same value, NaN matching NaN, otherwise 1
+template <typename S>
+static double differs(S a, S b)
+{
+ return (a == b || (std::isnan(a) && std::isnan(b))) ? 0.0 : 1.0;
+}
+
+static double error(double a, double b)
+{
+ return std::isnan(a) ? 1e30 : std::fabs(a - b);
+}
+
+template <typename S>
+static S component(const BasicTVector<S> &v, int k)
+{
+ return (k == 0) ? v.xEast : ((k == 1) ? v.yNorth : v.zUp);
+}
+
+template <typename S>
+static S component(const BasicPVector<S> &v, int k)
+{
+ return (k == 0) ? v.u : v.v;
+}
+
+template <typename S>
+static int componentCount(const BasicTVector<S> &)
+{
+ return 3;
+}
+
+template <typename S>
+static int componentCount(const BasicPVector<S> &)
+{
+ return 2;
+}
+
+template <typename S>
+static const char *typeName()
+{
+ return (sizeof(S) == sizeof(float)) ? "float" : "double";
+}
+
+template <typename S>
+static S randomComponent()
+{
+ return S(double(rand())/RAND_MAX*200.0 - 100.0);
+}
+
+// Vectors of ordinary size, an odd number so the kernels have a scalar tail
+template <typename S>
+static BasicTVectorArray<S> ordinaryVectors()
+{
+ BasicTVectorArray<S> a;
+ for (int i = 0; i < 1003; ++i) a.push_back({randomComponent<S>(), randomComponent<S>(), randomComponent<S>()});
+ return a;
+}
+
+// Vectors at every magnitude the type can hold, including subnormal
+// components, components of very different sizes and zero vectors, spread
+// so that each lands both in a pack and in the tail
+template <typename S>
+static BasicTVectorArray<S> extremeVectors()
+{
+ const S largest = std::numeric_limits<S>::max(), smallest = std::numeric_limits<S>::denorm_min();
+ const double maxExponent = std::log10(double(largest)) - 1.0, minExponent = std::log10(double(std::numeric_limits<S>::min())) - 2.0;
+ BasicTVectorArray<S> a;
+ for (double e = minExponent; e <= maxExponent; e += 1.0)
+ {
+  const S m = S(std::pow(10.0, e));
+  a.push_back({m*(randomComponent<S>()/S(100)), m*(randomComponent<S>()/S(100)), m*(randomComponent<S>()/S(100))});
+  a.push_back({m, m, S(0)});
+  a.push_back({-m, S(0), m});
+  a.push_back({m, S(1), S(0)});
+ }
+ a.push_back({smallest, S(0), S(0)});
+ a.push_back({smallest, smallest, smallest});
+ a.push_back({largest/S(4), largest/S(4), S(0)});
+ a.push_back({S(0), S(0), S(0)});
+ const std::size_t n = a.size();
+ for (std::size_t i = 0; i < n; ++i) a.push_back(a[n - 1 - i]);
+ a.push_back({S(0), S(0), S(0)});
+ return a;
+}
+
+template <typename S>
+static BasicPVectorArray<S> planeVectors(const BasicTVectorArray<S> &a)
+{
+ BasicPVectorArray<S> p;
+ for (std::size_t i = 0; i < a.size(); ++i) p.push_back({a.xEast[i], a.yNorth[i]});
+ return p;
+}
+
+// The kernels documented as bit-identical, on any input
+template <typename S, typename Array>
+static void testExact(const Array &a, const Array &b, const char *set)
+{
+ typedef typename std::decay<decltype(a[0])>::type Vector;
+ const S s = S(0.75);
+ const Vector single = b[b.size()/2];
+ Array sum, sumSingle, difference, scaled, lerped;
+ BasicScalarArray<S> lengthsSquared;
+ addVectorArrays(a, b, sum);
+ addVectorArrays(a, single, sumSingle);
+ subtractVectorArrays(a, b, difference);
+ scaleVectorArray(a, s, scaled);
+ lerpVectorArrays(a, b, S(0.25), lerped);
+ lengthSquaredVectorArray(a, lengthsSquared);
+
+ double add = 0.0, sub = 0.0, scale = 0.0, lerp = 0.0, lengthSquaredError = 0.0;
+ for (std::size_t i = 0; i < a.size(); ++i)
+ {
+  const Vector expectSum = a[i] + b[i], expectSingle = a[i] + single, expectDifference = a[i] - b[i], expectScaled = a[i]*s, expectLerp = LERP(a[i], b[i], S(0.25));
+  for (int k = 0; k < componentCount(Vector()); ++k)
+  {
+   add = std::max(add, differs(component(sum[i], k), component(expectSum, k)) + differs(component(sumSingle[i], k), component(expectSingle, k)));
+   sub = std::max(sub, differs(component(difference[i], k), component(expectDifference, k)));
+   scale = std::max(scale, differs(component(scaled[i], k), component(expectScaled, k)));
+   lerp = std::max(lerp, differs(component(lerped[i], k), component(expectLerp, k)));
+  }
+  lengthSquaredError = std::max(lengthSquaredError, differs(lengthsSquared[i], lengthSquared(a[i])));
+ }
+ char name[64];
+ snprintf(name, sizeof(name), "add %s", set);
+ check(typeName<S>(), name, add, 0.0);
+ snprintf(name, sizeof(name), "subtract %s", set);
+ check(typeName<S>(), name, sub, 0.0);
+ snprintf(name, sizeof(name), "scale %s", set);
+ check(typeName<S>(), name, scale, 0.0);
+ snprintf(name, sizeof(name), "lerp %s", set);
+ check(typeName<S>(), name, lerp, 0.0);
+ snprintf(name, sizeof(name), "lengthSquared %s", set);
+ check(typeName<S>(), name, lengthSquaredError, 0.0);
+}
+
+// The unit vector worked out in long double, whose range holds the square of
+// any float or double
+template <typename Vector>
+static long double unitComponent(const Vector &v, int k)
+{
+ long double squared = 0.0L;
+ for (int j = 0; j < componentCount(v); ++j) squared += (long double)component(v, j)*component(v, j);
+ return (squared == 0.0L) ? component(v, k) : component(v, k)/std::sqrt(squared);
+}
+
+// normalize: each component within 1e-6 of unitVector(), and of the true unit
+// vector at any finite magnitude
+template <typename S, typename Array>
+static void testNormalize(const Array &a, const char *set)
+{
+ typedef typename std::decay<decltype(a[0])>::type Vector;
+ Array unit;
+ normalizeVectorArray(a, unit);
+ double worst = 0.0;
+ for (std::size_t i = 0; i < a.size(); ++i)
+ {
+  const Vector expect = unitVector(a[i]);
+  for (int k = 0; k < componentCount(Vector()); ++k)
+  {
+   // unitVector() itself overflows for the shortest vectors
+   if (std::isfinite(component(expect, k))) worst = std::max(worst, error(component(unit[i], k), component(expect, k)));
+   worst = std::max(worst, error(component(unit[i], k), double(unitComponent(a[i], k))));
+  }
+ }
+ char name[64];
+ snprintf(name, sizeof(name), "normalize %s", set);
+ check(typeName<S>(), name, worst, 1e-6);
+}
+
+// dot and cross within a few roundings of the products, in case the scalar
+// version is contracted into FMA; length bit-identical to length(); angle
+// within 1e-6 rad. These are only documented for vectors whose squares don't
+// overflow.
+template <typename S, typename Array>
+static void testOrdinary(const Array &a, const Array &b, const char *set)
+{
+ const double epsilon = std::numeric_limits<S>::epsilon();
+ BasicScalarArray<S> dots, lengths, angles;
+ dotVectorArrays(a, b, dots);
+ lengthVectorArray(a, lengths);
+ angleBetweenVectorArrays(a, b, angles);
+ double dot = 0.0, lengthError = 0.0, angle = 0.0;
+ for (std::size_t i = 0; i < a.size(); ++i)
+ {
+  dot = std::max(dot, error(dots[i], a[i]*b[i])/(4.0*epsilon*double(length(a[i]))*double(length(b[i]))));
+  lengthError = std::max(lengthError, differs(lengths[i], length(a[i])));
+  angle = std::max(angle, error(angles[i], angleBetweenVectors(a[i], b[i])));
+ }
+ char name[64];
+ snprintf(name, sizeof(name), "dot %s (in 4 roundings)", set);
+ check(typeName<S>(), name, dot, 1.0);
+ snprintf(name, sizeof(name), "length %s", set);
+ check(typeName<S>(), name, lengthError, 0.0);
+ snprintf(name, sizeof(name), "angleBetween %s", set);
+ check(typeName<S>(), name, angle, 1e-6);
+}
+
+template <typename S>
+static void testCross(const BasicTVectorArray<S> &a, const BasicTVectorArray<S> &b)
+{
+ const double epsilon = std::numeric_limits<S>::epsilon();
+ BasicTVectorArray<S> cross;
+ crossVectorArrays(a, b, cross);
+ double worst = 0.0;
+ for (std::size_t i = 0; i < a.size(); ++i)
+ {
+  const BasicTVector<S> expect = a[i]/b[i];
+  const double bound = 4.0*epsilon*double(length(a[i]))*double(length(b[i]));
+  worst = std::max(worst, std::max(error(cross.xEast[i], expect.xEast), std::max(error(cross.yNorth[i], expect.yNorth), error(cross.zUp[i], expect.zUp)))/bound);
+ }
+ check(typeName<S>(), "cross TVector (in 4 roundings)", worst, 1.0);
+}
+
+template <typename S>
+static void testPrecision()
+{
+ srand(1);
+ const BasicTVectorArray<S> a = ordinaryVectors<S>(), b = ordinaryVectors<S>();
+ const BasicTVectorArray<S> extremeA = extremeVectors<S>(), extremeB = extremeVectors<S>();
+ const BasicPVectorArray<S> pa = planeVectors(a), pb = planeVectors(b);
+ const BasicPVectorArray<S> extremePA = planeVectors(extremeA), extremePB = planeVectors(extremeB);
+
+ testExact<S>(a, b, "TVector");
+ testExact<S>(pa, pb, "PVector");
+ testExact<S>(extremeA, extremeB, "TVector extreme");
+ testExact<S>(extremePA, extremePB, "PVector extreme");
+ testNormalize<S>(a, "TVector");
+ testNormalize<S>(pa, "PVector");
+ testNormalize<S>(extremeA, "TVector extreme");
+ testNormalize<S>(extremePA, "PVector extreme");
+ testOrdinary<S>(a, b, "TVector");
+ testOrdinary<S>(pa, pb, "PVector");
+ testCross(a, b);
+}
+
+int main()
+{
+ testPrecision<float>();
+ testPrecision<double>();
+ if (failures) printf("%d failed\n", failures);
+ return failures ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+/******************************************************************************
+*
+*     PTVectorIntersectionTest.cpp
+*     Copywright (C) 2018 Adam Jackson
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+// Checks that the batch intersection tests agree with the scalar ones, hit
+// for hit, on rays and segments laid out on a grid so that many of them
+// graze edges, corners and faces, or lie in the plane of one.
+//
+// Build and run from the repository root:
+//  g++ -std=c++11 -O2 -I. -o intersectiontest tests/PTVectorIntersectionTest.cpp
+//      PTVectorIntersection.cpp PTVectors.cpp PTVectorArrays.cpp
+//      PTVectorReductions.cpp PTVectorThreadPool.cpp -pthread
+//  ./intersectiontest
+// and again with -mavx (or -march=native) to check the AVX kernels. It prints
+// the number of disagreements for each test and exits with 1 if there are any.
+
+#include "PTVectorIntersection.h"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+static int failures = 0;
+
+static void check(const char *type, const char *name, std::size_t count, std::size_t disagreements)
+{
+ const bool ok = disagreements == 0;
+ printf("%s %-8s %-24s %zu cases, %zu disagreements\n", ok ? "ok  " : "FAIL", type, name, count, disagreements);
+ if (!ok) ++failures;
+}
+
+template <typename S>
+static const char *typeName()
+{
+ return (sizeof(S) == sizeof(float)) ? "float" : "double";
+}
+
+// Whether the scalar result, hit with distance expect or a miss, matches the
+// batch one, which is infinite for a miss. Hits may differ by a few roundings.
+template <typename S>
+static bool agrees(bool hit, S expect, S t)
+{
+ if (!hit) return t == std::numeric_limits<S>::infinity();
+ return std::fabs(t - expect) <= 16*std::numeric_limits<S>::epsilon()*std::max(S(1), std::fabs(expect));
+}
+
+// Every point of a grid with half unit steps from -1 to 2 on each axis,
+// around the unit cube
+template <typename S>
+static std::vector<BasicTVector<S> > gridPoints()
+{
+ std::vector<BasicTVector<S> > points;
+ for (int x = -2; x <= 4; ++x)
+  for (int y = -2; y <= 4; ++y)
+   for (int z = -2; z <= 4; ++z)
+    points.push_back({S(x)/2, S(y)/2, S(z)/2});
+ return points;
+}
+
+// Directions along the axes, the face diagonals and the body diagonals, and zero
+template <typename S>
+static std::vector<BasicTVector<S> > gridDirections()
+{
+ std::vector<BasicTVector<S> > directions;
+ for (int x = -1; x <= 1; ++x)
+  for (int y = -1; y <= 1; ++y)
+   for (int z = -1; z <= 1; ++z)
+    directions.push_back({S(x), S(y), S(z)});
+ return directions;
+}
+
+template <typename S>
+static void gridRays(BasicTVectorArray<S> &origins, BasicTVectorArray<S> &directions)
+{
+ const std::vector<BasicTVector<S> > points = gridPoints<S>(), steps = gridDirections<S>();
+ for (const BasicTVector<S> &p : points)
+  for (const BasicTVector<S> &d : steps)
+  {
+   origins.push_back(p);
+   directions.push_back(d);
+  }
+}
+
+template <typename S>
+static void testManyRays()
+{
+ BasicTVectorArray<S> origins, directions;
+ gridRays(origins, directions);
+ const std::size_t n = origins.size();
+ BasicScalarArray<S> t;
+ S expect;
+
+ const BasicBoundingSphere<S> sphere = {{S(0.5), S(0.5), S(0.5)}, S(0.5)};
+ intersectRaysSphere(origins, directions, sphere, t);
+ std::size_t wrong = 0;
+ for (std::size_t i = 0; i < n; ++i)
+ {
+  const bool hit = intersectRaySphere(BasicRay<S>{origins[i], directions[i]}, sphere, expect);
+  if (!agrees(hit, expect, t[i])) ++wrong;
+ }
+ check(typeName<S>(), "intersectRaysSphere", n, wrong);
+
+ const BasicBox<S> box = {{S(0), S(0), S(0)}, {S(1), S(1), S(1)}};
+ intersectRaysBox(origins, directions, box, t);
+ wrong = 0;
+ for (std::size_t i = 0; i < n; ++i)
+ {
+  const bool hit = intersectRayBox(BasicRay<S>{origins[i], directions[i]}, box, expect);
+  if (!agrees(hit, expect, t[i]) || std::isnan(t[i])) ++wrong;
+ }
+ check(typeName<S>(), "intersectRaysBox", n, wrong);
+
+ const BasicTVector<S> a = {S(0), S(0), S(0)}, b = {S(1), S(0), S(0)}, c = {S(0), S(1), S(0)};
+ intersectRaysTriangle(origins, directions, a, b, c, t);
+ wrong = 0;
+ for (std::size_t i = 0; i < n; ++i)
+ {
+  const bool hit = intersectRayTriangle(BasicRay<S>{origins[i], directions[i]}, a, b, c, expect);
+  if (!agrees(hit, expect, t[i])) ++wrong;
+ }
+ check(typeName<S>(), "intersectRaysTriangle", n, wrong);
+}
+
+// One ray against primitives placed around the grid, for each of a few rays
+template <typename S>
+static void testManyPrimitives()
+{
+ const std::vector<BasicTVector<S> > points = gridPoints<S>();
+ BasicTVectorArray<S> centres, mins, maxs, as, bs, cs;
+ BasicScalarArray<S> radii;
+ for (const BasicTVector<S> &p : points)
+ {
+  const BasicTVector<S> corner = {p.xEast + S(1), p.yNorth + S(0.5), p.zUp + S(1)};
+  centres.push_back(p);
+  radii.push_back(S(0.5));
+  mins.push_back(p);
+  maxs.push_back(corner);
+  as.push_back(p);
+  bs.push_back({p.xEast + S(1), p.yNorth, p.zUp});
+  cs.push_back({p.xEast, p.yNorth + S(1), p.zUp});
+ }
+ const std::size_t n = points.size();
+ const BasicRay<S> rays[] = {{{S(-1), S(0.5), S(0)}, {S(1), S(0), S(0)}},
+                             {{S(0), S(0), S(-1)}, {S(0), S(0), S(1)}},
+                             {{S(-1), S(-1), S(-1)}, {S(1), S(1), S(1)}},
+                             {{S(0.5), S(0.5), S(0.5)}, {S(0), S(1), S(0)}},
+                             {{S(0.25), S(0.5), S(2)}, {S(0), S(0), S(-1)}}};
+ std::size_t sphereWrong = 0, boxWrong = 0, triangleWrong = 0;
+ BasicScalarArray<S> t;
+ S expect;
+ for (const BasicRay<S> &ray : rays)
+ {
+  intersectRaySpheres(ray, centres, radii, t);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+   const bool hit = intersectRaySphere(ray, BasicBoundingSphere<S>{centres[i], radii[i]}, expect);
+   if (!agrees(hit, expect, t[i])) ++sphereWrong;
+  }
+  intersectRayBoxes(ray, mins, maxs, t);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+   const bool hit = intersectRayBox(ray, BasicBox<S>{mins[i], maxs[i]}, expect);
+   if (!agrees(hit, expect, t[i]) || std::isnan(t[i])) ++boxWrong;
+  }
+  intersectRayTriangles(ray, as, bs, cs, t);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+   const bool hit = intersectRayTriangle(ray, as[i], bs[i], cs[i], expect);
+   if (!agrees(hit, expect, t[i])) ++triangleWrong;
+  }
+ }
+ const std::size_t count = n*(sizeof(rays)/sizeof(rays[0]));
+ check(typeName<S>(), "intersectRaySpheres", count, sphereWrong);
+ check(typeName<S>(), "intersectRayBoxes", count, boxWrong);
+ check(typeName<S>(), "intersectRayTriangles", count, triangleWrong);
+}
+
+// Segments between points of a small grid in the plane, which include
+// parallel, collinear and end to end pairs
+template <typename S>
+static void testSegments()
+{
+ BasicPVectorArray<S> p0, p1;
+ for (int a = 0; a < 9; ++a)
+  for (int b = 0; b < 9; ++b)
+   if (a != b)
+   {
+    p0.push_back({S(a % 3), S(a/3)});
+    p1.push_back({S(b % 3), S(b/3)});
+   }
+ const std::size_t n = p0.size();
+ std::size_t firstWrong = 0, secondWrong = 0;
+ BasicScalarArray<S> s;
+ S expect, other;
+ for (std::size_t j = 0; j < n; ++j)
+ {
+  intersectSegments(p0[j], p1[j], p0, p1, s);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+   const bool hit = intersectSegments(p0[j], p1[j], p0[i], p1[i], expect, other);
+   if (!agrees(hit, expect, s[i])) ++firstWrong;
+  }
+  intersectSegments(p0, p1, p0[j], p1[j], s);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+   const bool hit = intersectSegments(p0[i], p1[i], p0[j], p1[j], expect, other);
+   if (!agrees(hit, expect, s[i])) ++secondWrong;
+  }
+ }
+ check(typeName<S>(), "intersectSegments, one", n*n, firstWrong);
+ check(typeName<S>(), "intersectSegments, many", n*n, secondWrong);
+}
+
+template <typename S>
+static void testPrecision()
+{
+ testManyRays<S>();
+ testManyPrimitives<S>();
+ testSegments<S>();
+}
+
+int main()
+{
+ testPrecision<float>();
+ testPrecision<double>();
+ if (failures) printf("%d failed\n", failures);
+ return failures ? 1 : 0;
+}